@@ -0,0 +1,203 @@
+#include "m6502_acia.h"
+
+#include <math.h>
+
+namespace
+{
+    // control register bits 0-3, 0 selects the external clock
+    constexpr double BAUD_RATES[16] = {
+        115200, 50, 75, 109.92, 134.58, 150, 300, 600,
+        1200, 1800, 2400, 3600, 4800, 7200, 9600, 19200
+    };
+}
+
+m6502::Acia6551::Acia6551(DeviceScheduler& Scheduler, DeviceMem& Memory, CPU& cpu, Word Base, u32 IrqSource,
+    u32 ClockHz)
+    : Scheduler(Scheduler), Memory(Memory), cpu(cpu), Base(Base), IrqSource(IrqSource), ClockHz(ClockHz),
+      TxAlarm(Scheduler, [this]() { Update(this->Scheduler.Now()); }),
+      RxAlarm(Scheduler, [this]() { Update(this->Scheduler.Now()); })
+{
+    Scheduler.Spawn(Bus());
+}
+
+m6502::u64 m6502::Acia6551::CharacterCycles(Byte Control, Byte Command, u32 ClockHz)
+{
+    const u32 DataBits = 8 - ((Control >> 5) & 3);
+    const u32 ParityBits = (Command & 0x20) ? 1 : 0;
+    const u32 StopBits = (Control & 0x80) ? 2 : 1;
+    const u32 FrameBits = 1 + DataBits + ParityBits + StopBits;
+    const u64 Cycles = llround(double(ClockHz) * FrameBits / BAUD_RATES[Control & 15]);
+    return Cycles > 0 ? Cycles : 1;
+}
+
+m6502::DeviceTask m6502::Acia6551::Bus()
+{
+    for (;;)
+    {
+        const BusAccess Access = co_await Scheduler.Access(Base, static_cast<Word>(Base + NUM_REGISTERS - 1));
+        const Byte Reg = static_cast<Byte>(Access.Address - Base);
+        if (Access.Kind == BusAccess::READ)
+        {
+            Memory[Access.Address] = Read(Reg);
+        }
+        else
+        {
+            Write(Reg, Access.Value);
+        }
+    }
+}
+
+void m6502::Acia6551::Receive(const Byte* Bytes, size_t Size)
+{
+    const u64 Cycle = Scheduler.Now();
+    Update(Cycle);
+    if (RxLine.empty() && Size != 0)
+    {
+        RxNext = Cycle + CharacterCycles();
+    }
+    RxLine.insert(RxLine.end(), Bytes, Bytes + Size);
+    Schedule();
+}
+
+void m6502::Acia6551::Update(u64 Cycle)
+{
+    while (TxBusy && TxDone <= Cycle)
+    {
+        if (OnTransmit)
+        {
+            OnTransmit(TxShift, TxDone);
+        }
+        TxBusy = TxDataFull;
+        if (TxDataFull)
+        {
+            TxShift = TxData;
+            TxDataFull = false;
+            TxDone += CharacterCycles();
+            if (TransmitIrqEnabled(Command))
+            {
+                Status |= IRQ;
+            }
+        }
+    }
+
+    while (!RxLine.empty() && RxNext <= Cycle)
+    {
+        if (Status & RDRF)
+        {
+            Status |= OVERRUN;
+        }
+        else
+        {
+            RxData = RxLine.front();
+            Status |= RDRF;
+        }
+        if (ReceiveIrqEnabled(Command))
+        {
+            Status |= IRQ;
+        }
+        RxLine.pop_front();
+        RxNext += CharacterCycles();
+    }
+    UpdateIrq();
+    Schedule();
+}
+
+void m6502::Acia6551::UpdateIrq()
+{
+    if (Status & IRQ)
+    {
+        cpu.Interrupts.RaiseIRQ(IrqSource);
+    }
+    else
+    {
+        cpu.Interrupts.ClearIRQ(IrqSource);
+    }
+}
+
+void m6502::Acia6551::Schedule()
+{
+    if (TxBusy)
+    {
+        TxAlarm.Set(TxDone);
+    }
+    else
+    {
+        TxAlarm.Cancel();
+    }
+
+    // a polled receiver catches up when status or data is read
+    if (!RxLine.empty() && ReceiveIrqEnabled(Command))
+    {
+        RxAlarm.Set(RxNext);
+    }
+    else
+    {
+        RxAlarm.Cancel();
+    }
+}
+
+m6502::Byte m6502::Acia6551::Read(Byte Reg)
+{
+    Update(Scheduler.Now());
+
+    Byte Value = 0;
+    switch (Reg & 3)
+    {
+    case DATA:
+        Status &= ~(RDRF | OVERRUN);
+        Value = RxData;
+        break;
+    case STATUS:
+        Value = Status | (TxDataFull ? 0 : TDRE);
+        Status &= ~IRQ;
+        UpdateIrq();
+        break;
+    case COMMAND:
+        Value = Command;
+        break;
+    default:
+        Value = Control;
+        break;
+    }
+    return Value;
+}
+
+void m6502::Acia6551::Write(Byte Reg, Byte Value)
+{
+    const u64 Cycle = Scheduler.Now();
+    Update(Cycle);
+
+    switch (Reg & 3)
+    {
+    case DATA:
+        if (!TxBusy)
+        {
+            TxShift = Value;
+            TxBusy = true;
+            TxDone = Cycle + CharacterCycles();
+            if (TransmitIrqEnabled(Command))
+            {
+                Status |= IRQ;
+            }
+        }
+        else
+        {
+            TxData = Value;
+            TxDataFull = true;
+        }
+        break;
+    case STATUS:
+        // programmed reset
+        Command &= 0xE0;
+        Status &= ~OVERRUN;
+        break;
+    case COMMAND:
+        Command = Value;
+        break;
+    default:
+        Control = Value;
+        break;
+    }
+    UpdateIrq();
+    Schedule();
+}
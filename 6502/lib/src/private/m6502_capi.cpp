@@ -0,0 +1,88 @@
+#include "m6502_capi.h"
+
+#include <new>
+
+#include "m6502.h"
+
+struct m6502_machine
+{
+    m6502::Mem mem;
+    m6502::CPU cpu;
+};
+
+uint32_t m6502_abi_version(void)
+{
+    return M6502_ABI_VERSION;
+}
+
+m6502_machine* m6502_create(void)
+{
+    m6502_machine* machine = new (std::nothrow) m6502_machine;
+    if (machine != nullptr)
+    {
+        machine->cpu.Reset(machine->mem);
+    }
+    return machine;
+}
+
+void m6502_destroy(m6502_machine* machine)
+{
+    delete machine;
+}
+
+void m6502_reset(m6502_machine* machine)
+{
+    machine->cpu.Reset(machine->mem);
+}
+
+int32_t m6502_execute(m6502_machine* machine, int32_t cycles)
+{
+    return machine->cpu.Execute(cycles, machine->mem);
+}
+
+void m6502_get_regs(const m6502_machine* machine, m6502_regs* regs)
+{
+    const m6502::CPU& cpu = machine->cpu;
+    regs->pc = cpu.PC;
+    regs->sp = cpu.SP;
+    regs->a = cpu.A;
+    regs->x = cpu.X;
+    regs->y = cpu.Y;
+    regs->ps = cpu.GetPS();
+}
+
+void m6502_set_regs(m6502_machine* machine, const m6502_regs* regs)
+{
+    m6502::CPU& cpu = machine->cpu;
+    cpu.PC = regs->pc;
+    cpu.SP = regs->sp;
+    cpu.A = regs->a;
+    cpu.X = regs->x;
+    cpu.Y = regs->y;
+    cpu.SetPS(regs->ps);
+}
+
+uint8_t* m6502_memory(m6502_machine* machine)
+{
+    return machine->mem.Data;
+}
+
+uint32_t m6502_memory_size(void)
+{
+    return m6502::Mem::MAX_MEM;
+}
+
+void m6502_raise_irq(m6502_machine* machine, uint32_t source_mask)
+{
+    machine->cpu.Interrupts.RaiseIRQ(source_mask);
+}
+
+void m6502_clear_irq(m6502_machine* machine, uint32_t source_mask)
+{
+    machine->cpu.Interrupts.ClearIRQ(source_mask);
+}
+
+void m6502_raise_nmi(m6502_machine* machine)
+{
+    machine->cpu.Interrupts.RaiseNMI();
+}
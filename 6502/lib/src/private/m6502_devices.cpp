@@ -0,0 +1,265 @@
+#include "m6502_devices.h"
+
+#include <algorithm>
+#include <exception>
+#include <limits.h>
+#include <new>
+#include <string.h>
+
+namespace
+{
+    bool WakesLater(const m6502::u64 LeftCycle, const m6502::u64 LeftSequence,
+        const m6502::u64 RightCycle, const m6502::u64 RightSequence)
+    {
+        return LeftCycle != RightCycle ? LeftCycle > RightCycle : LeftSequence > RightSequence;
+    }
+}
+
+m6502::FramePool::~FramePool()
+{
+    for (FreeFrame*& List : FreeLists)
+    {
+        while (List != nullptr)
+        {
+            FreeFrame* Next = List->Next;
+            ::operator delete(List);
+            List = Next;
+        }
+    }
+}
+
+m6502::FramePool& m6502::FramePool::ThisThread()
+{
+    static thread_local FramePool Pool;
+    return Pool;
+}
+
+void* m6502::FramePool::Allocate(size_t Size)
+{
+    const size_t Class = (Size + GRANULE - 1) / GRANULE - 1;
+    if (Class < NUM_CLASSES && FreeLists[Class] != nullptr)
+    {
+        FreeFrame* Frame = FreeLists[Class];
+        FreeLists[Class] = Frame->Next;
+        return Frame;
+    }
+    NumHeapAllocations++;
+    return ::operator new(Class < NUM_CLASSES ? (Class + 1) * GRANULE : Size);
+}
+
+void m6502::FramePool::Free(void* Frame, size_t Size)
+{
+    const size_t Class = (Size + GRANULE - 1) / GRANULE - 1;
+    if (Class >= NUM_CLASSES)
+    {
+        ::operator delete(Frame);
+        return;
+    }
+    FreeFrame* Freed = static_cast<FreeFrame*>(Frame);
+    Freed->Next = FreeLists[Class];
+    FreeLists[Class] = Freed;
+}
+
+void m6502::DeviceTask::promise_type::unhandled_exception()
+{
+    std::terminate();
+}
+
+m6502::DeviceMem::DeviceMem()
+{
+    memset(WatchBits, 0, sizeof(WatchBits));
+    Initialize();
+}
+
+void m6502::DeviceMem::Initialize()
+{
+    memset(Data, 0, sizeof(Data));
+}
+
+void m6502::DeviceMem::Notify(Word Address, Byte Value, BusAccess::AccessKind Kind) const
+{
+    if (Scheduler != nullptr)
+    {
+        Scheduler->OnAccess(Address, Value, Kind);
+    }
+}
+
+m6502::DeviceScheduler::DeviceScheduler(DeviceMem& Memory)
+    : Memory(Memory)
+{
+    Memory.Scheduler = this;
+    Timers.reserve(64);
+    Watches.reserve(64);
+}
+
+m6502::DeviceScheduler::~DeviceScheduler()
+{
+    Memory.Scheduler = nullptr;
+    Watches.clear();
+    UpdateWatchBits(0, DeviceMem::MAX_MEM - 1);
+}
+
+void m6502::DeviceScheduler::Spawn(DeviceTask Task)
+{
+    if (Task.Done())
+    {
+        return;
+    }
+
+    // devices that have finished give their frames back to the pool
+    std::erase_if(Devices, [](const DeviceTask& Device) { return Device.Done(); });
+    DeviceTask::Handle Frame = Task.Frame;
+    Devices.push_back(std::move(Task));
+    Frame.resume();
+}
+
+void m6502::DeviceScheduler::WakeAt(u64 WakeCycle, std::coroutine_handle<> Device)
+{
+    // a device woken by a bus access may want to run before the slice was going to end
+    if (WakeCycle - Cycle < static_cast<u64>(Memory.SliceLimit))
+    {
+        Memory.SliceLimit = static_cast<s32>(WakeCycle - Cycle);
+    }
+    Timers.push_back({ WakeCycle, NextSequence++, Device });
+    std::push_heap(Timers.begin(), Timers.end(), [](const Timer& Left, const Timer& Right)
+    {
+        return WakesLater(Left.Cycle, Left.Sequence, Right.Cycle, Right.Sequence);
+    });
+}
+
+void m6502::DeviceScheduler::Watch(Word First, Word Last, BusAccess::AccessKind Kind, std::coroutine_handle<> Device)
+{
+    Watches.push_back({ First, Last, Kind, NumAccesses, Device });
+    for (u32 Address = First; Address <= Last; Address++)
+    {
+        Memory.WatchBits[Address >> 5] |= 1u << (Address & 31);
+    }
+}
+
+void m6502::DeviceScheduler::UpdateWatchBits(u32 First, u32 Last)
+{
+    for (u32 Address = First; Address <= Last; Address++)
+    {
+        Memory.WatchBits[Address >> 5] &= ~(1u << (Address & 31));
+    }
+    for (const WatchEntry& Entry : Watches)
+    {
+        const u32 From = Entry.First > First ? Entry.First : First;
+        const u32 To = Entry.Last < Last ? Entry.Last : Last;
+        for (u32 Address = From; Address <= To; Address++)
+        {
+            Memory.WatchBits[Address >> 5] |= 1u << (Address & 31);
+        }
+    }
+}
+
+void m6502::DeviceScheduler::OnAccess(Word Address, Byte Value, BusAccess::AccessKind Kind)
+{
+    const u64 ThisAccess = NumAccesses++;
+    u32 WokenFirst = DeviceMem::MAX_MEM;
+    u32 WokenLast = 0;
+
+    // a woken device usually waits again straight away, that entry belongs to the next access
+    for (size_t i = 0; i < Watches.size();)
+    {
+        const WatchEntry Entry = Watches[i];
+        if (Entry.Since > ThisAccess || (Entry.Kind & Kind) == 0 || Address < Entry.First || Address > Entry.Last)
+        {
+            i++;
+            continue;
+        }
+        Watches.erase(Watches.begin() + i);
+        LastAccess = { Address, Value, Kind };
+        WokenFirst = Entry.First < WokenFirst ? Entry.First : WokenFirst;
+        WokenLast = Entry.Last > WokenLast ? Entry.Last : WokenLast;
+        Entry.Device.resume();
+        i = 0;
+    }
+    // only the ranges of the woken devices can have lost their last watch
+    if (WokenFirst <= WokenLast)
+    {
+        UpdateWatchBits(WokenFirst, WokenLast);
+    }
+}
+
+void m6502::DeviceScheduler::ResumeDueTimers()
+{
+    while (!Timers.empty() && Timers.front().Cycle <= Cycle)
+    {
+        std::pop_heap(Timers.begin(), Timers.end(), [](const Timer& Left, const Timer& Right)
+        {
+            return WakesLater(Left.Cycle, Left.Sequence, Right.Cycle, Right.Sequence);
+        });
+        const std::coroutine_handle<> Device = Timers.back().Device;
+        Timers.pop_back();
+        Device.resume();
+    }
+}
+
+template<typename TVariant>
+m6502::u64 m6502::DeviceScheduler::Run(CPU& cpu, u64 Cycles)
+{
+    const u64 Target = Cycle + Cycles;
+    while (Cycle < Target)
+    {
+        ResumeDueTimers();
+
+        // run the cpu up to the next device that wants to wake
+        u64 Stop = Target;
+        if (!Timers.empty() && Timers.front().Cycle < Stop)
+        {
+            Stop = Timers.front().Cycle;
+        }
+        const u64 Slice = Stop - Cycle < static_cast<u64>(INT_MAX) ? Stop - Cycle : INT_MAX;
+        Memory.SliceLimit = static_cast<s32>(Slice);
+        Cycle += cpu.Execute<TVariant>(static_cast<s32>(Slice), Memory);
+        Memory.SliceElapsed = 0;
+        Memory.SliceLimit = INT_MAX;
+    }
+    ResumeDueTimers();
+    return Cycles + (Cycle - Target);
+}
+
+m6502::DeviceAlarm::DeviceAlarm(DeviceScheduler& Scheduler, std::function<void()> Callback)
+    : Scheduler(Scheduler), Callback(std::move(Callback))
+{
+}
+
+void m6502::DeviceAlarm::Set(u64 WakeCycle)
+{
+    Cycle = WakeCycle;
+    Armed = true;
+    if (Waiting && SleepingUntil <= WakeCycle)
+    {
+        return;
+    }
+    Generation++;
+    Scheduler.Spawn(Wait(*this, Generation));
+}
+
+m6502::DeviceTask m6502::DeviceAlarm::Wait(DeviceAlarm& Alarm, u64 Generation)
+{
+    Alarm.Waiting = true;
+    Alarm.SleepingUntil = 0;    // a Set from the callback keeps this task
+    while (Alarm.Generation == Generation && Alarm.Armed)
+    {
+        const u64 Now = Alarm.Scheduler.Now();
+        if (Now >= Alarm.Cycle)
+        {
+            Alarm.Armed = false;
+            Alarm.SleepingUntil = 0;
+            Alarm.Callback();
+            continue;
+        }
+        Alarm.SleepingUntil = Alarm.Cycle;
+        co_await Alarm.Scheduler.Delay(Alarm.Cycle - Now);
+    }
+    if (Alarm.Generation == Generation)
+    {
+        Alarm.Waiting = false;
+    }
+}
+
+template m6502::u64 m6502::DeviceScheduler::Run<m6502::NMOS6502>(CPU& cpu, u64 Cycles);
+template m6502::u64 m6502::DeviceScheduler::Run<m6502::CMOS65C02>(CPU& cpu, u64 Cycles);
+template m6502::u64 m6502::DeviceScheduler::Run<m6502::Ricoh2A03>(CPU& cpu, u64 Cycles);
@@ -0,0 +1,69 @@
+#include "m6502_dirtymem.h"
+
+#include <bit>
+#include <string.h>
+
+m6502::DirtyMem::DirtyMem(u32 RegionSize)
+{
+    RegionShift = static_cast<u32>(std::countr_zero(MIN_REGION_SIZE));
+    while ((1u << RegionShift) < MAX_REGION_SIZE && (1u << RegionShift) < RegionSize)
+    {
+        RegionShift++;
+    }
+    if ((1u << RegionShift) != RegionSize)
+    {
+        printf("dirty region size %u is not supported, using %u\n", RegionSize, 1u << RegionShift);
+    }
+    NumWords = (MAX_MEM >> RegionShift) / 64;
+    Initialize();
+}
+
+void m6502::DirtyMem::Initialize()
+{
+    memset(Data, 0, sizeof(Data));
+    memset(Dirty, 0, sizeof(Dirty));
+    memset(Dirty, 0xFF, NumWords * sizeof(u64));
+}
+
+bool m6502::DirtyMem::AnyDirty() const
+{
+    for (u32 i = 0; i < NumWords; i++)
+    {
+        if (Dirty[i] != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void m6502::DirtyMem::DirtyRanges(std::vector<DirtyRange>& Ranges) const
+{
+    Ranges.clear();
+    for (u32 i = 0; i < NumWords; i++)
+    {
+        u64 Bits = Dirty[i];
+        while (Bits != 0)
+        {
+            const u32 First = static_cast<u32>(std::countr_zero(Bits));
+            const u32 Count = static_cast<u32>(std::countr_one(Bits >> First));
+            Bits = Count + First < 64 ? Bits & (~0ull << (First + Count)) : 0;
+
+            const u32 Start = (i * 64 + First) << RegionShift;
+            const u32 End = (i * 64 + First + Count) << RegionShift;
+            if (!Ranges.empty() && Ranges.back().End == Start)
+            {
+                Ranges.back().End = End;
+            }
+            else
+            {
+                Ranges.push_back({ static_cast<Word>(Start), End });
+            }
+        }
+    }
+}
+
+void m6502::DirtyMem::ClearDirty()
+{
+    memset(Dirty, 0, NumWords * sizeof(u64));
+}
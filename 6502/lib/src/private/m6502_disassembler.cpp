@@ -0,0 +1,601 @@
+#include "m6502_disassembler.h"
+
+#include <atomic>
+#include <set>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+namespace
+{
+    constexpr char ANALYSIS_MAGIC[8] = { 'M', '6', '5', '0', '2', 'C', 'F', '1' };
+
+    void PutVarint(std::vector<m6502::Byte>& Out, m6502::u64 Value)
+    {
+        while (Value >= 0x80)
+        {
+            Out.push_back(static_cast<m6502::Byte>(Value | 0x80));
+            Value >>= 7;
+        }
+        Out.push_back(static_cast<m6502::Byte>(Value));
+    }
+
+    bool GetVarint(const std::vector<m6502::Byte>& In, size_t& At, m6502::u64& Value)
+    {
+        Value = 0;
+        for (m6502::u32 Shift = 0; Shift < 64 && At < In.size(); Shift += 7)
+        {
+            const m6502::Byte Next = In[At++];
+            Value |= static_cast<m6502::u64>(Next & 0x7F) << Shift;
+            if ((Next & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // an address list as a count and ascending deltas
+    void PutAddresses(std::vector<m6502::Byte>& Out, const std::vector<m6502::Word>& Addresses)
+    {
+        PutVarint(Out, Addresses.size());
+        m6502::Word Last = 0;
+        for (m6502::Word Address : Addresses)
+        {
+            PutVarint(Out, static_cast<m6502::Word>(Address - Last));
+            Last = Address;
+        }
+    }
+
+    bool GetAddresses(const std::vector<m6502::Byte>& In, size_t& At, std::vector<m6502::Word>& Addresses)
+    {
+        m6502::u64 Count;
+        if (!GetVarint(In, At, Count) || Count > 0x10000)
+        {
+            return false;
+        }
+        Addresses.resize(Count);
+        m6502::Word Last = 0;
+        for (m6502::Word& Address : Addresses)
+        {
+            m6502::u64 Delta;
+            if (!GetVarint(In, At, Delta))
+            {
+                return false;
+            }
+            Address = Last = static_cast<m6502::Word>(Last + Delta);
+        }
+        return true;
+    }
+
+    // the instruction ends its block and nothing follows it statically
+    bool EndsFlow(m6502::Byte Instruction)
+    {
+        using m6502::CPU;
+        return Instruction == CPU::INS_JMP_ABS || Instruction == CPU::INS_JMP_IND
+            || Instruction == CPU::INS_RTS || Instruction == CPU::INS_RTI || Instruction == CPU::INS_BRK;
+    }
+
+    struct Tracer
+    {
+        Tracer(const std::vector<m6502::Byte>& Image, m6502::Word Origin)
+            : Image(Image), Origin(Origin), Size(0x10000, 0), Leader(0x10000, false)
+        {
+        }
+
+        bool InImage(m6502::u32 Address) const
+        {
+            return Address >= Origin && Address < 0x10000 && Address - Origin < Image.size();
+        }
+
+        m6502::Byte ByteAt(m6502::Word Address) const
+        {
+            return Image[Address - Origin];
+        }
+
+        m6502::Word OperandAt(m6502::Word Address) const
+        {
+            return ByteAt(Address + 1) | (ByteAt(Address + 2) << 8);
+        }
+
+        // follow one routine through fall through and JMP, queueing the routines it calls
+        void TraceRoutine(m6502::Word Routine, std::vector<m6502::Word>& NewRoutines);
+
+        void BuildBlocks(m6502::ImageAnalysis& Analysis) const;
+
+        const std::vector<m6502::Byte>& Image;
+        const m6502::Word Origin;
+        std::vector<m6502::Byte> Size;      // of the instruction starting at each address, 0 if not traced
+        std::vector<bool> Leader;
+        std::set<m6502::Word> Routines;
+        std::set<std::pair<m6502::Word, m6502::Word>> Calls;
+    };
+
+    void Tracer::TraceRoutine(m6502::Word Routine, std::vector<m6502::Word>& NewRoutines)
+    {
+        using namespace m6502;
+        std::vector<Word> Work = { Routine };
+        while (!Work.empty())
+        {
+            const Word Entry = Work.back();
+            Work.pop_back();
+
+            u32 Address = Entry;
+            while (InImage(Address))
+            {
+                if (Size[Address] != 0)
+                {
+                    // ran into code traced earlier, that instruction starts a block too
+                    Leader[Address] = true;
+                    break;
+                }
+
+                const Byte Instruction = ByteAt(Address);
+                const OpcodeInfo Op = DecodeOpcode(Instruction);
+                const u32 Length = 1 + OperandSize(Op.Mode);
+                if (Op.Mode == AddressMode::Unknown || !InImage(Address + Length - 1))
+                {
+                    break;
+                }
+                Size[Address] = static_cast<Byte>(Length);
+
+                const u32 Next = Address + Length;
+                if (Instruction == CPU::INS_JSR)
+                {
+                    const Word Target = OperandAt(Address);
+                    Calls.insert({ Routine, Target });
+                    if (Routines.insert(Target).second)
+                    {
+                        NewRoutines.push_back(Target);
+                    }
+                    if (Next < 0x10000)
+                    {
+                        Leader[Next] = true;
+                    }
+                }
+                else if (Instruction == CPU::INS_JMP_ABS)
+                {
+                    Work.push_back(OperandAt(Address));
+                }
+                if (EndsFlow(Instruction))
+                {
+                    break;
+                }
+                Address = Next;
+            }
+
+            if (Size[Entry] != 0)
+            {
+                Leader[Entry] = true;
+            }
+        }
+    }
+
+    void Tracer::BuildBlocks(m6502::ImageAnalysis& Analysis) const
+    {
+        using namespace m6502;
+        BasicBlock* Current = nullptr;
+        for (u32 Address = 0; Address < 0x10000; Address++)
+        {
+            if (Size[Address] == 0)
+            {
+                continue;
+            }
+            Analysis.Instructions.push_back(static_cast<Word>(Address));
+
+            if (Current == nullptr || Leader[Address] || Current->End != Address)
+            {
+                Analysis.Blocks.emplace_back();
+                Current = &Analysis.Blocks.back();
+                Current->Start = static_cast<Word>(Address);
+            }
+            const u32 Next = Address + Size[Address];
+            Current->End = Next;
+
+            const Byte Instruction = ByteAt(static_cast<Word>(Address));
+            const bool NextTraced = Next < 0x10000 && Size[Next] != 0;
+            if (Instruction == CPU::INS_JMP_ABS)
+            {
+                const Word Target = OperandAt(static_cast<Word>(Address));
+                if (Size[Target] != 0)
+                {
+                    Current->Successors.push_back(Target);
+                }
+                Current = nullptr;
+            }
+            else if (EndsFlow(Instruction))
+            {
+                Current = nullptr;
+            }
+            else if (Instruction == CPU::INS_JSR || !NextTraced || Leader[Next])
+            {
+                if (NextTraced)
+                {
+                    Current->Successors.push_back(static_cast<Word>(Next));
+                }
+                Current = nullptr;
+            }
+        }
+    }
+}
+
+bool m6502::ReadImageFile(const char* Path, bool Hex, std::vector<Byte>& Image)
+{
+    FILE* File = fopen(Path, Hex ? "r" : "rb");
+    if (File == nullptr)
+    {
+        printf("cannot open %s\n", Path);
+        return false;
+    }
+
+    int Char;
+    if (!Hex)
+    {
+        while ((Char = fgetc(File)) != EOF)
+        {
+            Image.push_back(static_cast<Byte>(Char));
+        }
+    }
+    else
+    {
+        char Token[16];
+        int Length = 0;
+        bool Comment = false;
+        bool Ok = true;
+        do
+        {
+            Char = fgetc(File);
+            const bool Separator = Char == EOF || Char == ' ' || Char == '\t' || Char == '\r' || Char == '\n';
+            if (Char == ';')
+            {
+                Comment = true;
+            }
+            if (!Comment && !Separator && Length < static_cast<int>(sizeof(Token)) - 1)
+            {
+                Token[Length++] = static_cast<char>(Char);
+            }
+            if (Separator && Length > 0)
+            {
+                Token[Length] = 0;
+                char* End;
+                const unsigned long Value = strtoul(Token, &End, 16);
+                if (*End != 0 || Value > 0xFF)
+                {
+                    printf("bad hex byte '%s' in %s\n", Token, Path);
+                    Ok = false;
+                }
+                Image.push_back(static_cast<Byte>(Value));
+                Length = 0;
+            }
+            if (Char == '\n')
+            {
+                Comment = false;
+            }
+        } while (Char != EOF && Ok);
+
+        if (!Ok)
+        {
+            fclose(File);
+            return false;
+        }
+    }
+    fclose(File);
+
+    if (Image.empty() || Image.size() > 0x10000)
+    {
+        printf("%s is empty or larger than 64KB\n", Path);
+        return false;
+    }
+    return true;
+}
+
+std::string m6502::FormatInstruction(Byte Instruction, Word Operand)
+{
+    const OpcodeInfo Op = DecodeOpcode(Instruction);
+    char Text[32];
+    switch (Op.Mode)
+    {
+    case AddressMode::Immediate: snprintf(Text, sizeof(Text), "%s #$%02X", Op.Mnemonic, Operand & 0xFF); break;
+    case AddressMode::ZeroPage: snprintf(Text, sizeof(Text), "%s $%02X", Op.Mnemonic, Operand & 0xFF); break;
+    case AddressMode::ZeroPageX: snprintf(Text, sizeof(Text), "%s $%02X,X", Op.Mnemonic, Operand & 0xFF); break;
+    case AddressMode::ZeroPageY: snprintf(Text, sizeof(Text), "%s $%02X,Y", Op.Mnemonic, Operand & 0xFF); break;
+    case AddressMode::Absolute: snprintf(Text, sizeof(Text), "%s $%04X", Op.Mnemonic, Operand); break;
+    case AddressMode::AbsoluteX: snprintf(Text, sizeof(Text), "%s $%04X,X", Op.Mnemonic, Operand); break;
+    case AddressMode::AbsoluteY: snprintf(Text, sizeof(Text), "%s $%04X,Y", Op.Mnemonic, Operand); break;
+    case AddressMode::IndirectX: snprintf(Text, sizeof(Text), "%s ($%02X,X)", Op.Mnemonic, Operand & 0xFF); break;
+    case AddressMode::IndirectY: snprintf(Text, sizeof(Text), "%s ($%02X),Y", Op.Mnemonic, Operand & 0xFF); break;
+    case AddressMode::Indirect: snprintf(Text, sizeof(Text), "%s ($%04X)", Op.Mnemonic, Operand); break;
+    default: snprintf(Text, sizeof(Text), "%s", Op.Mnemonic); break;
+    }
+    return Text;
+}
+
+std::vector<m6502::Byte> m6502::ImageAnalysis::Encode() const
+{
+    std::vector<Byte> Out(ANALYSIS_MAGIC, ANALYSIS_MAGIC + sizeof(ANALYSIS_MAGIC));
+    for (u32 i = 0; i < 8; i++)
+    {
+        Out.push_back(static_cast<Byte>(Key >> (i * 8)));
+    }
+    PutAddresses(Out, Instructions);
+
+    PutVarint(Out, Blocks.size());
+    Word Last = 0;
+    for (const BasicBlock& Block : Blocks)
+    {
+        PutVarint(Out, static_cast<Word>(Block.Start - Last));
+        PutVarint(Out, Block.End - Block.Start);
+        PutAddresses(Out, Block.Successors);
+        Last = Block.Start;
+    }
+
+    PutAddresses(Out, Routines);
+    PutVarint(Out, Calls.size());
+    for (const std::pair<Word, Word>& Call : Calls)
+    {
+        PutVarint(Out, Call.first);
+        PutVarint(Out, Call.second);
+    }
+    return Out;
+}
+
+bool m6502::ImageAnalysis::Decode(const std::vector<Byte>& Encoded)
+{
+    *this = ImageAnalysis();
+    const size_t Header = sizeof(ANALYSIS_MAGIC) + 8;
+    if (Encoded.size() < Header || memcmp(Encoded.data(), ANALYSIS_MAGIC, sizeof(ANALYSIS_MAGIC)) != 0)
+    {
+        return false;
+    }
+    for (u32 i = 0; i < 8; i++)
+    {
+        Key |= static_cast<u64>(Encoded[sizeof(ANALYSIS_MAGIC) + i]) << (i * 8);
+    }
+
+    size_t At = Header;
+    u64 Count;
+    if (!GetAddresses(Encoded, At, Instructions) || !GetVarint(Encoded, At, Count) || Count > 0x10000)
+    {
+        return false;
+    }
+    Blocks.resize(Count);
+    Word Last = 0;
+    for (BasicBlock& Block : Blocks)
+    {
+        u64 Delta, Length;
+        if (!GetVarint(Encoded, At, Delta) || !GetVarint(Encoded, At, Length)
+            || !GetAddresses(Encoded, At, Block.Successors))
+        {
+            return false;
+        }
+        Block.Start = Last = static_cast<Word>(Last + Delta);
+        Block.End = static_cast<u32>(Block.Start + Length);
+    }
+
+    if (!GetAddresses(Encoded, At, Routines) || !GetVarint(Encoded, At, Count) || Count > Encoded.size())
+    {
+        return false;
+    }
+    Calls.resize(Count);
+    for (std::pair<Word, Word>& Call : Calls)
+    {
+        u64 Caller, Callee;
+        if (!GetVarint(Encoded, At, Caller) || !GetVarint(Encoded, At, Callee))
+        {
+            return false;
+        }
+        Call = { static_cast<Word>(Caller), static_cast<Word>(Callee) };
+    }
+    return At == Encoded.size();
+}
+
+m6502::AnalysisCache::AnalysisCache(const std::string& Directory)
+    : Directory(Directory)
+{
+}
+
+std::string m6502::AnalysisCache::PathOf(u64 Key) const
+{
+    char Name[32];
+    snprintf(Name, sizeof(Name), "%016llx.cfg", Key);
+    return Directory + "/" + Name;
+}
+
+bool m6502::AnalysisCache::Load(u64 Key, ImageAnalysis& Analysis) const
+{
+    FILE* File = fopen(PathOf(Key).c_str(), "rb");
+    if (File == nullptr)
+    {
+        return false;
+    }
+    std::vector<Byte> Encoded;
+    Byte Buffer[4096];
+    size_t Read;
+    while ((Read = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+    {
+        Encoded.insert(Encoded.end(), Buffer, Buffer + Read);
+    }
+    fclose(File);
+
+    // a damaged or foreign file is a miss
+    return Analysis.Decode(Encoded) && Analysis.Key == Key;
+}
+
+bool m6502::AnalysisCache::Store(const ImageAnalysis& Analysis) const
+{
+    const std::string Path = PathOf(Analysis.Key);
+    const std::string Temporary = Path + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    FILE* File = fopen(Temporary.c_str(), "wb");
+    if (File == nullptr)
+    {
+        printf("cannot write %s\n", Temporary.c_str());
+        return false;
+    }
+    const std::vector<Byte> Encoded = Analysis.Encode();
+    const bool Written = fwrite(Encoded.data(), 1, Encoded.size(), File) == Encoded.size();
+    if (fclose(File) != 0 || !Written || rename(Temporary.c_str(), Path.c_str()) != 0)
+    {
+        printf("cannot write %s\n", Path.c_str());
+        remove(Temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+m6502::u64 m6502::Disassembler::ImageKey(const std::vector<Byte>& Image, const DisassemblerOptions& Options)
+{
+    // FNV-1a over the analyzer version, the image, then the options
+    u64 Hash = 0xCBF29CE484222325ull;
+    auto Add = [&Hash](Byte Value)
+    {
+        Hash = (Hash ^ Value) * 0x100000001B3ull;
+    };
+    for (u32 i = 0; i < 4; i++)
+    {
+        Add(static_cast<Byte>(ANALYZER_VERSION >> (i * 8)));
+    }
+    for (Byte Value : Image)
+    {
+        Add(Value);
+    }
+    const u64 Size = Image.size();
+    for (u32 i = 0; i < 8; i++)
+    {
+        Add(static_cast<Byte>(Size >> (i * 8)));
+    }
+    Add(static_cast<Byte>(Options.Origin));
+    Add(static_cast<Byte>(Options.Origin >> 8));
+    Add(Options.FollowVectors ? 1 : 0);
+    for (Word Entry : Options.Entries)
+    {
+        Add(static_cast<Byte>(Entry));
+        Add(static_cast<Byte>(Entry >> 8));
+    }
+    return Hash;
+}
+
+bool m6502::Disassembler::Fits(const std::vector<Byte>& Image, Word Origin)
+{
+    return Origin + Image.size() <= 0x10000;
+}
+
+m6502::ImageAnalysis m6502::Disassembler::Analyze(const std::vector<Byte>& Image, const DisassemblerOptions& Options)
+{
+    ImageAnalysis Analysis;
+    Analysis.Key = ImageKey(Image, Options);
+    if (!Fits(Image, Options.Origin))
+    {
+        printf("an image of %zu bytes at $%04X runs past $FFFF\n", Image.size(), Options.Origin);
+        return Analysis;
+    }
+
+    Tracer Trace(Image, Options.Origin);
+    std::vector<Word> Work;
+    auto AddRoutine = [&Trace, &Work](Word Entry)
+    {
+        if (Trace.Routines.insert(Entry).second)
+        {
+            Work.push_back(Entry);
+        }
+    };
+    for (Word Entry : Options.Entries)
+    {
+        AddRoutine(Entry);
+    }
+    if (Options.FollowVectors)
+    {
+        for (Word Vector : { CPU::NMI_VECTOR, CPU::RESET_VECTOR, CPU::IRQ_VECTOR })
+        {
+            if (Trace.InImage(Vector) && Trace.InImage(Vector + 1))
+            {
+                AddRoutine(Trace.ByteAt(Vector) | (Trace.ByteAt(Vector + 1) << 8));
+            }
+        }
+    }
+    while (!Work.empty())
+    {
+        const Word Routine = Work.back();
+        Work.pop_back();
+        Trace.TraceRoutine(Routine, Work);
+    }
+
+    Trace.BuildBlocks(Analysis);
+    Analysis.Routines.assign(Trace.Routines.begin(), Trace.Routines.end());
+    Analysis.Calls.assign(Trace.Calls.begin(), Trace.Calls.end());
+    return Analysis;
+}
+
+std::string m6502::Disassembler::Listing(const std::vector<Byte>& Image, const DisassemblerOptions& Options,
+    const ImageAnalysis& Analysis)
+{
+    auto ByteAt = [&Image, &Options](u32 Address)
+    {
+        return Image[static_cast<Word>(Address - Options.Origin)];
+    };
+    const std::set<Word> Routines(Analysis.Routines.begin(), Analysis.Routines.end());
+    std::string Out;
+    char Line[96];
+    for (const BasicBlock& Block : Analysis.Blocks)
+    {
+        snprintf(Line, sizeof(Line), Routines.count(Block.Start) ? "\n; routine $%04X\n" : "\n; block $%04X\n", Block.Start);
+        Out += Line;
+
+        u32 Address = Block.Start;
+        while (Address < Block.End)
+        {
+            const Byte Instruction = ByteAt(Address);
+            const u32 Length = 1 + OperandSize(DecodeOpcode(Instruction).Mode);
+            char Hex[12] = {};
+            Word Operand = 0;
+            for (u32 i = 0; i < Length; i++)
+            {
+                const Byte Value = ByteAt(Address + i);
+                snprintf(Hex + i * 3, sizeof(Hex) - i * 3, "%02X ", Value);
+                if (i > 0)
+                {
+                    Operand |= Value << ((i - 1) * 8);
+                }
+            }
+            Hex[Length * 3 - 1] = 0;
+            snprintf(Line, sizeof(Line), "%04X  %-8s  %s\n", Address, Hex, FormatInstruction(Instruction, Operand).c_str());
+            Out += Line;
+            Address += Length;
+        }
+    }
+    return Out;
+}
+
+std::vector<m6502::ImageAnalysis> m6502::Disassembler::AnalyzeAll(const std::vector<std::vector<Byte>>& Images,
+    const DisassemblerOptions& Options, u32 NumThreads, const AnalysisCache* Cache)
+{
+    std::vector<ImageAnalysis> Results(Images.size());
+    std::atomic<size_t> Next{0};
+    auto Work = [&]()
+    {
+        for (size_t i = Next.fetch_add(1); i < Images.size(); i = Next.fetch_add(1))
+        {
+            if (Cache != nullptr && Cache->Load(ImageKey(Images[i], Options), Results[i]))
+            {
+                Results[i].FromCache = true;
+                continue;
+            }
+            Results[i] = Analyze(Images[i], Options);
+            if (Cache != nullptr)
+            {
+                Cache->Store(Results[i]);
+            }
+        }
+    };
+
+    std::vector<std::thread> Threads;
+    for (u32 i = 1; i < NumThreads && i < Images.size(); i++)
+    {
+        Threads.emplace_back(Work);
+    }
+    Work();
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+    return Results;
+}
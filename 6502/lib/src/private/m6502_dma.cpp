@@ -0,0 +1,92 @@
+#include "m6502_dma.h"
+
+#include <string.h>
+
+m6502::u32 m6502::CPU::ServiceDMA(const DmaBus& Bus)
+{
+    if (Dma == nullptr)
+    {
+        Interrupts.ClearDMA();
+        return 0;
+    }
+    return Dma->Service(Bus);
+}
+
+m6502::DmaController::DmaController(CPU& cpu, const DmaConfig& Config)
+    : Config(Config), cpu(cpu)
+{
+    cpu.Dma = this;
+}
+
+m6502::DmaController::~DmaController()
+{
+    if (cpu.Dma == this)
+    {
+        cpu.Dma = nullptr;
+        cpu.Interrupts.ClearDMA();
+    }
+}
+
+bool m6502::DmaController::Start(Word From, Word To, u32 Length)
+{
+    if (Busy() || Length == 0 || Length > Mem::MAX_MEM)
+    {
+        return false;
+    }
+    Source = From;
+    Destination = To;
+    Remaining = Length;
+    SetupDone = false;
+    cpu.Interrupts.RaiseDMA();
+    return true;
+}
+
+m6502::u32 m6502::DmaController::Service(const DmaBus& Bus)
+{
+    u32 Cycles = 0;
+    if (!SetupDone)
+    {
+        Cycles += Config.SetupCycles;
+        SetupDone = true;
+    }
+    const u32 Bytes = Config.BurstBytes != 0 && Config.BurstBytes < Remaining ? Config.BurstBytes : Remaining;
+    Copy(Bus, Source, Destination, Bytes);
+    Source = static_cast<Word>(Source + Bytes);
+    Destination = static_cast<Word>(Destination + Bytes);
+    Remaining -= Bytes;
+    Cycles += Bytes * Config.CyclesPerByte;
+    if (Remaining == 0)
+    {
+        cpu.Interrupts.ClearDMA();
+    }
+    TotalCycles += Cycles;
+    TotalBytes += Bytes;
+    return Cycles;
+}
+
+void m6502::DmaController::Copy(const DmaBus& Bus, Word From, Word To, u32 Length)
+{
+    // the controller reads and writes one byte at a time going up, so a destination
+    // just above the source repeats the first bytes instead of moving the block
+    const u32 Ahead = static_cast<Word>(To - From);
+    if (Bus.Flat == nullptr || (Ahead != 0 && Ahead < Length))
+    {
+        for (u32 i = 0; i < Length; i++)
+        {
+            Bus.Write(Bus.Memory, static_cast<Word>(To + i), Bus.Read(Bus.Memory, static_cast<Word>(From + i)));
+        }
+        return;
+    }
+
+    // otherwise memmove in pieces that do not wrap around the address space
+    while (Length > 0)
+    {
+        u32 Piece = Length;
+        Piece = Piece < Mem::MAX_MEM - From ? Piece : Mem::MAX_MEM - From;
+        Piece = Piece < Mem::MAX_MEM - To ? Piece : Mem::MAX_MEM - To;
+        memmove(&Bus.Flat[To], &Bus.Flat[From], Piece);
+        From = static_cast<Word>(From + Piece);
+        To = static_cast<Word>(To + Piece);
+        Length -= Piece;
+    }
+}
@@ -0,0 +1,119 @@
+#include "m6502_hashedmem.h"
+
+#include <string.h>
+
+namespace
+{
+    // murmur3 finalizer
+    m6502::u64 Mix(m6502::u64 Value)
+    {
+        Value ^= Value >> 33;
+        Value *= 0xFF51AFD7ED558CCDull;
+        Value ^= Value >> 33;
+        Value *= 0xC4CEB9FE1A85EC53ull;
+        Value ^= Value >> 33;
+        return Value;
+    }
+
+    m6502::u64 RotateLeft(m6502::u64 Value, m6502::u32 Bits)
+    {
+        return (Value << Bits) | (Value >> (64 - Bits));
+    }
+
+    // order matters, swapping two pages has to change the root
+    m6502::u64 Combine(m6502::u64 Left, m6502::u64 Right)
+    {
+        return Mix(Left ^ RotateLeft(Mix(Right), 29));
+    }
+}
+
+m6502::HashedMem::HashedMem()
+{
+    Initialize();
+}
+
+void m6502::HashedMem::Initialize()
+{
+    memset(Data, 0, sizeof(Data));
+    memset(DirtyPages, 0xFF, sizeof(DirtyPages));
+}
+
+m6502::u64 m6502::HashedMem::HashPage(u32 PageIndex) const
+{
+    // an xxhash64 style round per 8 bytes, seeded with the page so equal pages at different addresses differ
+    const Byte* Page = Data + PageIndex * PAGE_SIZE;
+    u64 Hash = Mix(PageIndex + 1);
+    for (u32 i = 0; i < PAGE_SIZE; i += 8)
+    {
+        u64 Lane;
+        memcpy(&Lane, Page + i, sizeof(Lane));
+        Hash = RotateLeft(Hash ^ (Lane * 0xC2B2AE3D27D4EB4Full), 31) * 0x9E3779B185EBCA87ull;
+    }
+    return Mix(Hash);
+}
+
+m6502::u64 m6502::HashedMem::Root()
+{
+    // rehash the dirty leaves and note which inner nodes sit above them
+    u32 DirtyNodes[(NUM_PAGES - 1 + 31) / 32] = {};
+    bool AnyDirty = false;
+    for (u32 PageIndex = 0; PageIndex < NUM_PAGES; PageIndex++)
+    {
+        if (DirtyPages[PageIndex >> 5] == 0)
+        {
+            PageIndex |= 31;    //skip the rest of a clean group
+            continue;
+        }
+        if (DirtyPages[PageIndex >> 5] & (1u << (PageIndex & 31)))
+        {
+            Nodes[FIRST_LEAF + PageIndex] = HashPage(PageIndex);
+            AnyDirty = true;
+
+            for (u32 Node = FIRST_LEAF + PageIndex; Node > 0;)
+            {
+                Node = (Node - 1) / 2;
+                if (DirtyNodes[Node >> 5] & (1u << (Node & 31)))
+                {
+                    break;
+                }
+                DirtyNodes[Node >> 5] |= 1u << (Node & 31);
+            }
+        }
+    }
+    memset(DirtyPages, 0, sizeof(DirtyPages));
+
+    // children always have higher indices than their parent, so walk down from the last inner node
+    if (AnyDirty)
+    {
+        for (u32 Node = FIRST_LEAF; Node-- > 0;)
+        {
+            if (DirtyNodes[Node >> 5] & (1u << (Node & 31)))
+            {
+                Nodes[Node] = Combine(Nodes[2 * Node + 1], Nodes[2 * Node + 2]);
+            }
+        }
+    }
+    return Nodes[0];
+}
+
+m6502::u64 m6502::HashedMem::StateHash(const CPU& cpu)
+{
+    const u64 Registers = cpu.PC
+        | (static_cast<u64>(cpu.SP) << 16)
+        | (static_cast<u64>(cpu.A) << 24)
+        | (static_cast<u64>(cpu.X) << 32)
+        | (static_cast<u64>(cpu.Y) << 40)
+        | (static_cast<u64>(cpu.GetPS()) << 48);
+    const u64 Lines = cpu.Interrupts.Pending.load(std::memory_order_relaxed);
+    return Combine(Combine(Root(), Registers), Lines);
+}
+
+m6502::u32 m6502::HashedMem::NumDirtyPages() const
+{
+    u32 Count = 0;
+    for (u32 PageIndex = 0; PageIndex < NUM_PAGES; PageIndex++)
+    {
+        Count += (DirtyPages[PageIndex >> 5] >> (PageIndex & 31)) & 1;
+    }
+    return Count;
+}
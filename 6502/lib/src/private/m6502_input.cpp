@@ -0,0 +1,268 @@
+#include "m6502_input.h"
+
+#include <limits.h>
+#include <string.h>
+
+namespace
+{
+    constexpr char LOG_MAGIC[8] = { 'M', '6', '5', '0', '2', 'I', 'N', '1' };
+
+    void PutVarint(std::vector<m6502::Byte>& Out, m6502::u64 Value)
+    {
+        while (Value >= 0x80)
+        {
+            Out.push_back(static_cast<m6502::Byte>(Value | 0x80));
+            Value >>= 7;
+        }
+        Out.push_back(static_cast<m6502::Byte>(Value));
+    }
+
+    bool GetVarint(const std::vector<m6502::Byte>& In, size_t& At, m6502::u64& Value)
+    {
+        Value = 0;
+        for (m6502::u32 Shift = 0; Shift < 64 && At < In.size(); Shift += 7)
+        {
+            const m6502::Byte Next = In[At++];
+            Value |= static_cast<m6502::u64>(Next & 0x7F) << Shift;
+            if ((Next & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+std::vector<m6502::Byte> m6502::InputLog::Encode() const
+{
+    std::vector<Byte> Out(LOG_MAGIC, LOG_MAGIC + sizeof(LOG_MAGIC));
+    PutVarint(Out, Entries.size());
+
+    // cycle delta shifted left once, the low bit says a new address follows
+    u64 LastCycle = 0;
+    Word LastAddress = 0;
+    for (size_t i = 0; i < Entries.size(); i++)
+    {
+        const Entry& Read = Entries[i];
+        const bool NewAddress = i == 0 || Read.Address != LastAddress;
+        PutVarint(Out, ((Read.Cycle - LastCycle) << 1) | (NewAddress ? 1 : 0));
+        if (NewAddress)
+        {
+            Out.push_back(static_cast<Byte>(Read.Address));
+            Out.push_back(static_cast<Byte>(Read.Address >> 8));
+        }
+        Out.push_back(Read.Value);
+        LastCycle = Read.Cycle;
+        LastAddress = Read.Address;
+    }
+    return Out;
+}
+
+bool m6502::InputLog::Decode(const std::vector<Byte>& Encoded)
+{
+    Entries.clear();
+    if (Encoded.size() < sizeof(LOG_MAGIC) || memcmp(Encoded.data(), LOG_MAGIC, sizeof(LOG_MAGIC)) != 0)
+    {
+        return false;
+    }
+
+    size_t At = sizeof(LOG_MAGIC);
+    u64 Count;
+    if (!GetVarint(Encoded, At, Count) || Count > Encoded.size())
+    {
+        return false;
+    }
+    Entries.reserve(Count);
+
+    u64 Cycle = 0;
+    Word Address = 0;
+    for (u64 i = 0; i < Count; i++)
+    {
+        u64 Delta;
+        if (!GetVarint(Encoded, At, Delta))
+        {
+            return false;
+        }
+        Cycle += Delta >> 1;
+        if (Delta & 1)
+        {
+            if (At + 2 > Encoded.size())
+            {
+                return false;
+            }
+            Address = static_cast<Word>(Encoded[At] | (Encoded[At + 1] << 8));
+            At += 2;
+        }
+        if (At >= Encoded.size())
+        {
+            return false;
+        }
+        Entries.push_back({ Cycle, Address, Encoded[At++] });
+    }
+    return true;
+}
+
+bool m6502::InputLog::Save(const char* Path) const
+{
+    FILE* File = fopen(Path, "wb");
+    if (File == nullptr)
+    {
+        printf("cannot write input log %s\n", Path);
+        return false;
+    }
+    const std::vector<Byte> Encoded = Encode();
+    const bool Written = fwrite(Encoded.data(), 1, Encoded.size(), File) == Encoded.size();
+    return fclose(File) == 0 && Written;
+}
+
+bool m6502::InputLog::Load(const char* Path)
+{
+    FILE* File = fopen(Path, "rb");
+    if (File == nullptr)
+    {
+        printf("cannot open input log %s\n", Path);
+        return false;
+    }
+    std::vector<Byte> Encoded;
+    Byte Buffer[64 * 1024];
+    size_t Read;
+    while ((Read = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+    {
+        Encoded.insert(Encoded.end(), Buffer, Buffer + Read);
+    }
+    fclose(File);
+
+    if (!Decode(Encoded))
+    {
+        printf("%s is not a valid input log\n", Path);
+        return false;
+    }
+    return true;
+}
+
+m6502::InputMem::InputMem()
+{
+    memset(InputBits, 0, sizeof(InputBits));
+    Initialize();
+}
+
+void m6502::InputMem::Initialize()
+{
+    memset(Data, 0, sizeof(Data));
+}
+
+void m6502::InputMem::MapInput(Word Address, InputSource Source)
+{
+    InputBits[Address >> 5] |= 1u << (Address & 31);
+    Sources[Address] = std::move(Source);
+}
+
+m6502::Byte m6502::InputMem::ReadInput(Word Address) const
+{
+    if (Recorder != nullptr)
+    {
+        return Recorder->Input(Address);
+    }
+    return ReadSource(Address);
+}
+
+m6502::Byte m6502::InputMem::ReadSource(Word Address) const
+{
+    auto Found = Sources.find(Address);
+    return Found != Sources.end() && Found->second ? Found->second(Address) : Data[Address];
+}
+
+m6502::InputRecorder::InputRecorder(InputMem& Memory, InputLog& Log)
+    : Memory(Memory), Log(Log)
+{
+    Memory.Recorder = this;
+}
+
+m6502::InputRecorder::~InputRecorder()
+{
+    if (Memory.Recorder == this)
+    {
+        Memory.Recorder = nullptr;
+    }
+}
+
+m6502::Byte m6502::InputRecorder::Input(Word Address)
+{
+    if (!Replaying)
+    {
+        const Byte Value = Memory.ReadSource(Address);
+        Log.Entries.push_back({ InstructionStart, Address, Value });
+        return Value;
+    }
+
+    // during replay every port read has to be the instruction stepped onto the next entry
+    if (Cursor >= Log.Entries.size())
+    {
+        HasDiverged = true;
+        return Memory.ReadSource(Address);
+    }
+    const InputLog::Entry& Expected = Log.Entries[Cursor++];
+    if (!Stepping || Expected.Cycle != InstructionStart || Expected.Address != Address)
+    {
+        HasDiverged = true;
+    }
+    return Expected.Value;
+}
+
+template<typename TVariant>
+m6502::u64 m6502::InputRecorder::Record(CPU& cpu, u64 Cycles)
+{
+    Replaying = false;
+    Stepping = true;
+    const u64 Target = Now + Cycles;
+    while (Now < Target)
+    {
+        InstructionStart = Now;
+        Now += cpu.Execute<TVariant>(1, Memory);
+    }
+    return Cycles + (Now - Target);
+}
+
+template<typename TVariant>
+m6502::u64 m6502::InputRecorder::Replay(CPU& cpu, u64 Cycles)
+{
+    Replaying = true;
+    const u64 Target = Now + Cycles;
+    while (Now < Target)
+    {
+        // skip entries whose read never happened
+        while (Cursor < Log.Entries.size() && Log.Entries[Cursor].Cycle < Now)
+        {
+            HasDiverged = true;
+            Cursor++;
+        }
+
+        u64 Stop = Target;
+        if (Cursor < Log.Entries.size() && Log.Entries[Cursor].Cycle < Target)
+        {
+            Stop = Log.Entries[Cursor].Cycle;
+        }
+
+        if (Stop > Now)
+        {
+            // nothing reads a port until Stop, the slice ends on it or just after an instruction crossing it
+            Stepping = false;
+            const u64 Slice = Stop - Now < static_cast<u64>(INT_MAX) ? Stop - Now : INT_MAX;
+            Now += cpu.Execute<TVariant>(static_cast<s32>(Slice), Memory);
+            continue;
+        }
+
+        Stepping = true;
+        InstructionStart = Now;
+        Now += cpu.Execute<TVariant>(1, Memory);
+    }
+    Stepping = false;
+    return Cycles + (Now - Target);
+}
+
+template m6502::u64 m6502::InputRecorder::Record<m6502::NMOS6502>(CPU& cpu, u64 Cycles);
+template m6502::u64 m6502::InputRecorder::Record<m6502::CMOS65C02>(CPU& cpu, u64 Cycles);
+template m6502::u64 m6502::InputRecorder::Record<m6502::Ricoh2A03>(CPU& cpu, u64 Cycles);
+template m6502::u64 m6502::InputRecorder::Replay<m6502::NMOS6502>(CPU& cpu, u64 Cycles);
+template m6502::u64 m6502::InputRecorder::Replay<m6502::CMOS65C02>(CPU& cpu, u64 Cycles);
+template m6502::u64 m6502::InputRecorder::Replay<m6502::Ricoh2A03>(CPU& cpu, u64 Cycles);
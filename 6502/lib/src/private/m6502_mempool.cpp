@@ -0,0 +1,239 @@
+#include "m6502_mempool.h"
+
+#include <new>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+    constexpr int MPOL_PREFERRED_MODE = 1;  // MPOL_PREFERRED from linux/mempolicy.h
+
+    bool ReadNodeCpuList(m6502::u32 Node, char* Buffer, int Size)
+    {
+        char Path[64];
+        snprintf(Path, sizeof(Path), "/sys/devices/system/node/node%u/cpulist", Node);
+        FILE* File = fopen(Path, "r");
+        if (File == nullptr)
+        {
+            return false;
+        }
+        const bool Read = fgets(Buffer, Size, File) != nullptr;
+        fclose(File);
+        return Read;
+    }
+#endif
+}
+
+m6502::u32 m6502::Numa::NumNodes()
+{
+#ifdef __linux__
+    static const u32 Count = []()
+    {
+        char CpuList[256];
+        u32 Nodes = 0;
+        while (ReadNodeCpuList(Nodes, CpuList, sizeof(CpuList)))
+        {
+            Nodes++;
+        }
+        return Nodes > 0 ? Nodes : 1;
+    }();
+    return Count;
+#else
+    return 1;
+#endif
+}
+
+m6502::u32 m6502::Numa::CurrentNode()
+{
+#ifdef __linux__
+    unsigned Cpu = 0;
+    unsigned Node = 0;
+    if (syscall(SYS_getcpu, &Cpu, &Node, nullptr) == 0 && Node < NumNodes())
+    {
+        return Node;
+    }
+#endif
+    return 0;
+}
+
+bool m6502::Numa::PinThisThread(u32 Node)
+{
+#ifdef __linux__
+    // cpulist looks like "0-3,8-11"
+    char CpuList[1024];
+    if (!ReadNodeCpuList(Node, CpuList, sizeof(CpuList)))
+    {
+        return false;
+    }
+
+    cpu_set_t Cpus;
+    CPU_ZERO(&Cpus);
+    char* At = CpuList;
+    while (*At >= '0' && *At <= '9')
+    {
+        const long First = strtol(At, &At, 10);
+        long Last = First;
+        if (*At == '-')
+        {
+            Last = strtol(At + 1, &At, 10);
+        }
+        for (long Cpu = First; Cpu <= Last && Cpu < CPU_SETSIZE; Cpu++)
+        {
+            CPU_SET(Cpu, &Cpus);
+        }
+        if (*At == ',')
+        {
+            At++;
+        }
+    }
+    return CPU_COUNT(&Cpus) > 0 && sched_setaffinity(0, sizeof(Cpus), &Cpus) == 0;
+#else
+    (void)Node;
+    return false;
+#endif
+}
+
+m6502::MemPool::MemPool()
+{
+    for (u32 i = 0; i < Numa::NumNodes(); i++)
+    {
+        Nodes.emplace_back(new NodeSlabs());
+    }
+}
+
+m6502::MemPool::~MemPool()
+{
+    for (const std::pair<void*, size_t>& Mapping : Mappings)
+    {
+#ifdef __linux__
+        munmap(Mapping.first, Mapping.second);
+#else
+        ::operator delete(Mapping.first, std::align_val_t(HUGE_PAGE_SIZE));
+#endif
+    }
+}
+
+m6502::MemPool& m6502::MemPool::Global()
+{
+    static MemPool Pool;
+    return Pool;
+}
+
+m6502::Mem* m6502::MemPool::Allocate(u32 Node)
+{
+    if (Node >= Nodes.size())
+    {
+        Node = 0;
+    }
+
+    NodeSlabs& Slabs = *Nodes[Node];
+    std::lock_guard<std::mutex> Guard(Slabs.Lock);
+    if (Slabs.FreeList == nullptr && !Refill(Node, Slabs))
+    {
+        return nullptr;
+    }
+    FreeSlab* Slab = Slabs.FreeList;
+    Slabs.FreeList = Slab->Next;
+    Slabs.NumFree--;
+    return new (Slab) Mem;
+}
+
+void m6502::MemPool::Free(Mem* Memory)
+{
+    if (Memory == nullptr)
+    {
+        return;
+    }
+
+    NodeSlabs& Slabs = *Nodes[NodeOf(Memory)];
+    Memory->~Mem();
+    FreeSlab* Slab = reinterpret_cast<FreeSlab*>(Memory);
+    std::lock_guard<std::mutex> Guard(Slabs.Lock);
+    Slab->Next = Slabs.FreeList;
+    Slabs.FreeList = Slab;
+    Slabs.NumFree++;
+}
+
+m6502::u32 m6502::MemPool::NodeOf(const Mem* Memory) const
+{
+    const uintptr_t Base = reinterpret_cast<uintptr_t>(Memory) & ~static_cast<uintptr_t>(HUGE_PAGE_SIZE - 1);
+    std::lock_guard<std::mutex> Guard(HugePagesLock);
+    auto Found = HugePages.find(Base);
+    return Found != HugePages.end() ? Found->second : 0;
+}
+
+m6502::u32 m6502::MemPool::NumHugePages() const
+{
+    std::lock_guard<std::mutex> Guard(HugePagesLock);
+    return static_cast<u32>(HugePages.size());
+}
+
+m6502::u32 m6502::MemPool::NumFree(u32 Node) const
+{
+    NodeSlabs& Slabs = *Nodes[Node < Nodes.size() ? Node : 0];
+    std::lock_guard<std::mutex> Guard(Slabs.Lock);
+    return Slabs.NumFree;
+}
+
+bool m6502::MemPool::Refill(u32 Node, NodeSlabs& Slabs)
+{
+    Byte* HugePage = nullptr;
+#ifdef __linux__
+    void* Mapped = mmap(nullptr, HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (Mapped != MAP_FAILED)
+    {
+        HugePage = static_cast<Byte*>(Mapped);
+    }
+    else
+    {
+        // no reserved huge pages, map twice the size to get a 2MB aligned range and ask for a transparent one
+        Mapped = mmap(nullptr, 2 * HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (Mapped == MAP_FAILED)
+        {
+            printf("MemPool could not map memory\n");
+            return false;
+        }
+        const uintptr_t Start = reinterpret_cast<uintptr_t>(Mapped);
+        const uintptr_t Aligned = (Start + HUGE_PAGE_SIZE - 1) & ~static_cast<uintptr_t>(HUGE_PAGE_SIZE - 1);
+        if (Aligned > Start)
+        {
+            munmap(Mapped, Aligned - Start);
+        }
+        munmap(reinterpret_cast<void*>(Aligned + HUGE_PAGE_SIZE), Start + HUGE_PAGE_SIZE - Aligned);
+        HugePage = reinterpret_cast<Byte*>(Aligned);
+        madvise(HugePage, HUGE_PAGE_SIZE, MADV_HUGEPAGE);
+    }
+
+    if (Numa::NumNodes() > 1 && Node < 64)
+    {
+        // before the first touch, so the kernel places the pages on Node
+        const unsigned long NodeMask = 1ul << Node;
+        syscall(SYS_mbind, HugePage, HUGE_PAGE_SIZE, MPOL_PREFERRED_MODE, &NodeMask, 64, 0);
+    }
+#else
+    HugePage = static_cast<Byte*>(::operator new(HUGE_PAGE_SIZE, std::align_val_t(HUGE_PAGE_SIZE)));
+#endif
+
+    {
+        std::lock_guard<std::mutex> Guard(HugePagesLock);
+        HugePages[reinterpret_cast<uintptr_t>(HugePage)] = Node;
+        Mappings.emplace_back(HugePage, HUGE_PAGE_SIZE);
+    }
+
+    // hand the slabs out in address order
+    for (u32 i = SLABS_PER_HUGE_PAGE; i-- > 0;)
+    {
+        FreeSlab* Slab = reinterpret_cast<FreeSlab*>(HugePage + i * SLAB_SIZE);
+        Slab->Next = Slabs.FreeList;
+        Slabs.FreeList = Slab;
+    }
+    Slabs.NumFree += SLABS_PER_HUGE_PAGE;
+    return true;
+}
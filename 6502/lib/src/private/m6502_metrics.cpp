@@ -0,0 +1,257 @@
+#include "m6502_metrics.h"
+
+#include <stdio.h>
+
+struct m6502::Metrics::Entry
+{
+    MetricsShard Shard;
+    std::string Name;
+    bool Live = true;
+
+    // for the MHz gauge, as of the previous Format
+    u64 LastCycles = 0;
+    std::chrono::steady_clock::time_point LastTime = std::chrono::steady_clock::now();
+};
+
+// gives the shard back when its thread exits
+struct m6502::Metrics::ThreadExit
+{
+    ~ThreadExit()
+    {
+        Metrics::Global().RetireThread(ThreadMetrics);
+
+        // anything the thread still runs while exiting is dropped
+        static MetricsShard Discarded;
+        ThreadMetrics = &Discarded;
+    }
+};
+
+namespace
+{
+    struct Family
+    {
+        const char* Name;
+        const char* Help;
+        std::atomic<m6502::u64> m6502::MetricsShard::* Counter;
+    };
+
+    const Family Families[] = {
+        { "instructions_total", "Instructions run by the interpreter.", &m6502::MetricsShard::Instructions },
+        { "cycles_total", "Emulated cycles.", &m6502::MetricsShard::Cycles },
+        { "interrupts_total", "IRQ and NMI entries.", &m6502::MetricsShard::Interrupts },
+        { "unhandled_opcodes_total", "Opcodes the interpreter does not implement.", &m6502::MetricsShard::UnhandledOpcodes },
+    };
+
+    void AppendLabel(std::string& Out, const std::string& Value)
+    {
+        for (char Char : Value)
+        {
+            if (Char == '\\' || Char == '"')
+            {
+                Out += '\\';
+            }
+            Out += Char == '\n' ? ' ' : Char;
+        }
+    }
+
+    void AppendSample(std::string& Out, const char* Scope, const char* Name, const std::string& Label, const char* Value)
+    {
+        Out += "m6502_";
+        Out += Scope;
+        Out += '_';
+        Out += Name;
+        Out += '{';
+        Out += Scope;
+        Out += "=\"";
+        AppendLabel(Out, Label);
+        Out += "\"} ";
+        Out += Value;
+        Out += '\n';
+    }
+
+    void AppendHeader(std::string& Out, const char* Scope, const char* Name, const char* Help, const char* Type)
+    {
+        char Line[256];
+        snprintf(Line, sizeof(Line), "# HELP m6502_%s_%s %s\n# TYPE m6502_%s_%s %s\n", Scope, Name, Help, Scope, Name, Type);
+        Out += Line;
+    }
+}
+
+m6502::MetricsShard* m6502::RegisterThreadMetrics()
+{
+    return Metrics::Global().RegisterThread();
+}
+
+m6502::Metrics& m6502::Metrics::Global()
+{
+    static Metrics Instance;
+    return Instance;
+}
+
+m6502::MetricsShard* m6502::Metrics::RegisterThread()
+{
+    Entry* Found = nullptr;
+    {
+        std::lock_guard<std::mutex> Guard(Lock);
+        for (std::unique_ptr<Entry>& Thread : Threads)
+        {
+            if (!Thread->Live)
+            {
+                Found = Thread.get();
+                break;
+            }
+        }
+        if (Found == nullptr)
+        {
+            Threads.emplace_back(new Entry());
+            Found = Threads.back().get();
+        }
+        Found->Live = true;
+        Found->Name = "thread-" + std::to_string(NextThread++);
+        Found->LastCycles = 0;
+        Found->LastTime = std::chrono::steady_clock::now();
+    }
+
+    ThreadMetrics = &Found->Shard;
+    static thread_local ThreadExit Exit;
+    return ThreadMetrics;
+}
+
+void m6502::Metrics::RetireThread(MetricsShard* Shard)
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    if (!Retired)
+    {
+        Retired.reset(new Entry());
+        Retired->Name = "retired";
+    }
+    for (std::unique_ptr<Entry>& Thread : Threads)
+    {
+        if (&Thread->Shard == Shard)
+        {
+            for (const Family& Counter : Families)
+            {
+                MetricsShard::Add(Retired->Shard.*Counter.Counter, (Shard->*Counter.Counter).load(std::memory_order_relaxed));
+                (Shard->*Counter.Counter).store(0, std::memory_order_relaxed);
+            }
+            Thread->Live = false;
+            return;
+        }
+    }
+}
+
+void m6502::Metrics::NameThread(const std::string& Name)
+{
+    MetricsShard* Shard = ThreadMetrics != nullptr ? ThreadMetrics : RegisterThreadMetrics();
+    std::lock_guard<std::mutex> Guard(Lock);
+    for (std::unique_ptr<Entry>& Thread : Threads)
+    {
+        if (&Thread->Shard == Shard)
+        {
+            Thread->Name = Name;
+        }
+    }
+}
+
+m6502::MetricsShard* m6502::Metrics::AddMachine(const std::string& Name)
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    Machines.emplace_back(new Entry());
+    Machines.back()->Name = Name;
+    return &Machines.back()->Shard;
+}
+
+void m6502::Metrics::RemoveMachine(MetricsShard* Shard)
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    for (size_t i = 0; i < Machines.size(); i++)
+    {
+        if (&Machines[i]->Shard == Shard)
+        {
+            Machines.erase(Machines.begin() + i);
+            return;
+        }
+    }
+}
+
+std::string m6502::Metrics::Format()
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+
+    std::vector<Entry*> Workers;
+    for (std::unique_ptr<Entry>& Thread : Threads)
+    {
+        if (Thread->Live)
+        {
+            Workers.push_back(Thread.get());
+        }
+    }
+    if (Retired)
+    {
+        Workers.push_back(Retired.get());
+    }
+
+    struct Scope
+    {
+        const char* Name;
+        std::vector<Entry*> Entries;
+    };
+    Scope Scopes[2] = { { "worker", Workers }, { "machine", {} } };
+    for (std::unique_ptr<Entry>& Machine : Machines)
+    {
+        Scopes[1].Entries.push_back(Machine.get());
+    }
+
+    std::string Out;
+    char Value[32];
+    for (const Scope& Rows : Scopes)
+    {
+        for (const Family& Counter : Families)
+        {
+            AppendHeader(Out, Rows.Name, Counter.Name, Counter.Help, "counter");
+            for (Entry* Row : Rows.Entries)
+            {
+                snprintf(Value, sizeof(Value), "%llu", (Row->Shard.*Counter.Counter).load(std::memory_order_relaxed));
+                AppendSample(Out, Rows.Name, Counter.Name, Row->Name, Value);
+            }
+        }
+
+        AppendHeader(Out, Rows.Name, "emulated_mhz", "Emulated clock rate since the previous dump.", "gauge");
+        const std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now();
+        for (Entry* Row : Rows.Entries)
+        {
+            if (Row == Retired.get())
+            {
+                continue;
+            }
+            const u64 Cycles = Row->Shard.Cycles.load(std::memory_order_relaxed);
+            const double Seconds = std::chrono::duration<double>(Now - Row->LastTime).count();
+            const double MHz = Seconds > 0 ? (Cycles - Row->LastCycles) / Seconds / 1e6 : 0;
+            Row->LastCycles = Cycles;
+            Row->LastTime = Now;
+            snprintf(Value, sizeof(Value), "%.3f", MHz);
+            AppendSample(Out, Rows.Name, "emulated_mhz", Row->Name, Value);
+        }
+    }
+    return Out;
+}
+
+bool m6502::Metrics::WriteFile(const std::string& Path)
+{
+    const std::string Text = Format();
+    const std::string Temporary = Path + ".tmp";
+    FILE* File = fopen(Temporary.c_str(), "w");
+    if (File == nullptr)
+    {
+        printf("cannot write %s\n", Temporary.c_str());
+        return false;
+    }
+    const bool Written = fwrite(Text.data(), 1, Text.size(), File) == Text.size();
+    if (fclose(File) != 0 || !Written || rename(Temporary.c_str(), Path.c_str()) != 0)
+    {
+        printf("cannot write %s\n", Path.c_str());
+        remove(Temporary.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,127 @@
+#include "m6502_pacer.h"
+#include "m6502_sparsemem.h"
+
+#include <errno.h>
+#include <time.h>
+
+#ifndef __linux__
+#include <chrono>
+#include <thread>
+#endif
+
+m6502::Pacer::Pacer(const PacerConfig& Config)
+    : Config(Config)
+{
+    // both are divided by on every slice
+    if (this->Config.SliceCycles <= 0)
+    {
+        printf("pacer slice of %d cycles is not supported, using %d\n", Config.SliceCycles, PacerConfig().SliceCycles);
+        this->Config.SliceCycles = PacerConfig().SliceCycles;
+    }
+    if (this->Config.ClockHz == 0)
+    {
+        printf("pacer clock of 0Hz is not supported, using %llu\n", static_cast<unsigned long long>(PacerConfig().ClockHz));
+        this->Config.ClockHz = PacerConfig().ClockHz;
+    }
+}
+
+m6502::s64 m6502::Pacer::Now()
+{
+#ifdef __linux__
+    timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    return static_cast<s64>(Time.tv_sec) * 1000000000ll + Time.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void m6502::Pacer::Restart()
+{
+    Origin = Now();
+    CyclesRun = 0;
+    Started = true;
+}
+
+m6502::s64 m6502::Pacer::WaitUntil(s64 Deadline) const
+{
+    const s64 WakeAt = Deadline - Config.SpinNanoseconds;
+    if (WakeAt > Now())
+    {
+#ifdef __linux__
+        timespec Until;
+        Until.tv_sec = static_cast<time_t>(WakeAt / 1000000000ll);
+        Until.tv_nsec = static_cast<long>(WakeAt % 1000000000ll);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Until, nullptr) == EINTR)
+        {
+        }
+#else
+        std::this_thread::sleep_for(std::chrono::nanoseconds(WakeAt - Now()));
+#endif
+    }
+
+    s64 Time = Now();
+    while (Time < Deadline)
+    {
+        Time = Now();
+    }
+    return Time - Deadline;
+}
+
+template<typename TVariant, typename TMem>
+m6502::u64 m6502::Pacer::Execute(CPU& cpu, TMem& memory, u64 Cycles)
+{
+    if (!Started)
+    {
+        Restart();
+    }
+
+    u64 CyclesUsed = 0;
+    while (CyclesUsed < Cycles)
+    {
+        // end slices on multiples of SliceCycles so an overrun shortens the next slice
+        const u64 SliceEnd = (CyclesRun / Config.SliceCycles + 1) * Config.SliceCycles;
+        const u64 Left = Cycles - CyclesUsed;
+        const u64 Slice = SliceEnd - CyclesRun < Left ? SliceEnd - CyclesRun : Left;
+
+        const u64 Used = static_cast<u64>(cpu.Execute<TVariant>(static_cast<s32>(Slice), memory));
+        CyclesUsed += Used;
+        CyclesRun += Used;
+
+        const s64 Deadline = DeadlineFor(CyclesRun);
+        const s64 Behind = Now() - Deadline;
+        if (Behind > 0)
+        {
+            Jitter.Overruns++;
+            if (Behind > Config.MaxLagNanoseconds)
+            {
+                // the host stalled, catching up would run flat out for a while
+                Jitter.Resyncs++;
+                Restart();
+                continue;
+            }
+        }
+
+        const s64 Late = WaitUntil(Deadline);
+        Jitter.Slices++;
+        Jitter.TotalLate += Late;
+        Jitter.TotalLateSquared += static_cast<double>(Late) * Late;
+        if (Late > Jitter.MaxLate)
+        {
+            Jitter.MaxLate = Late;
+        }
+    }
+    return CyclesUsed;
+}
+
+#define M6502_INSTANTIATE_PACER(Variant, Memory) \
+    template m6502::u64 m6502::Pacer::Execute<m6502::Variant, m6502::Memory>(CPU& cpu, m6502::Memory& memory, u64 Cycles);
+
+#define M6502_INSTANTIATE_PACER_VARIANTS(Memory) \
+    M6502_INSTANTIATE_PACER(NMOS6502, Memory) \
+    M6502_INSTANTIATE_PACER(CMOS65C02, Memory) \
+    M6502_INSTANTIATE_PACER(Ricoh2A03, Memory)
+
+M6502_INSTANTIATE_PACER_VARIANTS(Mem)
+M6502_INSTANTIATE_PACER_VARIANTS(SparseMem)
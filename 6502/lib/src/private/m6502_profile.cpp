@@ -0,0 +1,111 @@
+#include "m6502_profile.h"
+
+#include <stdio.h>
+
+m6502::OpcodeProfile::OpcodeProfile()
+    : Pairs(256 * 256, 0)
+{
+}
+
+m6502::s32 m6502::OpcodeProfile::Execute(CPU& cpu, Mem& memory, s32 Cycles)
+{
+    const s32 CyclesRequested = Cycles;
+    while (Cycles > 0)
+    {
+        if (cpu.Interrupts.Pending.load(std::memory_order_relaxed) != 0)
+        {
+            BreakSequence();
+        }
+        else
+        {
+            Record(memory.Read(cpu.PC));
+        }
+        Cycles -= cpu.Execute(1, memory);
+    }
+    return CyclesRequested - Cycles;
+}
+
+void m6502::OpcodeProfile::Record(Byte Opcode)
+{
+    if (HistoryLength >= 1)
+    {
+        Pairs[(History[1] << 8) | Opcode]++;
+    }
+    if (HistoryLength >= 2)
+    {
+        Triples[(History[0] << 16) | (History[1] << 8) | Opcode]++;
+    }
+    History[0] = History[1];
+    History[1] = Opcode;
+    if (HistoryLength < 2)
+    {
+        HistoryLength++;
+    }
+}
+
+m6502::u64 m6502::OpcodeProfile::TripleCount(Byte First, Byte Second, Byte Third) const
+{
+    auto Found = Triples.find((First << 16) | (Second << 8) | Third);
+    return Found != Triples.end() ? Found->second : 0;
+}
+
+bool m6502::OpcodeProfile::Save(const char* Path) const
+{
+    FILE* File = fopen(Path, "w");
+    if (File == nullptr)
+    {
+        printf("cannot write profile %s\n", Path);
+        return false;
+    }
+
+    for (u32 i = 0; i < Pairs.size(); i++)
+    {
+        if (Pairs[i] != 0)
+        {
+            fprintf(File, "pair %02X %02X %llu\n", i >> 8, i & 0xFF, static_cast<unsigned long long>(Pairs[i]));
+        }
+    }
+    for (const auto& Triple : Triples)
+    {
+        fprintf(File, "triple %02X %02X %02X %llu\n", Triple.first >> 16, (Triple.first >> 8) & 0xFF,
+            Triple.first & 0xFF, static_cast<unsigned long long>(Triple.second));
+    }
+    return fclose(File) == 0;
+}
+
+bool m6502::OpcodeProfile::Load(const char* Path)
+{
+    FILE* File = fopen(Path, "r");
+    if (File == nullptr)
+    {
+        printf("cannot open profile %s\n", Path);
+        return false;
+    }
+
+    char Line[128];
+    bool Ok = true;
+    while (Ok && fgets(Line, sizeof(Line), File) != nullptr)
+    {
+        unsigned int A, B, C;
+        unsigned long long Count;
+        if (Line[0] == '#' || Line[0] == '\n')
+        {
+            continue;
+        }
+        if (sscanf(Line, "triple %x %x %x %llu", &A, &B, &C, &Count) == 4 && A < 256 && B < 256 && C < 256)
+        {
+            Triples[(A << 16) | (B << 8) | C] += Count;
+        }
+        else if (sscanf(Line, "pair %x %x %llu", &A, &B, &Count) == 3 && A < 256 && B < 256)
+        {
+            Pairs[(A << 8) | B] += Count;
+        }
+        else
+        {
+            printf("bad profile line in %s: %s", Path, Line);
+            Ok = false;
+        }
+    }
+    fclose(File);
+    return Ok;
+}
@@ -0,0 +1,18 @@
+#include "m6502_recompiled.h"
+
+m6502::s32 m6502::RecompiledProgram::Execute(CPU& cpu, Mem& memory, s32 Cycles) const
+{
+    const s32 CyclesRequested = Cycles;
+    while (Cycles > 0)
+    {
+        if (cpu.Interrupts.Pending.load(std::memory_order_relaxed) == 0
+            && RunBlock(cpu, memory, Cycles))
+        {
+            continue;
+        }
+
+        // one step of the interpreter: an interrupt entry or one instruction
+        Cycles -= cpu.Execute(1, memory);
+    }
+    return CyclesRequested - Cycles;
+}
@@ -0,0 +1,15 @@
+#include "m6502_rom.h"
+
+#include <string.h>
+
+std::shared_ptr<const m6502::RomImage> m6502::RomImage::Create(const Byte* Data, u32 Size)
+{
+    std::shared_ptr<RomImage> Image(new RomImage());
+    Image->ImageSize = Size;
+    Image->Bytes.resize(Image->NumPages() * PAGE_SIZE, 0);
+    if (Size > 0)
+    {
+        memcpy(Image->Bytes.data(), Data, Size);
+    }
+    return Image;
+}
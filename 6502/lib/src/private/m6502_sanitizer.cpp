@@ -0,0 +1,65 @@
+#include "m6502_sanitizer.h"
+
+#include <string.h>
+
+const char* m6502::SanitizerReport::KindName(ErrorKind Kind)
+{
+    switch (Kind)
+    {
+    case NONE: return "none";
+    case UNINITIALIZED_READ: return "uninitialized read";
+    case STACK_OVERFLOW: return "stack overflow";
+    case STACK_UNDERFLOW: return "stack underflow";
+    case EXECUTE_NON_CODE: return "execute from non-code page";
+    }
+    return "unknown";
+}
+
+m6502::SanitizedMem::SanitizedMem()
+{
+    memset(CodePages, 0, sizeof(CodePages));
+    Initialize();
+}
+
+void m6502::SanitizedMem::Initialize()
+{
+    memset(Data, 0, sizeof(Data));
+    memset(Written, 0, sizeof(Written));
+    ClearReport();
+    InstructionPC = 0;
+}
+
+void m6502::SanitizedMem::MarkCode(Word Address, u32 Size)
+{
+    if (Size == 0)
+    {
+        return;
+    }
+    const u32 Last = (Address + Size - 1 < MAX_MEM ? Address + Size - 1 : MAX_MEM - 1) >> 8;
+    for (u32 Page = Address >> 8; Page <= Last; Page++)
+    {
+        CodePages[Page >> 5] |= 1u << (Page & 31);
+    }
+    CheckCode = true;
+}
+
+void m6502::SanitizedMem::MarkInitialized(Word Address, u32 Size)
+{
+    for (u32 i = Address; i < Address + Size && i < MAX_MEM; i++)
+    {
+        MarkWritten(i);
+    }
+}
+
+void m6502::SanitizedMem::Fail(SanitizerReport::ErrorKind Kind, Word Address) const
+{
+    if (HasReport())
+    {
+        return;
+    }
+    Report.Kind = Kind;
+    Report.PC = InstructionPC;
+    Report.Address = Address;
+    printf("sanitizer: %s at PC $%04X (address $%04X)\n",
+        SanitizerReport::KindName(Kind), Report.PC, Report.Address);
+}
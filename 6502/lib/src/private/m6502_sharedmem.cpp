@@ -0,0 +1,46 @@
+#include "m6502_sharedmem.h"
+
+#include <string.h>
+
+std::shared_ptr<m6502::SharedRegion> m6502::SharedRegion::Create(u32 NumPages)
+{
+    std::shared_ptr<SharedRegion> Region(new SharedRegion());
+    Region->PageCount = NumPages;
+    Region->Bytes.reset(new std::atomic<Byte>[NumPages * PAGE_SIZE]);
+    for (u32 i = 0; i < NumPages * PAGE_SIZE; i++)
+    {
+        Region->Bytes[i].store(0, std::memory_order_relaxed);
+    }
+    return Region;
+}
+
+m6502::SystemMem::SystemMem()
+{
+    for (u32 i = 0; i < NUM_PAGES; i++)
+    {
+        SharedPages[i] = nullptr;
+    }
+    Initialize();
+}
+
+void m6502::SystemMem::Initialize()
+{
+    memset(Data, 0, sizeof(Data));
+}
+
+bool m6502::SystemMem::MapShared(std::shared_ptr<SharedRegion> Region, Word Address)
+{
+    const u32 FirstPage = Address >> 8;
+    const u32 NumPages = Region->NumPages();
+    if (!Fits(Address, NumPages))
+    {
+        return false;
+    }
+
+    for (u32 i = 0; i < NumPages; i++)
+    {
+        SharedPages[FirstPage + i] = Region->Page(i);
+    }
+    Regions.push_back(std::move(Region));
+    return true;
+}
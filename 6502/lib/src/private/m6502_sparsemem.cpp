@@ -0,0 +1,167 @@
+#include "m6502_sparsemem.h"
+
+#include <mutex>
+#include <string.h>
+
+namespace
+{
+    struct alignas(16) PageStorage
+    {
+        m6502::Byte Data[m6502::PagePool::PAGE_SIZE];
+    };
+
+    const PageStorage SharedZeroPage = {};
+
+    // pages handed back by threads that have exited, chunks themselves are never freed
+    // because a page can outlive the thread that allocated it
+    std::mutex OrphanLock;
+    void* OrphanList = nullptr;
+}
+
+m6502::PagePool& m6502::PagePool::ThisThread()
+{
+    thread_local PagePool Pool;
+    return Pool;
+}
+
+const m6502::Byte* m6502::PagePool::ZeroPage()
+{
+    return SharedZeroPage.Data;
+}
+
+m6502::Byte* m6502::PagePool::Allocate()
+{
+    if (FreeList == nullptr)
+    {
+        Refill();
+    }
+    FreePage* Page = FreeList;
+    FreeList = Page->Next;
+
+    Byte* Data = reinterpret_cast<Byte*>(Page);
+    memset(Data, 0, PAGE_SIZE);
+    return Data;
+}
+
+void m6502::PagePool::Free(Byte* Page)
+{
+    FreePage* Free = reinterpret_cast<FreePage*>(Page);
+    Free->Next = FreeList;
+    FreeList = Free;
+}
+
+void m6502::PagePool::Refill()
+{
+    {
+        std::lock_guard<std::mutex> Guard(OrphanLock);
+        if (OrphanList != nullptr)
+        {
+            FreeList = static_cast<FreePage*>(OrphanList);
+            OrphanList = nullptr;
+            return;
+        }
+    }
+
+    PageStorage* Chunk = new PageStorage[PAGES_PER_CHUNK];
+    for (u32 i = 0; i < PAGES_PER_CHUNK; i++)
+    {
+        Free(Chunk[i].Data);
+    }
+}
+
+m6502::PagePool::~PagePool()
+{
+    if (FreeList == nullptr)
+    {
+        return;
+    }
+
+    FreePage* Last = FreeList;
+    while (Last->Next != nullptr)
+    {
+        Last = Last->Next;
+    }
+
+    std::lock_guard<std::mutex> Guard(OrphanLock);
+    Last->Next = static_cast<FreePage*>(OrphanList);
+    OrphanList = FreeList;
+    FreeList = nullptr;
+}
+
+m6502::SparseMem::SparseMem()
+{
+    for (u32 i = 0; i < NUM_PAGES; i++)
+    {
+        Pages[i] = PagePool::ZeroPage();
+    }
+    memset(Owned, 0, sizeof(Owned));
+    memset(RomPages, 0, sizeof(RomPages));
+}
+
+m6502::SparseMem::~SparseMem()
+{
+    Initialize();
+}
+
+void m6502::SparseMem::Initialize()
+{
+    PagePool& Pool = PagePool::ThisThread();
+    for (u32 i = 0; i < NUM_PAGES; i++)
+    {
+        if (IsSet(Owned, i))
+        {
+            Pool.Free(const_cast<Byte*>(Pages[i]));
+            Pages[i] = PagePool::ZeroPage();
+        }
+    }
+    memset(Owned, 0, sizeof(Owned));
+}
+
+bool m6502::SparseMem::MapRom(std::shared_ptr<const RomImage> Rom, Word Address)
+{
+    const u32 FirstPage = Address >> 8;
+    const u32 NumPages = Rom->NumPages();
+    if ((Address & 0xFF) != 0 || FirstPage + NumPages > NUM_PAGES)
+    {
+        return false;
+    }
+
+    PagePool& Pool = PagePool::ThisThread();
+    for (u32 i = 0; i < NumPages; i++)
+    {
+        const u32 PageIndex = FirstPage + i;
+        if (IsSet(Owned, PageIndex))
+        {
+            Pool.Free(const_cast<Byte*>(Pages[PageIndex]));
+            Owned[PageIndex >> 5] &= ~(1u << (PageIndex & 31));
+        }
+        Pages[PageIndex] = Rom->Page(i);
+        RomPages[PageIndex >> 5] |= (1u << (PageIndex & 31));
+    }
+    Roms.push_back(std::move(Rom));
+    return true;
+}
+
+m6502::u32 m6502::SparseMem::NumAllocatedPages() const
+{
+    u32 Count = 0;
+    for (u32 i = 0; i < NUM_PAGES; i++)
+    {
+        Count += IsSet(Owned, i);
+    }
+    return Count;
+}
+
+m6502::Byte* m6502::SparseMem::UnownedPage(u32 PageIndex)
+{
+    PagePool& Pool = PagePool::ThisThread();
+    if (IsSet(RomPages, PageIndex))
+    {
+        return Pool.DiscardPage();
+    }
+
+    Byte* Page = Pool.Allocate();
+    Pages[PageIndex] = Page;
+    Owned[PageIndex >> 5] |= (1u << (PageIndex & 31));
+    return Page;
+}
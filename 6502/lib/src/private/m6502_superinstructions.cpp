@@ -0,0 +1,17 @@
+#include "m6502_superinstructions.h"
+
+m6502::s32 m6502::Superinstructions::Execute(CPU& cpu, Mem& memory, s32 Cycles) const
+{
+    const s32 CyclesRequested = Cycles;
+    while (Cycles > 0)
+    {
+        const Handler Fused = Handlers[memory.Read(cpu.PC)];
+        if (Fused != nullptr && cpu.Interrupts.Pending.load(std::memory_order_relaxed) == 0)
+        {
+            Fused(cpu, memory, Cycles);
+            continue;
+        }
+        Cycles -= cpu.Execute(1, memory);
+    }
+    return CyclesRequested - Cycles;
+}
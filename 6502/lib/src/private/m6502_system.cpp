@@ -0,0 +1,105 @@
+#include "m6502_system.h"
+
+#include <stdio.h>
+#include <thread>
+
+m6502::System::System(const SystemConfig& Config)
+    : Config(Config)
+{
+    // a core gets nowhere with slices of no cycles
+    if (this->Config.Quantum <= 0)
+    {
+        printf("system quantum of %d cycles is not supported, using %d\n", Config.Quantum, SystemConfig().Quantum);
+        this->Config.Quantum = SystemConfig().Quantum;
+    }
+    for (u32 i = 0; i < Config.NumCores; i++)
+    {
+        Cores.emplace_back(new Core());
+    }
+}
+
+std::shared_ptr<m6502::SharedRegion> m6502::System::MapShared(Word Address, u32 NumPages)
+{
+    if (!SystemMem::Fits(Address, NumPages))
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<SharedRegion> Region = SharedRegion::Create(NumPages);
+    for (std::unique_ptr<Core>& Each : Cores)
+    {
+        Each->memory.MapShared(Region, Address);
+    }
+    return Region;
+}
+
+template<typename TVariant>
+void m6502::System::Run(u64 Cycles)
+{
+    for (std::unique_ptr<Core>& Each : Cores)
+    {
+        Each->Running.store(true, std::memory_order_relaxed);
+    }
+
+    std::vector<std::thread> Threads;
+    for (u32 i = 1; i < NumCores(); i++)
+    {
+        Threads.emplace_back([this, i, Cycles]() { RunCore<TVariant>(i, Cycles); });
+    }
+    //the calling thread runs the first core
+    if (NumCores() > 0)
+    {
+        RunCore<TVariant>(0, Cycles);
+    }
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+}
+
+template<typename TVariant>
+void m6502::System::RunCore(u32 Index, u64 Cycles)
+{
+    Core& Self = *Cores[Index];
+    u64 Done = Self.CyclesRun.load(std::memory_order_relaxed);
+    const u64 Target = Done + Cycles;
+
+    while (Done < Target)
+    {
+        u64 Slowest;
+        while (SlowestOther(Index, Slowest) && Done > Slowest + Config.MaxSkew)
+        {
+            std::this_thread::yield();
+        }
+
+        const u64 Left = Target - Done;
+        const s32 Slice = Left < static_cast<u64>(Config.Quantum) ? static_cast<s32>(Left) : Config.Quantum;
+        Done += Self.cpu.Execute<TVariant>(Slice, Self.memory);
+        Self.CyclesRun.store(Done, std::memory_order_release);
+    }
+    Self.Running.store(false, std::memory_order_release);
+}
+
+bool m6502::System::SlowestOther(u32 Index, u64& Slowest) const
+{
+    bool Found = false;
+    for (u32 i = 0; i < NumCores(); i++)
+    {
+        const Core& Other = *Cores[i];
+        if (i == Index || !Other.Running.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+        const u64 OtherCycles = Other.CyclesRun.load(std::memory_order_acquire);
+        if (!Found || OtherCycles < Slowest)
+        {
+            Slowest = OtherCycles;
+            Found = true;
+        }
+    }
+    return Found;
+}
+
+template void m6502::System::Run<m6502::NMOS6502>(u64 Cycles);
+template void m6502::System::Run<m6502::CMOS65C02>(u64 Cycles);
+template void m6502::System::Run<m6502::Ricoh2A03>(u64 Cycles);
@@ -0,0 +1,357 @@
+#include "m6502_verify.h"
+
+#include <limits.h>
+#include <string.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    constexpr char LOG_MAGIC[8] = { 'M', '6', '5', '0', '2', 'C', 'P', '1' };
+    constexpr m6502::u32 PAGE_SIZE = 256;
+    constexpr m6502::u32 NUM_PAGES = m6502::Mem::MAX_MEM / PAGE_SIZE;
+
+    void PutVarint(std::vector<m6502::Byte>& Out, m6502::u64 Value)
+    {
+        while (Value >= 0x80)
+        {
+            Out.push_back(static_cast<m6502::Byte>(Value | 0x80));
+            Value >>= 7;
+        }
+        Out.push_back(static_cast<m6502::Byte>(Value));
+    }
+
+    bool GetVarint(const std::vector<m6502::Byte>& In, size_t& At, m6502::u64& Value)
+    {
+        Value = 0;
+        for (m6502::u32 Shift = 0; Shift < 64 && At < In.size(); Shift += 7)
+        {
+            const m6502::Byte Next = In[At++];
+            Value |= static_cast<m6502::u64>(Next & 0x7F) << Shift;
+            if ((Next & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // run from Cycle until an instruction ends at or past Stop
+    template<typename TVariant>
+    m6502::u64 RunTo(m6502::CPU& cpu, m6502::Mem& memory, m6502::u64 Cycle, m6502::u64 Stop)
+    {
+        while (Cycle < Stop)
+        {
+            const m6502::u64 Slice = Stop - Cycle < static_cast<m6502::u64>(INT_MAX) ? Stop - Cycle : INT_MAX;
+            Cycle += cpu.Execute<TVariant>(static_cast<m6502::s32>(Slice), memory);
+        }
+        return Cycle;
+    }
+}
+
+m6502::Checkpoint m6502::Checkpoint::Capture(u64 Cycle, const CPU& cpu, const Mem& memory)
+{
+    Checkpoint State;
+    State.Cycle = Cycle;
+    State.PC = cpu.PC;
+    State.SP = cpu.SP;
+    State.A = cpu.A;
+    State.X = cpu.X;
+    State.Y = cpu.Y;
+    State.PS = cpu.GetPS();
+    State.Interrupts = cpu.Interrupts.Pending.load(std::memory_order_relaxed);
+    State.Memory.assign(memory.Data, memory.Data + Mem::MAX_MEM);
+    return State;
+}
+
+void m6502::Checkpoint::Restore(CPU& cpu, Mem& memory) const
+{
+    cpu.PC = PC;
+    cpu.SP = SP;
+    cpu.A = A;
+    cpu.X = X;
+    cpu.Y = Y;
+    cpu.SetPS(PS);
+    cpu.Interrupts.Pending.store(Interrupts, std::memory_order_relaxed);
+    memcpy(memory.Data, Memory.data(), Mem::MAX_MEM);
+}
+
+template<typename TVariant>
+m6502::u64 m6502::CheckpointLog::Record(CPU& cpu, Mem& memory, u64 Cycles, u64 Interval)
+{
+    if (Checkpoints.empty())
+    {
+        Checkpoints.push_back(Checkpoint::Capture(0, cpu, memory));
+    }
+    if (Interval == 0)
+    {
+        Interval = Cycles;
+    }
+
+    const u64 Start = Checkpoints.back().Cycle;
+    const u64 Target = Start + Cycles;
+    u64 Cycle = Start;
+    u64 NextCapture = Start + Interval;
+    while (Cycle < Target)
+    {
+        Cycle = RunTo<TVariant>(cpu, memory, Cycle, NextCapture < Target ? NextCapture : Target);
+        Checkpoints.push_back(Checkpoint::Capture(Cycle, cpu, memory));
+        while (NextCapture <= Cycle)
+        {
+            NextCapture += Interval;
+        }
+    }
+    return Cycle - Start;
+}
+
+std::vector<m6502::Byte> m6502::CheckpointLog::Encode() const
+{
+    std::vector<Byte> Out(LOG_MAGIC, LOG_MAGIC + sizeof(LOG_MAGIC));
+    PutVarint(Out, Checkpoints.size());
+
+    // each checkpoint has a bitmap of the pages that differ from the one before, then those pages
+    const std::vector<Byte> Zeroes(Mem::MAX_MEM, 0);
+    const Checkpoint* Previous = nullptr;
+    for (const Checkpoint& State : Checkpoints)
+    {
+        PutVarint(Out, State.Cycle - (Previous != nullptr ? Previous->Cycle : 0));
+        const Byte Registers[] = { static_cast<Byte>(State.PC), static_cast<Byte>(State.PC >> 8),
+            State.SP, State.A, State.X, State.Y, State.PS };
+        Out.insert(Out.end(), Registers, Registers + sizeof(Registers));
+        PutVarint(Out, State.Interrupts);
+
+        const Byte* Before = Previous != nullptr ? Previous->Memory.data() : Zeroes.data();
+        Byte Changed[NUM_PAGES / 8] = {};
+        for (u32 Page = 0; Page < NUM_PAGES; Page++)
+        {
+            if (memcmp(State.Memory.data() + Page * PAGE_SIZE, Before + Page * PAGE_SIZE, PAGE_SIZE) != 0)
+            {
+                Changed[Page >> 3] |= 1 << (Page & 7);
+            }
+        }
+        Out.insert(Out.end(), Changed, Changed + sizeof(Changed));
+        for (u32 Page = 0; Page < NUM_PAGES; Page++)
+        {
+            if (Changed[Page >> 3] & (1 << (Page & 7)))
+            {
+                const Byte* Data = State.Memory.data() + Page * PAGE_SIZE;
+                Out.insert(Out.end(), Data, Data + PAGE_SIZE);
+            }
+        }
+        Previous = &State;
+    }
+    return Out;
+}
+
+bool m6502::CheckpointLog::Decode(const std::vector<Byte>& Encoded)
+{
+    Checkpoints.clear();
+    if (Encoded.size() < sizeof(LOG_MAGIC) || memcmp(Encoded.data(), LOG_MAGIC, sizeof(LOG_MAGIC)) != 0)
+    {
+        return false;
+    }
+
+    size_t At = sizeof(LOG_MAGIC);
+    u64 Count;
+    if (!GetVarint(Encoded, At, Count) || Count > Encoded.size())
+    {
+        return false;
+    }
+    Checkpoints.reserve(Count);
+
+    u64 Cycle = 0;
+    for (u64 i = 0; i < Count; i++)
+    {
+        Checkpoint State;
+        u64 Delta, Interrupts;
+        if (!GetVarint(Encoded, At, Delta) || At + 7 > Encoded.size())
+        {
+            return false;
+        }
+        Cycle += Delta;
+        State.Cycle = Cycle;
+        State.PC = static_cast<Word>(Encoded[At] | (Encoded[At + 1] << 8));
+        State.SP = Encoded[At + 2];
+        State.A = Encoded[At + 3];
+        State.X = Encoded[At + 4];
+        State.Y = Encoded[At + 5];
+        State.PS = Encoded[At + 6];
+        At += 7;
+        if (!GetVarint(Encoded, At, Interrupts) || At + NUM_PAGES / 8 > Encoded.size())
+        {
+            return false;
+        }
+        State.Interrupts = static_cast<u32>(Interrupts);
+
+        if (Checkpoints.empty())
+        {
+            State.Memory.assign(Mem::MAX_MEM, 0);
+        }
+        else
+        {
+            State.Memory = Checkpoints.back().Memory;
+        }
+        const Byte* Changed = Encoded.data() + At;
+        At += NUM_PAGES / 8;
+        for (u32 Page = 0; Page < NUM_PAGES; Page++)
+        {
+            if (Changed[Page >> 3] & (1 << (Page & 7)))
+            {
+                if (At + PAGE_SIZE > Encoded.size())
+                {
+                    return false;
+                }
+                memcpy(State.Memory.data() + Page * PAGE_SIZE, Encoded.data() + At, PAGE_SIZE);
+                At += PAGE_SIZE;
+            }
+        }
+        Checkpoints.push_back(std::move(State));
+    }
+    return true;
+}
+
+bool m6502::CheckpointLog::Save(const char* Path) const
+{
+    FILE* File = fopen(Path, "wb");
+    if (File == nullptr)
+    {
+        printf("cannot write checkpoint log %s\n", Path);
+        return false;
+    }
+    const std::vector<Byte> Encoded = Encode();
+    const bool Written = fwrite(Encoded.data(), 1, Encoded.size(), File) == Encoded.size();
+    return fclose(File) == 0 && Written;
+}
+
+bool m6502::CheckpointLog::Load(const char* Path)
+{
+    FILE* File = fopen(Path, "rb");
+    if (File == nullptr)
+    {
+        printf("cannot open checkpoint log %s\n", Path);
+        return false;
+    }
+    std::vector<Byte> Encoded;
+    Byte Buffer[64 * 1024];
+    size_t Read;
+    while ((Read = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+    {
+        Encoded.insert(Encoded.end(), Buffer, Buffer + Read);
+    }
+    fclose(File);
+
+    if (!Decode(Encoded))
+    {
+        printf("%s is not a valid checkpoint log\n", Path);
+        return false;
+    }
+    return true;
+}
+
+const char* m6502::VerifyReport::KindName(DifferenceKind Kind)
+{
+    switch (Kind)
+    {
+    case NONE:
+        return "none";
+    case OVERSHOT:
+        return "overshot checkpoint";
+    case REGISTERS:
+        return "registers differ";
+    case MEMORY:
+        return "memory differs";
+    }
+    return "unknown";
+}
+
+template<typename TVariant>
+m6502::VerifyReport m6502::RunVerifier::VerifySegment(const CheckpointLog& Log, size_t Segment, CPU& cpu,
+    Mem& memory)
+{
+    const Checkpoint& From = Log.Checkpoints[Segment];
+    const Checkpoint& To = Log.Checkpoints[Segment + 1];
+
+    VerifyReport Report;
+    Report.Segment = Segment;
+    Report.StartCycle = From.Cycle;
+    Report.SegmentsRun = 1;
+
+    From.Restore(cpu, memory);
+    Report.Cycle = RunTo<TVariant>(cpu, memory, From.Cycle, To.Cycle);
+    if (Report.Cycle != To.Cycle)
+    {
+        Report.Kind = VerifyReport::OVERSHOT;
+    }
+    else if (!To.SameRegisters(cpu))
+    {
+        Report.Kind = VerifyReport::REGISTERS;
+    }
+    else if (memcmp(memory.Data, To.Memory.data(), Mem::MAX_MEM) != 0)
+    {
+        Report.Kind = VerifyReport::MEMORY;
+        u32 Address = 0;
+        while (memory.Data[Address] == To.Memory[Address])
+        {
+            Address++;
+        }
+        Report.Address = static_cast<Word>(Address);
+    }
+    return Report;
+}
+
+template<typename TVariant>
+m6502::VerifyReport m6502::RunVerifier::Verify(const CheckpointLog& Log, u32 NumThreads)
+{
+    const size_t NumSegments = Log.Checkpoints.size() > 1 ? Log.Checkpoints.size() - 1 : 0;
+    VerifyReport First;
+    std::mutex FirstMutex;
+    std::atomic<size_t> Next{0};
+    std::atomic<size_t> FirstDiverged{NumSegments};    // segments after it need not run
+    std::atomic<u64> SegmentsRun{0};
+
+    auto Work = [&]()
+    {
+        auto Memory = std::make_unique<Mem>();
+        CPU cpu;
+        for (size_t i = Next.fetch_add(1); i < FirstDiverged.load(); i = Next.fetch_add(1))
+        {
+            const VerifyReport Report = VerifySegment<TVariant>(Log, i, cpu, *Memory);
+            SegmentsRun++;
+            if (!Report.Diverged())
+            {
+                continue;
+            }
+            std::lock_guard<std::mutex> Lock(FirstMutex);
+            if (!First.Diverged() || Report.Segment < First.Segment)
+            {
+                First = Report;
+                FirstDiverged = i;
+            }
+        }
+    };
+
+    std::vector<std::thread> Threads;
+    for (u32 i = 1; i < NumThreads && i < NumSegments; i++)
+    {
+        Threads.emplace_back(Work);
+    }
+    Work();
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+    First.SegmentsRun = SegmentsRun;
+    return First;
+}
+
+#define M6502_INSTANTIATE_VERIFY(Variant) \
+    template m6502::u64 m6502::CheckpointLog::Record<m6502::Variant>(CPU& cpu, Mem& memory, u64 Cycles, u64 Interval); \
+    template m6502::VerifyReport m6502::RunVerifier::Verify<m6502::Variant>(const CheckpointLog& Log, u32 NumThreads); \
+    template m6502::VerifyReport m6502::RunVerifier::VerifySegment<m6502::Variant>(const CheckpointLog& Log, \
+        size_t Segment, CPU& cpu, Mem& memory);
+
+M6502_INSTANTIATE_VERIFY(NMOS6502)
+M6502_INSTANTIATE_VERIFY(CMOS65C02)
+M6502_INSTANTIATE_VERIFY(Ricoh2A03)
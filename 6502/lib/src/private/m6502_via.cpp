@@ -0,0 +1,254 @@
+#include "m6502_via.h"
+
+m6502::Via6522::Via6522(DeviceScheduler& Scheduler, DeviceMem& Memory, CPU& cpu, Word Base, u32 IrqSource)
+    : Scheduler(Scheduler), Memory(Memory), cpu(cpu), Base(Base), IrqSource(IrqSource),
+      T1Alarm(Scheduler, [this]() { Update(this->Scheduler.Now()); }),
+      T2Alarm(Scheduler, [this]() { Update(this->Scheduler.Now()); })
+{
+    Scheduler.Spawn(Bus());
+}
+
+m6502::DeviceTask m6502::Via6522::Bus()
+{
+    for (;;)
+    {
+        const BusAccess Access = co_await Scheduler.Access(Base, static_cast<Word>(Base + NUM_REGISTERS - 1));
+        const Byte Reg = static_cast<Byte>(Access.Address - Base);
+        if (Access.Kind == BusAccess::READ)
+        {
+            Memory[Access.Address] = Read(Reg);
+        }
+        else
+        {
+            Write(Reg, Access.Value);
+        }
+    }
+}
+
+void m6502::Via6522::T1At(u64 Cycle, Word& Value, bool& Reload) const
+{
+    u64 Elapsed = Cycle - T1Base;
+    u64 Start = T1Value;
+    if (T1Reload)
+    {
+        if (Elapsed == 0)
+        {
+            Value = T1Value;
+            Reload = true;
+            return;
+        }
+        Elapsed--;
+        Start = T1Latch;
+    }
+
+    Reload = false;
+    if (Elapsed <= Start)
+    {
+        Value = static_cast<Word>(Start - Elapsed);
+        return;
+    }
+
+    // cycles since the first underflow, which left $FFFF in the counter
+    Elapsed -= Start + 1;
+    if (Acr & ACR_T1_CONTINUOUS)
+    {
+        const u64 Phase = Elapsed % (u64(T1Latch) + 2);
+        Value = Phase == 0 ? 0xFFFF : static_cast<Word>(T1Latch - (Phase - 1));
+        Reload = Phase == 0;
+    }
+    else
+    {
+        Value = static_cast<Word>(0xFFFF - Elapsed);
+    }
+}
+
+void m6502::Via6522::RebaseT1(u64 Cycle)
+{
+    T1At(Cycle, T1Value, T1Reload);
+    T1Base = Cycle;
+    T1Next = T1FirstUnderflow();
+}
+
+void m6502::Via6522::Update(u64 Cycle)
+{
+    if (T1Armed && T1Next <= Cycle)
+    {
+        Ifr |= IRQ_T1;
+        if (Acr & ACR_T1_CONTINUOUS)
+        {
+            const u64 Period = u64(T1Latch) + 2;
+            T1Next += ((Cycle - T1Next) / Period + 1) * Period;
+        }
+        else
+        {
+            T1Armed = false;
+        }
+    }
+    if (T2Armed && T2Underflow() <= Cycle)
+    {
+        Ifr |= IRQ_T2;
+        T2Armed = false;
+    }
+    UpdateIrq();
+    Schedule();
+}
+
+void m6502::Via6522::UpdateIrq()
+{
+    if (Ifr & Ier & 0x7F)
+    {
+        cpu.Interrupts.RaiseIRQ(IrqSource);
+    }
+    else
+    {
+        cpu.Interrupts.ClearIRQ(IrqSource);
+    }
+}
+
+void m6502::Via6522::Schedule()
+{
+    // a flag that cannot interrupt is set when the cpu reads it
+    if (T1Armed && (Ier & IRQ_T1))
+    {
+        T1Alarm.Set(T1Next);
+    }
+    else
+    {
+        T1Alarm.Cancel();
+    }
+    if (T2Armed && (Ier & IRQ_T2))
+    {
+        T2Alarm.Set(T2Underflow());
+    }
+    else
+    {
+        T2Alarm.Cancel();
+    }
+}
+
+m6502::Byte m6502::Via6522::Read(Byte Reg)
+{
+    const u64 Cycle = Scheduler.Now();
+    Update(Cycle);
+
+    Word T1 = 0;
+    bool Reload = false;
+    switch (Reg & 15)
+    {
+    case ORB:
+        return (Orb & Ddrb) | (PinsB & ~Ddrb);
+    case ORA:
+    case ORA_NH:
+        return (Ora & Ddra) | (PinsA & ~Ddra);
+    case DDRB:
+        return Ddrb;
+    case DDRA:
+        return Ddra;
+    case T1CL:
+        Ifr &= ~IRQ_T1;
+        UpdateIrq();
+        T1At(Cycle, T1, Reload);
+        return T1 & 0xFF;
+    case T1CH:
+        T1At(Cycle, T1, Reload);
+        return T1 >> 8;
+    case T1LL:
+        return T1Latch & 0xFF;
+    case T1LH:
+        return T1Latch >> 8;
+    case T2CL:
+        Ifr &= ~IRQ_T2;
+        UpdateIrq();
+        return (T2Value - (Cycle - T2Base)) & 0xFF;
+    case T2CH:
+        return ((T2Value - (Cycle - T2Base)) >> 8) & 0xFF;
+    case SR:
+        return Sr;
+    case ACR:
+        return Acr;
+    case PCR:
+        return Pcr;
+    case IFR:
+        return Ifr | ((Ifr & Ier & 0x7F) ? IRQ_ANY : 0);
+    default:
+        return Ier | IRQ_ANY;
+    }
+}
+
+void m6502::Via6522::Write(Byte Reg, Byte Value)
+{
+    const u64 Cycle = Scheduler.Now();
+    Update(Cycle);
+
+    switch (Reg & 15)
+    {
+    case ORB:
+        Orb = Value;
+        break;
+    case ORA:
+    case ORA_NH:
+        Ora = Value;
+        break;
+    case DDRB:
+        Ddrb = Value;
+        break;
+    case DDRA:
+        Ddra = Value;
+        break;
+    case T1CL:
+    case T1LL:
+        RebaseT1(Cycle);
+        T1Latch = (T1Latch & 0xFF00) | Value;
+        T1Next = T1FirstUnderflow();
+        break;
+    case T1LH:
+        RebaseT1(Cycle);
+        T1Latch = static_cast<Word>((T1Latch & 0x00FF) | (Value << 8));
+        T1Next = T1FirstUnderflow();
+        Ifr &= ~IRQ_T1;
+        break;
+    case T1CH:
+        T1Latch = static_cast<Word>((T1Latch & 0x00FF) | (Value << 8));
+        T1Value = T1Latch;
+        T1Base = Cycle;
+        T1Reload = false;
+        T1Armed = true;
+        T1Next = T1FirstUnderflow();
+        Ifr &= ~IRQ_T1;
+        break;
+    case T2CL:
+        T2LatchLow = Value;
+        break;
+    case T2CH:
+        T2Value = static_cast<Word>((Value << 8) | T2LatchLow);
+        T2Base = Cycle;
+        T2Armed = true;
+        Ifr &= ~IRQ_T2;
+        break;
+    case SR:
+        Sr = Value;
+        break;
+    case ACR:
+        RebaseT1(Cycle);
+        Acr = Value;
+        break;
+    case PCR:
+        Pcr = Value;
+        break;
+    case IFR:
+        Ifr &= ~(Value & 0x7F);
+        break;
+    default:
+        if (Value & IRQ_ANY)
+        {
+            Ier |= Value & 0x7F;
+        }
+        else
+        {
+            Ier &= ~(Value & 0x7F);
+        }
+        break;
+    }
+    UpdateIrq();
+    Schedule();
+}
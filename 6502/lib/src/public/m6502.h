@@ -2,6 +2,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <atomic>
+#include <concepts>
+#include <type_traits>
+
+#include "m6502_opcodetable.h"
 
 namespace m6502
 {
@@ -11,10 +16,226 @@ namespace m6502
 
 	using u32 = unsigned int; //32bit
 	using s32 = signed int; //64 bit
+	using u64 = unsigned long long; //64 bit
+	using s64 = signed long long; //64 bit
 
 	struct Mem;
 	struct CPU;
 	struct StatusFlags;
+	struct InterruptLines;
+	struct MetricsShard;
+	struct DmaController;
+	struct DmaBus;
+
+	struct NMOS6502;
+	struct CMOS65C02;
+	struct Ricoh2A03;
+
+	// operand addressing of the opcode table, see CPU::AddressOf
+	enum class AddressMode : Byte
+	{
+		Implied, Immediate, ZeroPage, ZeroPageX, ZeroPageY, Absolute,
+		AbsoluteX, AbsoluteY, IndirectX, IndirectY, Indirect, ZeroPageIndirect,
+		Break,		// implied, followed by a padding byte that is skipped
+		Unknown
+	};
+
+	// which variants have an opcode, see m6502_opcodetable.h
+	enum class OpcodeSet : Byte
+	{
+		None, NMOS, CMOS
+	};
+
+	// a memory backend gets a hook called by CPU::Execute by defining it, the
+	// others compile the call away (see m6502_sanitizer.h and m6502_devices.h)
+
+	// before each instruction with its PC and the cycles run so far, false ends Execute
+	template<typename TMem>
+	concept HasInstructionHook = requires (TMem& memory, Word PC, s32 Elapsed)
+	{
+		{ memory.BeginInstruction(PC, Elapsed) } -> std::convertible_to<bool>;
+	};
+
+	// before an interrupt or dma request is serviced, with the PC it interrupts
+	template<typename TMem>
+	concept HasInterruptHook = requires (TMem& memory, Word PC)
+	{
+		memory.BeginInterrupt(PC);
+	};
+
+	// before Count bytes are pushed or popped at SP
+	template<typename TMem>
+	concept HasStackHooks = requires (const TMem& memory, Byte SP, Byte Count)
+	{
+		memory.CheckPush(SP, Count);
+		memory.CheckPop(SP, Count);
+	};
+}
+
+/**
+ * Variant policies, passed to CPU::Execute as a template argument so each
+ * chip gets its own interpreter with the differences resolved at compile time.
+ */
+struct m6502::NMOS6502
+{
+    static constexpr bool HasDecimalMode = true;
+    static constexpr bool HasJMPIndirectBug = true; // JMP ($xxFF) reads the high byte from $xx00
+    static constexpr bool HasCMOSInstructions = false;
+};
+
+struct m6502::CMOS65C02
+{
+    static constexpr bool HasDecimalMode = true;
+    static constexpr bool HasJMPIndirectBug = false;
+    static constexpr bool HasCMOSInstructions = true; // STZ, PHX/PHY/PLX/PLY and (zp) addressing
+};
+
+// NES cpu, a 6502 with the decimal mode adder removed
+struct m6502::Ricoh2A03
+{
+    static constexpr bool HasDecimalMode = false;
+    static constexpr bool HasJMPIndirectBug = true;
+    static constexpr bool HasCMOSInstructions = false;
+};
+
+struct m6502::StatusFlags
+{
+    Byte C : 1; // carry flag
+    Byte Z : 1; // zero flag
+    Byte I : 1; // interrupt disable flag
+    Byte D : 1; // decimal mode flag
+    Byte B : 1; // break command flag (only exists in the copy pushed to the stack)
+    Byte Unused : 1; // always reads as 1 when pushed
+    Byte V : 1; // overflow flag
+    Byte N : 1; // negative flag
+};
+
+/**
+ * IRQ and NMI lines of the cpu. Devices and other threads raise interrupts
+ * through one atomic word so the cpu only has to test a single value at
+ * each instruction boundary to know whether anything is pending.
+ * Each IRQ source owns one of the low bits (the line is level triggered and
+ * stays asserted while any source holds it), NMI is edge triggered and is
+ * latched until the cpu services it. The DMA bit halts the cpu for a
+ * transfer of its DmaController (see m6502_dma.h).
+ */
+struct m6502::InterruptLines
+{
+    static constexpr u32 IRQ_MASK = 0x3FFFFFFF;
+    static constexpr u32 DMA_BIT = 0x40000000;
+    static constexpr u32 NMI_BIT = 0x80000000;
+
+    std::atomic<u32> Pending{0};
+
+    InterruptLines() = default;
+
+    InterruptLines(const InterruptLines& Other)
+        : Pending(Other.Pending.load(std::memory_order_relaxed))
+    {
+    }
+
+    InterruptLines& operator=(const InterruptLines& Other)
+    {
+        Pending.store(Other.Pending.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    // assert the irq line on behalf of one or more sources
+    void RaiseIRQ(u32 SourceMask = 1)
+    {
+        Pending.fetch_or(SourceMask & IRQ_MASK, std::memory_order_release);
+    }
+
+    // release the irq line for one or more sources
+    void ClearIRQ(u32 SourceMask = 1)
+    {
+        Pending.fetch_and(~(SourceMask & IRQ_MASK), std::memory_order_release);
+    }
+
+    // a dma transfer wants the bus
+    void RaiseDMA()
+    {
+        Pending.fetch_or(DMA_BIT, std::memory_order_release);
+    }
+
+    void ClearDMA()
+    {
+        Pending.fetch_and(~DMA_BIT, std::memory_order_release);
+    }
+
+    // signal a falling edge on the nmi line
+    void RaiseNMI()
+    {
+        Pending.fetch_or(NMI_BIT, std::memory_order_release);
+    }
+
+    // nothing can raise a line during constant evaluation, so both are no-ops there
+    constexpr bool Any() const
+    {
+        if (std::is_constant_evaluated())
+        {
+            return false;
+        }
+        return Pending.load(std::memory_order_relaxed) != 0;
+    }
+
+    constexpr void Clear()
+    {
+        if (!std::is_constant_evaluated())
+        {
+            Pending.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * Counters of one thread or one machine, see m6502_metrics.h. A shard only
+ * ever has one writer, so adding is a relaxed load and store instead of a
+ * locked instruction, and each shard has its own cache line.
+ */
+struct alignas(64) m6502::MetricsShard
+{
+    std::atomic<u64> Instructions{0};
+    std::atomic<u64> Cycles{0};
+    std::atomic<u64> Interrupts{0};
+    std::atomic<u64> UnhandledOpcodes{0};
+
+    static void Add(std::atomic<u64>& Counter, u64 Value)
+    {
+        Counter.store(Counter.load(std::memory_order_relaxed) + Value, std::memory_order_relaxed);
+    }
+
+    void Record(u64 InstructionsRun, u64 CyclesRun, u64 InterruptsTaken)
+    {
+        Add(Instructions, InstructionsRun);
+        Add(Cycles, CyclesRun);
+        if (InterruptsTaken != 0)
+        {
+            Add(Interrupts, InterruptsTaken);
+        }
+    }
+};
+
+namespace m6502
+{
+	// shard of the calling thread, created on first use
+	inline constinit thread_local MetricsShard* ThreadMetrics = nullptr;
+
+	// shard of the machine the calling thread is running, if any (see MachineMetricsScope)
+	inline constinit thread_local MetricsShard* MachineMetrics = nullptr;
+
+	MetricsShard* RegisterThreadMetrics();
+
+	// called by CPU::Execute once per call
+	inline void CountExecute(u64 InstructionsRun, u64 CyclesRun, u64 InterruptsTaken)
+	{
+		MetricsShard* Shard = ThreadMetrics != nullptr ? ThreadMetrics : RegisterThreadMetrics();
+		Shard->Record(InstructionsRun, CyclesRun, InterruptsTaken);
+		if (MachineMetrics != nullptr)
+		{
+			MachineMetrics->Record(InstructionsRun, CyclesRun, InterruptsTaken);
+		}
+	}
 }
 
 struct m6502::Mem
@@ -22,7 +243,7 @@ struct m6502::Mem
     static constexpr u32 MAX_MEM = 1024 * 64;
     Byte Data[MAX_MEM];
 
-    void Initialize()
+    constexpr void Initialize()
     {
         for(u32 i = 0; i < MAX_MEM; i++)
         {
@@ -31,16 +252,55 @@ struct m6502::Mem
     }
     
     // read 1 byte
-    Byte operator[](u32 Address) const
+    constexpr Byte operator[](u32 Address) const
     {   
         return Data[Address];
     }
 
     // write 1 byte
-    Byte& operator[](u32 Address)
+    constexpr Byte& operator[](u32 Address)
     {   
         return Data[Address];
     }
+
+    // read 1 byte on behalf of the cpu
+    constexpr Byte Read(Word Address) const
+    {
+        return Data[Address];
+    }
+
+    // write 1 byte on behalf of the cpu
+    constexpr void Write(Word Address, Byte Value)
+    {
+        Data[Address] = Value;
+    }
+};
+
+/**
+ * The memory backend Execute runs on, as a DmaController sees it: bytes go
+ * through the backend's Read and Write so watches, shadows and dirty bits
+ * see the transfer, only plain Mem hands out its bytes for a memmove.
+ */
+struct m6502::DmaBus
+{
+    void* Memory = nullptr;
+    Byte (*Read)(const void* Memory, Word Address) = nullptr;
+    void (*Write)(void* Memory, Word Address, Byte Value) = nullptr;
+    Byte* Flat = nullptr;
+
+    template<typename TMem>
+    static DmaBus Of(TMem& memory)
+    {
+        DmaBus Bus;
+        Bus.Memory = &memory;
+        Bus.Read = [](const void* Memory, Word Address) { return static_cast<const TMem*>(Memory)->Read(Address); };
+        Bus.Write = [](void* Memory, Word Address, Byte Value) { static_cast<TMem*>(Memory)->Write(Address, Value); };
+        if constexpr (std::is_same_v<TMem, Mem>)
+        {
+            Bus.Flat = memory.Data;
+        }
+        return Bus;
+    }
 };
 
 struct m6502::CPU
@@ -50,204 +310,224 @@ struct m6502::CPU
 
     Byte A, X, Y; //accumulator, Index Register X, Index Register Y
 
-    //processor status flags
-    union
+    //processor status flags, GetPS / SetPS for the packed byte
+    StatusFlags Flag;
+
+    InterruptLines Interrupts;
+    DmaController* Dma = nullptr;   // charges Execute for the cycles its transfers take
+
+    static constexpr Word
+    NMI_VECTOR = 0xFFFA,
+    RESET_VECTOR = 0xFFFC,
+    IRQ_VECTOR = 0xFFFE;
+
+    static constexpr Byte
+    FLAG_BREAK = 0b00010000,
+    FLAG_UNUSED = 0b00100000;
+
+    // status register as pushed to the stack, bit 0 carry to bit 7 negative
+    constexpr Byte GetPS() const
     {
-        Byte PS;
-        
-        Byte C: 1; // carry flag
-        Byte Z: 1; // zero flag
-        Byte I: 1; // interrupt disable flag
-        Byte D: 1; // decimal mode flag
-        Byte B: 1; // break command flag
-        Byte V: 1; // overflow flag
-        Byte N: 1; // negative flag
-    };
+        return Flag.C | (Flag.Z << 1) | (Flag.I << 2) | (Flag.D << 3)
+            | (Flag.B << 4) | (Flag.Unused << 5) | (Flag.V << 6) | (Flag.N << 7);
+    }
+
+    constexpr void SetPS(Byte Value)
+    {
+        Flag.C = Value & 1;
+        Flag.Z = (Value >> 1) & 1;
+        Flag.I = (Value >> 2) & 1;
+        Flag.D = (Value >> 3) & 1;
+        Flag.B = (Value >> 4) & 1;
+        Flag.Unused = (Value >> 5) & 1;
+        Flag.V = (Value >> 6) & 1;
+        Flag.N = (Value >> 7) & 1;
+    }
 
-    void Reset(Mem& memory)
+    template<typename TMem>
+    constexpr void Reset(TMem& memory)
     {
         PC = 0xFFFC;
         SP = 0xFF;
-        D = 0;
-        C = Z = I = D = B = V = N = 0; //clear all flags on reset
+        SetPS(0); //clear all flags on reset
         A = X = Y = 0;
+        Interrupts.Clear();
         memory.Initialize();
     }
 
     // grabs instruction byte, increments PC
-    Byte FetchByte(s32& Cycles, Mem& memory)
+    // the bus helpers do not count cycles, Execute charges each opcode what the table gives
+    template<typename TMem>
+    constexpr Byte FetchByte(const TMem& memory)
     {
-        Byte Data = memory[PC];
+        Byte Data = memory.Read(PC);
         PC++;
-        Cycles--;
         return Data;
     }
 
     // grabs instruction byte, increments PC
-    Word FetchWord(s32& Cycles, Mem& memory)
+    template<typename TMem>
+    constexpr Word FetchWord(const TMem& memory)
     {
         //6502 is little endian (first byte is least significant)
-        Word Data = memory[PC];
+        Word Data = memory.Read(PC);
         PC++;
 
-        Data |= (memory[PC] << 8);
+        Data |= (memory.Read(PC) << 8);
         PC++;
-        Cycles-=2;
         return Data;
     }
 
     // read byte without incrementing PC
-    Byte ReadByte(s32& Cycles, Word Address, const Mem& memory)
+    template<typename TMem>
+    constexpr Byte ReadByte(Word Address, const TMem& memory)
     {
-        Byte Data = memory[Address];
-        Cycles--;
-        return Data;
+        return memory.Read(Address);
     }
 
     // read word without incrementing PC
-    Word ReadWord(s32& Cycles, Word Address, const Mem& memory)
+    template<typename TMem>
+    constexpr Word ReadWord(Word Address, const TMem& memory)
     {
-        Byte LoByte = ReadByte(Cycles,Address,memory);
-        Byte HiByte = ReadByte(Cycles,Address+1,memory);
+        Byte LoByte = ReadByte(Address,memory);
+        Byte HiByte = ReadByte(Address+1,memory);
         return LoByte | (HiByte << 8);
     }
 
     //write one byte to memory
-    void WriteByte(Byte Value, s32& Cycles, Word Address, Mem& memory)
+    template<typename TMem>
+    constexpr void WriteByte(Byte Value, Word Address, TMem& memory)
     {
-        memory[Address] = Value;
-        Cycles--;
+        memory.Write(Address, Value);
     }
 
     // write two bytes to memory
-    void WriteWord(Word Value, s32& Cycles, Word Address, Mem& memory)
+    template<typename TMem>
+    constexpr void WriteWord(Word Value, Word Address, TMem& memory)
     {
-        memory[Address] = Value & 0xFF;
-        memory[Address+1] = (Value >> 8);
-        Cycles -= 2;
+        memory.Write(Address, Value & 0xFF);
+        memory.Write(Address+1, (Value >> 8));
     }
 
     //return stack pointer as full 16 bit address
-    Word SPToWord() const
+    constexpr Word SPToWord() const
     {
         return 0x100 | SP;
     }
 
     //push the pc -1 onto stack
-    void PushPCToStack(s32& Cycles, Mem& memory)
+    template<typename TMem>
+    constexpr void PushPCToStack(TMem& memory)
+    {
+        PushWordToStack(PC-1, memory);
+    }
+
+    //push a word onto the stack, high byte first
+    template<typename TMem>
+    constexpr void PushWordToStack(Word Value, TMem& memory)
     {
-        WriteWord(PC-1, Cycles, SPToWord()-1, memory);
+        if constexpr (HasStackHooks<TMem>)
+        {
+            memory.CheckPush(SP, 2);
+        }
+        WriteWord(Value, SPToWord()-1, memory);
         SP-=2;
     }
 
+    //push one byte onto the stack
+    template<typename TMem>
+    constexpr void PushByteToStack(Byte Value, TMem& memory)
+    {
+        if constexpr (HasStackHooks<TMem>)
+        {
+            memory.CheckPush(SP, 1);
+        }
+        WriteByte(Value, SPToWord(), memory);
+        SP--;
+    }
+
+    //pop one byte from the stack
+    template<typename TMem>
+    constexpr Byte PopByteFromStack(const TMem& memory)
+    {
+        if constexpr (HasStackHooks<TMem>)
+        {
+            memory.CheckPop(SP, 1);
+        }
+        SP++;
+        return ReadByte(SPToWord(), memory);
+    }
+
     //pop the pc -1 from stack
-    Word PopWordFromStack(s32& Cycles, Mem& memory)
+    template<typename TMem>
+    constexpr Word PopWordFromStack(const TMem& memory)
     {
-        Word Address = ReadWord(Cycles,SPToWord()+1, memory);
+        if constexpr (HasStackHooks<TMem>)
+        {
+            memory.CheckPop(SP, 2);
+        }
+        Word Address = ReadWord(SPToWord()+1, memory);
         SP+=2;
-        Cycles--;
         return Address;
     }
 
 
 
-    //opcodes
-    static constexpr Byte 
-    //Load Accumulator
-    INS_LDA_IM = 0xA9,
-    INS_LDA_ZP = 0xA5,
-    INS_LDA_ZPX = 0xB5,
-    INS_LDA_ABS = 0xAD,
-    INS_LDA_ABSX = 0xBD,
-    INS_LDA_ABSY = 0xB9,
-    INS_LDA_INDX = 0xA1,
-    INS_LDA_INDY = 0xB1,
-
-    // Load X Register
-    INS_LDX_IM = 0xA2,
-    INS_LDX_ZP = 0xA6,
-    INS_LDX_ZPY = 0xB6,
-    INS_LDX_ABS = 0xAE,
-    INS_LDX_ABSY = 0xBE,
-
-    // Load Y Register
-    INS_LDY_IM = 0xA0,
-    INS_LDY_ZP = 0xA4,
-    INS_LDY_ZPX = 0xB4,
-    INS_LDY_ABS = 0xAC,
-    INS_LDY_ABSX = 0xBC,
-
-    //Store Accumulator in Memory
-    INS_STA_ZP = 0x85,
-    INS_STA_ZPX = 0x95,
-    INS_STA_ABS = 0x8D,
-    INS_STA_ABSX = 0x9D,
-    INS_STA_ABSY = 0x99,
-    INS_STA_INDX = 0x81,
-    INS_STA_INDY = 0x91,
-
-    //Store X Register in Memory
-    INS_STX_ZP = 0x86,
-    INS_STX_ZPY = 0x96,
-    INS_STX_ABS = 0x8E,
-
-    //Store Y Register in Memory
-    INS_STY_ZP = 0x84,
-    INS_STY_ZPX = 0x94,
-    INS_STY_ABS = 0x8C,
-
-    //Jump to Subroutine
-    INS_JSR = 0x20,
-    
-    //Return from Subroutine
-    INS_RTS = 0x60,
-    
-    
-    
-    ;
+    //opcodes, INS_LDA_IM and so on, one per row of m6502_opcodetable.h
+#define M6502_OPCODE_CONSTANT(Name, Opcode, ...) static constexpr Byte INS_##Name = Opcode;
+    M6502_OPCODE_TABLE(M6502_OPCODE_CONSTANT)
+#undef M6502_OPCODE_CONSTANT
 
 
 
-    void LoadRegisterSetStatus(Byte Register)
+    constexpr void LoadRegisterSetStatus(Byte Register)
     {
-        Z = (Register == 0);
-        N = (Register & 0b10000000) > 0;
+        Flag.Z = (Register == 0);
+        Flag.N = (Register & 0b10000000) > 0;
     }
 
-    /** @return the number of cycles that were used */
-	s32 Execute( s32 Cycles, Mem& memory );
-
-    // get address from zero page
-    Word AddrZeroPage(s32& Cycles, Mem& memory);
-
-    //get address from zero page with x offset
-    Word AddrZeroPageX(s32& Cycles, Mem& memory);
-
-    //get address from zero page with y offset
-    Word AddrZeroPageY(s32& Cycles, Mem& memory);
-
-    //get address from absolute
-    Word AddrAbsolute(s32& Cycles, Mem& memory);
-
-    // get address from absolute with x offset
-    Word AddrAbsoluteX(s32& Cycles, Mem& memory);
-
-    // get address from absolute with x offset, always consume 5 cycles
-    Word AddrAbsoluteX5(s32& Cycles, Mem& memory);
-
-    //get address from absolute with y offset
-    Word AddrAbsoluteY(s32& Cycles, Mem& memory);
-
-    //get address from absolute with y offset, always consume 5 cycles
-    Word AddrAbsoluteY5(s32& Cycles, Mem& memory);
-
-    //get addresss from Indexed Indirect X
-    Word AddrIndirectX(s32& Cycles, Mem& memory);
-
-    //get address from Indexed Indirect Y
-    Word AddrIndirectY(s32& Cycles, Mem& memory);
-
-    //get address from Indexed Indirect Y, always consume 6 cycles
-    Word AddrIndirectY6(s32& Cycles, Mem& memory);
+    // cycles of an irq or nmi entry, BRK takes the same from its table row
+    static constexpr s32 INTERRUPT_CYCLES = 7;
+
+    // push pc and status then jump through Vector
+    template<typename TMem>
+    constexpr void Interrupt(Word Vector, Byte PushedFlags, TMem& memory);
+
+    // run a pending dma burst, then take a pending nmi, or irq when not masked, between instructions, true if an interrupt was taken
+    template<typename TMem>
+    bool ServiceInterrupts(s32& Cycles, TMem& memory);
+
+    /** TVariant selects the chip (NMOS6502, CMOS65C02, Ricoh2A03)
+     *  TMem is any memory backend with Read/Write/Initialize (Mem, SparseMem),
+     *  backends that define the HasInstructionHook family of hooks get them called.
+     *  Every opcode of m6502_opcodetable.h gets its case of the dispatch and
+     *  is charged the cycles of its row.
+     *  With Mem it can run in constant evaluation, to compute tables at
+     *  build time, as long as the program sticks to implemented opcodes
+     *  @return the number of cycles that were used */
+    template<typename TVariant = NMOS6502, typename TMem = Mem>
+	constexpr s32 Execute( s32 Cycles, TMem& memory );
+
+    // run the pending dma burst on Bus, out of line, the cycles it took
+    u32 ServiceDMA(const DmaBus& Bus);
+
+    // the default case of Execute, kept out of line so the dispatch has no io
+    static void UnhandledInstruction(Byte Instruction);
+
+    // ADC / SBC on the accumulator, decimal mode only where TVariant has it
+    template<typename TVariant>
+    constexpr void AddWithCarry(Byte Operand);
+
+    template<typename TVariant>
+    constexpr void SubtractWithCarry(Byte Operand);
+
+    /** Fetch the operand of an instruction in Mode and work out the address it
+     *  names. Immediate gives the address of the operand byte, Indirect the
+     *  JMP target (with the NMOS page wrap bug where TVariant has it), Implied
+     *  and Break nothing. Only the reads the chip makes reach memory.
+     *  @param PageCrossed set when an indexed address left the page of its base */
+    template<AddressMode Mode, typename TVariant, typename TMem>
+    constexpr Word AddressOf(const TMem& memory, bool& PageCrossed);
 };
 
+#include "m6502_execute.h"
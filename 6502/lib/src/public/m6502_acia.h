@@ -0,0 +1,117 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+
+#include "m6502_devices.h"
+
+namespace m6502
+{
+	struct Acia6551;
+}
+
+/**
+ * MOS 6551 ACIA on a DeviceMem, its 4 registers at Base. Nothing is
+ * stepped per bit: a character takes CharacterCycles, so the cycle its
+ * transmission ends or the next received byte arrives is known when it
+ * starts. Those cycles go to the DeviceScheduler when something has to
+ * happen on time (a byte leaving for OnTransmit, a receive interrupt), a
+ * polled receiver is only brought up to date when the cpu reads a
+ * register. Accesses happen at the cycle their instruction starts.
+ *
+ * A byte written while the transmitter is idle goes straight to the shift
+ * register, otherwise it waits in the data register (TDRE clear) until the
+ * one being sent is done. Each time the data register empties the transmit
+ * interrupt is flagged, and each received byte flags the receive interrupt,
+ * when the command register enables them; reading status clears the flag.
+ * A byte arriving while RDRF is still set is lost and sets OVERRUN. The
+ * modem lines, parity checking, echo and break are not emulated, baud rate
+ * 0 (the external clock) runs at 115200.
+ */
+struct m6502::Acia6551
+{
+    enum Register : Byte
+    {
+        DATA, STATUS, COMMAND, CONTROL,
+        NUM_REGISTERS
+    };
+
+    enum StatusBit : Byte
+    {
+        PARITY_ERROR = 0x01,
+        FRAMING_ERROR = 0x02,
+        OVERRUN = 0x04,
+        RDRF = 0x08,        // receive data register full
+        TDRE = 0x10,        // transmit data register empty
+        DCD = 0x20,
+        DSR = 0x40,
+        IRQ = 0x80,
+    };
+
+    // IrqSource is the InterruptLines bit the chip holds the irq line with
+    Acia6551(DeviceScheduler& Scheduler, DeviceMem& Memory, CPU& cpu, Word Base, u32 IrqSource = 2,
+        u32 ClockHz = 1000000);
+
+    Acia6551(const Acia6551&) = delete;
+    Acia6551& operator=(const Acia6551&) = delete;
+
+    // cycles of one character (start, data, parity and stop bits) for these register values
+    static u64 CharacterCycles(Byte Control, Byte Command, u32 ClockHz);
+
+    static bool ReceiveIrqEnabled(Byte Command)
+    {
+        return (Command & 0x03) == 0x01;
+    }
+
+    static bool TransmitIrqEnabled(Byte Command)
+    {
+        return (Command & 0x0D) == 0x05;
+    }
+
+    // bytes arriving on the receive line, the first one a character time from now
+    void Receive(const Byte* Bytes, size_t Size);
+
+    // a register access as the cpu makes it, at the scheduler's current cycle
+    Byte Read(Byte Reg);
+    void Write(Byte Reg, Byte Value);
+
+    // each byte sent, with the cycle its last stop bit went out
+    std::function<void(Byte Value, u64 Cycle)> OnTransmit;
+
+private:
+    DeviceTask Bus();
+
+    // finish the characters due by Cycle
+    void Update(u64 Cycle);
+    void UpdateIrq();
+    void Schedule();
+
+    u64 CharacterCycles() const
+    {
+        return CharacterCycles(Control, Command, ClockHz);
+    }
+
+    DeviceScheduler& Scheduler;
+    DeviceMem& Memory;
+    CPU& cpu;
+    Word Base;
+    u32 IrqSource;
+    u32 ClockHz;
+
+    Byte Status = 0;            // TDRE comes from TxDataFull
+    Byte Command = 0;
+    Byte Control = 0;
+
+    Byte TxData = 0;
+    bool TxDataFull = false;
+    Byte TxShift = 0;
+    bool TxBusy = false;
+    u64 TxDone = 0;             // cycle the byte in the shift register is sent
+
+    Byte RxData = 0;
+    std::deque<Byte> RxLine;
+    u64 RxNext = 0;             // cycle the front of RxLine arrives
+
+    DeviceAlarm TxAlarm;
+    DeviceAlarm RxAlarm;
+};
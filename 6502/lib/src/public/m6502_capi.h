@@ -0,0 +1,54 @@
+#pragma once
+
+/**
+ * Stable C interface to the emulator for FFI callers (Python, Rust, ...).
+ * A machine is one CPU with its own 64KB of memory. The memory is handed out
+ * as a raw pointer so callers can read and write it without copying.
+ * Bump M6502_ABI_VERSION whenever a struct or signature here changes.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define M6502_ABI_VERSION 1
+
+typedef struct m6502_machine m6502_machine;
+
+typedef struct m6502_regs
+{
+    uint16_t pc;
+    uint8_t sp;
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t ps;
+} m6502_regs;
+
+uint32_t m6502_abi_version(void);
+
+// new machine, already reset, NULL when out of memory
+m6502_machine* m6502_create(void);
+void m6502_destroy(m6502_machine* machine);
+
+void m6502_reset(m6502_machine* machine);
+
+// run at least cycles cycles, returns the number of cycles used
+int32_t m6502_execute(m6502_machine* machine, int32_t cycles);
+
+void m6502_get_regs(const m6502_machine* machine, m6502_regs* regs);
+void m6502_set_regs(m6502_machine* machine, const m6502_regs* regs);
+
+// the machine's memory, valid until m6502_destroy
+uint8_t* m6502_memory(m6502_machine* machine);
+uint32_t m6502_memory_size(void);
+
+void m6502_raise_irq(m6502_machine* machine, uint32_t source_mask);
+void m6502_clear_irq(m6502_machine* machine, uint32_t source_mask);
+void m6502_raise_nmi(m6502_machine* machine);
+
+#ifdef __cplusplus
+}
+#endif
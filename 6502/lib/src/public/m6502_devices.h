@@ -0,0 +1,445 @@
+#pragma once
+
+#include <coroutine>
+#include <functional>
+#include <limits.h>
+#include <vector>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct FramePool;
+	struct DeviceTask;
+	struct BusAccess;
+	struct DeviceMem;
+	struct DeviceScheduler;
+	struct DeviceAlarm;
+}
+
+/**
+ * Free lists of coroutine frames in 64 byte size classes, one pool per
+ * thread. A device that keeps starting the same nested tasks takes its
+ * frames from here after the first time round, so steady state emulation
+ * does not touch the heap. Frames larger than the biggest class go to
+ * the heap directly.
+ */
+struct m6502::FramePool
+{
+    static constexpr size_t GRANULE = 64;
+    static constexpr size_t NUM_CLASSES = 16;
+
+    ~FramePool();
+
+    static FramePool& ThisThread();
+
+    void* Allocate(size_t Size);
+    void Free(void* Frame, size_t Size);
+
+    // frames that had to come from the heap so far
+    u64 HeapAllocations() const
+    {
+        return NumHeapAllocations;
+    }
+
+private:
+    struct FreeFrame
+    {
+        FreeFrame* Next;
+    };
+
+    FreeFrame* FreeLists[NUM_CLASSES] = {};
+    u64 NumHeapAllocations = 0;
+};
+
+/**
+ * A device model written as a coroutine. It starts when it is given to
+ * DeviceScheduler::Spawn and runs until it co_awaits the scheduler (a cycle
+ * count or a bus access). Another DeviceTask can be co_awaited too, which
+ * runs it to completion inside the awaiting device.
+ */
+struct m6502::DeviceTask
+{
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type
+    {
+        std::coroutine_handle<> Continuation;   // device that co_awaits this task
+
+        DeviceTask get_return_object()
+        {
+            return DeviceTask(Handle::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(Handle Finished) noexcept
+            {
+                std::coroutine_handle<> Next = Finished.promise().Continuation;
+                return Next ? Next : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept
+            {
+            }
+        };
+
+        FinalAwaiter final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+        }
+
+        void unhandled_exception();
+
+        static void* operator new(size_t Size)
+        {
+            return FramePool::ThisThread().Allocate(Size);
+        }
+
+        static void operator delete(void* Frame, size_t Size)
+        {
+            FramePool::ThisThread().Free(Frame, Size);
+        }
+    };
+
+    DeviceTask() = default;
+
+    explicit DeviceTask(Handle Frame)
+        : Frame(Frame)
+    {
+    }
+
+    DeviceTask(DeviceTask&& Other) noexcept
+        : Frame(Other.Frame)
+    {
+        Other.Frame = nullptr;
+    }
+
+    DeviceTask& operator=(DeviceTask&& Other) noexcept
+    {
+        if (this != &Other)
+        {
+            if (Frame)
+            {
+                Frame.destroy();
+            }
+            Frame = Other.Frame;
+            Other.Frame = nullptr;
+        }
+        return *this;
+    }
+
+    ~DeviceTask()
+    {
+        if (Frame)
+        {
+            Frame.destroy();
+        }
+    }
+
+    bool Done() const
+    {
+        return !Frame || Frame.done();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return Done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> Awaiting) noexcept
+    {
+        Frame.promise().Continuation = Awaiting;
+        return Frame;
+    }
+
+    void await_resume() const noexcept
+    {
+    }
+
+private:
+    friend struct DeviceScheduler;
+
+    Handle Frame;
+};
+
+// the cpu access a device waited for
+struct m6502::BusAccess
+{
+    enum AccessKind : Byte
+    {
+        READ = 1,
+        WRITE = 2,
+        ANY = READ | WRITE,
+    };
+
+    Word Address = 0;
+    Byte Value = 0;             // the byte written, for reads what ram holds before the device runs
+    AccessKind Kind = READ;
+};
+
+/**
+ * 64KB of ram where devices can watch address ranges. A watched read
+ * resumes the waiting devices before the cpu gets the byte, so they can
+ * put their register value in ram; a watched write resumes them after the
+ * byte has landed. Execute tells it how far into the slice each instruction
+ * starts, which gives devices the cycle of an access.
+ */
+struct m6502::DeviceMem
+{
+    static constexpr u32 MAX_MEM = Mem::MAX_MEM;
+
+    DeviceMem();
+
+    DeviceMem(const DeviceMem&) = delete;
+    DeviceMem& operator=(const DeviceMem&) = delete;
+
+    void Initialize();
+
+    // read 1 byte
+    Byte operator[](u32 Address) const
+    {
+        return Data[Address];
+    }
+
+    // write 1 byte
+    Byte& operator[](u32 Address)
+    {
+        return Data[Address];
+    }
+
+    bool IsWatched(Word Address) const
+    {
+        return (WatchBits[Address >> 5] >> (Address & 31)) & 1;
+    }
+
+    // read 1 byte on behalf of the cpu
+    Byte Read(Word Address) const
+    {
+        if (IsWatched(Address))
+        {
+            Notify(Address, Data[Address], BusAccess::READ);
+        }
+        return Data[Address];
+    }
+
+    // write 1 byte on behalf of the cpu
+    void Write(Word Address, Byte Value)
+    {
+        Data[Address] = Value;
+        if (IsWatched(Address))
+        {
+            Notify(Address, Value, BusAccess::WRITE);
+        }
+    }
+
+    // hook called by CPU::Execute with the cycles run so far, false ends the slice
+    bool BeginInstruction(Word /*PC*/, s32 Elapsed)
+    {
+        SliceElapsed = Elapsed;
+        return Elapsed < SliceLimit;
+    }
+
+private:
+    friend struct DeviceScheduler;
+
+    void Notify(Word Address, Byte Value, BusAccess::AccessKind Kind) const;
+
+    DeviceScheduler* Scheduler = nullptr;
+    s32 SliceElapsed = 0;
+    s32 SliceLimit = INT_MAX;
+    u32 WatchBits[MAX_MEM / 32];
+    Byte Data[MAX_MEM];
+};
+
+/**
+ * Runs a cpu on a DeviceMem together with device coroutines. The cpu runs
+ * in slices that end on the next cycle a device asked to wake at, so a
+ * device costs nothing between its events instead of a callback per cycle.
+ * Devices wake at the first instruction boundary at or after their cycle,
+ * one that asks for an earlier cycle from a bus access ends the running
+ * slice early. Inside a bus access Now is the cycle the instruction started
+ * on. Waiting devices are kept in vectors that only grow, so once every
+ * device has waited once nothing more is allocated.
+ */
+struct m6502::DeviceScheduler
+{
+    explicit DeviceScheduler(DeviceMem& Memory);
+    ~DeviceScheduler();
+
+    DeviceScheduler(const DeviceScheduler&) = delete;
+    DeviceScheduler& operator=(const DeviceScheduler&) = delete;
+
+    // start a device, it runs until its first co_await
+    void Spawn(DeviceTask Task);
+
+    // cycles run so far
+    u64 Now() const
+    {
+        return Cycle + Memory.SliceElapsed;
+    }
+
+    struct DelayAwaiter
+    {
+        DeviceScheduler& Scheduler;
+        u64 Cycles;
+
+        bool await_ready() const noexcept
+        {
+            return Cycles == 0;
+        }
+
+        void await_suspend(std::coroutine_handle<> Device)
+        {
+            Scheduler.WakeAt(Scheduler.Now() + Cycles, Device);
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    struct AccessAwaiter
+    {
+        DeviceScheduler& Scheduler;
+        Word First;
+        Word Last;
+        BusAccess::AccessKind Kind;
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> Device)
+        {
+            Scheduler.Watch(First, Last, Kind, Device);
+        }
+
+        BusAccess await_resume() const noexcept
+        {
+            return Scheduler.LastAccess;
+        }
+    };
+
+    // co_await to sleep for Cycles cycles
+    DelayAwaiter Delay(u64 Cycles)
+    {
+        return { *this, Cycles };
+    }
+
+    // co_await for the next cpu access to [First, Last], gives the BusAccess
+    AccessAwaiter Access(Word First, Word Last, BusAccess::AccessKind Kind = BusAccess::ANY)
+    {
+        return { *this, First, Last, Kind };
+    }
+
+    AccessAwaiter Access(Word Address, BusAccess::AccessKind Kind = BusAccess::ANY)
+    {
+        return { *this, Address, Address, Kind };
+    }
+
+    /** Run the cpu and the devices for at least Cycles cycles
+     *  @return the number of cycles that were used */
+    template<typename TVariant = NMOS6502>
+    u64 Run(CPU& cpu, u64 Cycles);
+
+    // devices waiting for a cycle or a bus access
+    size_t NumWaiting() const
+    {
+        return Timers.size() + Watches.size();
+    }
+
+private:
+    friend struct DeviceMem;
+
+    struct Timer
+    {
+        u64 Cycle;
+        u64 Sequence;   // devices due on the same cycle wake in the order they waited
+        std::coroutine_handle<> Device;
+    };
+
+    struct WatchEntry
+    {
+        Word First;
+        Word Last;
+        BusAccess::AccessKind Kind;
+        u64 Since;      // accesses before this one do not wake it
+        std::coroutine_handle<> Device;
+    };
+
+    void WakeAt(u64 WakeCycle, std::coroutine_handle<> Device);
+    void Watch(Word First, Word Last, BusAccess::AccessKind Kind, std::coroutine_handle<> Device);
+    void OnAccess(Word Address, Byte Value, BusAccess::AccessKind Kind);
+    void UpdateWatchBits(u32 First, u32 Last);
+    void ResumeDueTimers();
+
+    DeviceMem& Memory;
+    u64 Cycle = 0;
+    u64 NextSequence = 0;
+    u64 NumAccesses = 0;
+    BusAccess LastAccess;
+    std::vector<Timer> Timers;          // min heap on (Cycle, Sequence)
+    std::vector<WatchEntry> Watches;
+    std::vector<DeviceTask> Devices;
+};
+
+/**
+ * A wake up a device can move or cancel, for events the cpu can reprogram
+ * such as a timer. The alarm keeps one task sleeping on the scheduler:
+ * moving it later, or setting it again from its own callback, reuses that
+ * task, moving it earlier starts a new one and the old one ends when it
+ * wakes. The alarm has to outlive the scheduler's runs.
+ */
+struct m6502::DeviceAlarm
+{
+    DeviceAlarm(DeviceScheduler& Scheduler, std::function<void()> Callback);
+
+    DeviceAlarm(const DeviceAlarm&) = delete;
+    DeviceAlarm& operator=(const DeviceAlarm&) = delete;
+
+    // run the callback at the first instruction boundary at or after WakeCycle
+    void Set(u64 WakeCycle);
+
+    void Cancel()
+    {
+        Armed = false;
+    }
+
+    bool IsSet() const
+    {
+        return Armed;
+    }
+
+    u64 When() const
+    {
+        return Cycle;
+    }
+
+private:
+    static DeviceTask Wait(DeviceAlarm& Alarm, u64 Generation);
+
+    DeviceScheduler& Scheduler;
+    std::function<void()> Callback;
+    u64 Generation = 0;
+    u64 Cycle = 0;
+    u64 SleepingUntil = 0;      // wake cycle of the current task
+    bool Armed = false;
+    bool Waiting = false;       // the current task is sleeping or in the callback
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct DirtyRange;
+	struct DirtyMem;
+}
+
+// [First, End) of memory the cpu wrote to, End is $10000 at the top of memory
+struct m6502::DirtyRange
+{
+    Word First = 0;
+    u32 End = 0;
+
+    bool operator==(const DirtyRange& Other) const = default;
+};
+
+/**
+ * 64KB of ram that remembers which regions the cpu has written, for hosts
+ * that mirror parts of memory (a framebuffer, a mailbox) and only want to
+ * copy what changed after each Execute slice. Every WriteByte and WriteWord
+ * of the cpu sets one bit for its region, regions are 64 bytes up to a
+ * page; the other backends do not pay for it.
+ *
+ * Only cpu writes are tracked: bytes loaded through operator[] or Data are
+ * the host's own. Initialize marks everything dirty so a mirror resyncs.
+ */
+struct m6502::DirtyMem
+{
+    static constexpr u32 MAX_MEM = Mem::MAX_MEM;
+    static constexpr u32 MIN_REGION_SIZE = 64;
+    static constexpr u32 MAX_REGION_SIZE = 256;
+
+    // RegionSize is a power of two from MIN_REGION_SIZE to MAX_REGION_SIZE
+    explicit DirtyMem(u32 RegionSize = MIN_REGION_SIZE);
+
+    void Initialize();
+
+    // read 1 byte
+    Byte operator[](u32 Address) const
+    {
+        return Data[Address];
+    }
+
+    // write 1 byte, not tracked
+    Byte& operator[](u32 Address)
+    {
+        return Data[Address];
+    }
+
+    // read 1 byte on behalf of the cpu
+    Byte Read(Word Address) const
+    {
+        return Data[Address];
+    }
+
+    // write 1 byte on behalf of the cpu
+    void Write(Word Address, Byte Value)
+    {
+        const u32 Region = Address >> RegionShift;
+        Dirty[Region >> 6] |= 1ull << (Region & 63);
+        Data[Address] = Value;
+    }
+
+    u32 RegionSize() const
+    {
+        return 1u << RegionShift;
+    }
+
+    bool IsDirty(Word Address) const
+    {
+        const u32 Region = Address >> RegionShift;
+        return (Dirty[Region >> 6] >> (Region & 63)) & 1;
+    }
+
+    bool AnyDirty() const;
+
+    // the dirty regions with neighbours merged, in address order, replacing the contents of Ranges
+    void DirtyRanges(std::vector<DirtyRange>& Ranges) const;
+
+    void ClearDirty();
+
+    // DirtyRanges then ClearDirty, what a host calls after each slice
+    void TakeDirtyRanges(std::vector<DirtyRange>& Ranges)
+    {
+        DirtyRanges(Ranges);
+        ClearDirty();
+    }
+
+    Byte Data[MAX_MEM];
+
+private:
+    static constexpr u32 NUM_WORDS = MAX_MEM / MIN_REGION_SIZE / 64;
+
+    u32 RegionShift;
+    u32 NumWords;               // words of Dirty in use for this region size
+    u64 Dirty[NUM_WORDS];
+};
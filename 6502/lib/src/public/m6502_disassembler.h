@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "m6502_opcodes.h"
+
+namespace m6502
+{
+	struct DisassemblerOptions;
+	struct BasicBlock;
+	struct ImageAnalysis;
+	struct AnalysisCache;
+	struct Disassembler;
+
+	// raw binary, or with Hex whitespace separated hex bytes where ';' starts a comment
+	bool ReadImageFile(const char* Path, bool Hex, std::vector<Byte>& Image);
+
+	// one instruction as text, e.g. "LDA $1234,X", "???" when it is not decoded
+	std::string FormatInstruction(Byte Instruction, Word Operand);
+}
+
+struct m6502::DisassemblerOptions
+{
+    Word Origin = 0x8000;           // address the image is loaded at
+    std::vector<Word> Entries;      // routines to trace besides the vectors
+    bool FollowVectors = true;      // trace from the NMI, reset and IRQ vectors when they are in the image
+};
+
+// straight line code [Start, End), entered only at Start
+struct m6502::BasicBlock
+{
+    Word Start = 0;
+    u32 End = 0;                    // $10000 for a block that ends with the address space
+    std::vector<Word> Successors;   // jump target, fall through or JSR return address
+
+    bool operator==(const BasicBlock& Other) const = default;
+};
+
+struct m6502::ImageAnalysis
+{
+    u64 Key = 0;                                // Disassembler::ImageKey of the image and options
+    std::vector<Word> Instructions;             // every traced instruction, ascending
+    std::vector<BasicBlock> Blocks;             // ascending
+    std::vector<Word> Routines;                 // entries and JSR targets, ascending
+    std::vector<std::pair<Word, Word>> Calls;   // (routine, routine it calls), ascending
+
+    bool FromCache = false;                     // not part of the encoding
+
+    std::vector<Byte> Encode() const;
+    bool Decode(const std::vector<Byte>& Encoded);
+
+    bool SameAs(const ImageAnalysis& Other) const
+    {
+        return Key == Other.Key && Instructions == Other.Instructions && Blocks == Other.Blocks
+            && Routines == Other.Routines && Calls == Other.Calls;
+    }
+};
+
+/**
+ * Analyses already done, one file per image in Directory named after the
+ * image key. Files are written to a temporary name and renamed, so several
+ * threads or processes can share a directory.
+ */
+struct m6502::AnalysisCache
+{
+    explicit AnalysisCache(const std::string& Directory);
+
+    bool Load(u64 Key, ImageAnalysis& Analysis) const;
+    bool Store(const ImageAnalysis& Analysis) const;
+
+    std::string PathOf(u64 Key) const;
+
+private:
+    std::string Directory;
+};
+
+/**
+ * Recursive traversal disassembler over the opcode table the interpreter
+ * and the recompiler use (see m6502_opcodes.h). Code is traced from the
+ * vectors and entry points through fall through, JMP and JSR, every JSR
+ * target becomes a routine of the call graph, and the traced instructions
+ * are split into basic blocks. Bytes that do not decode end a path.
+ */
+struct m6502::Disassembler
+{
+    // part of every image key, bump it when tracing or the opcode table changes
+    // so analyses cached by an older build are not loaded
+    static constexpr u32 ANALYZER_VERSION = 1;
+
+    // hash of the analyzer version, the image bytes and the options, the cache key
+    static u64 ImageKey(const std::vector<Byte>& Image, const DisassemblerOptions& Options);
+
+    // the image ends by $FFFF when it is loaded at Origin
+    static bool Fits(const std::vector<Byte>& Image, Word Origin);
+
+    // an image that does not fit is reported and gives an analysis with nothing traced
+    static ImageAnalysis Analyze(const std::vector<Byte>& Image, const DisassemblerOptions& Options);
+
+    // blocks of Analysis with addresses, bytes and instructions, routines labelled
+    static std::string Listing(const std::vector<Byte>& Image, const DisassemblerOptions& Options,
+        const ImageAnalysis& Analysis);
+
+    // Analyze every image on NumThreads threads, taking results from Cache and adding new ones when it is given
+    static std::vector<ImageAnalysis> AnalyzeAll(const std::vector<std::vector<Byte>>& Images,
+        const DisassemblerOptions& Options, u32 NumThreads, const AnalysisCache* Cache = nullptr);
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct DmaConfig;
+	struct DmaController;
+}
+
+struct m6502::DmaConfig
+{
+    u32 SetupCycles = 1;        // cycles the cpu loses before the first byte moves
+    u32 CyclesPerByte = 2;      // a read and a write
+    u32 BurstBytes = 0;         // 0 halts the cpu for the whole transfer, otherwise it runs an instruction between bursts
+};
+
+/**
+ * Block copies that take the bus from the cpu, e.g. sprite DMA copying a
+ * page while the cpu is halted for 513 cycles. A transfer is queued with
+ * Start and runs at the cpu's next instruction boundary on the memory that
+ * Execute was given: the bytes are moved in one go, with memmove on plain
+ * Mem and through the backend's Read/Write otherwise, and the cycles they
+ * took are charged to the Cycles budget of Execute instead of being stepped
+ * one access at a time, then the cpu resumes with its next instruction.
+ * With BurstBytes set the cpu gets one instruction in between bursts, the
+ * way cycle stealing controllers let it resume.
+ *
+ * Start from the thread running the cpu, between Execute calls or from code
+ * Execute calls into.
+ */
+struct m6502::DmaController
+{
+    explicit DmaController(CPU& cpu, const DmaConfig& Config = DmaConfig());
+    ~DmaController();
+
+    DmaController(const DmaController&) = delete;
+    DmaController& operator=(const DmaController&) = delete;
+
+    /** Queue a copy of Length bytes from Source to Destination, both wrap at $FFFF
+     *  @return false if a transfer is still running or Length is 0 or over 64KB */
+    bool Start(Word Source, Word Destination, u32 Length);
+
+    // copy page SourcePage to page DestinationPage
+    bool StartPage(Byte SourcePage, Byte DestinationPage)
+    {
+        return Start(SourcePage << 8, DestinationPage << 8, 256);
+    }
+
+    bool Busy() const
+    {
+        return Remaining != 0;
+    }
+
+    u64 CyclesStolen() const
+    {
+        return TotalCycles;
+    }
+
+    u64 BytesCopied() const
+    {
+        return TotalBytes;
+    }
+
+    // the next burst on the memory Execute runs on, called by CPU::Execute, gives the cycles it took
+    u32 Service(const DmaBus& Bus);
+
+    DmaConfig Config;
+
+private:
+    static void Copy(const DmaBus& Bus, Word From, Word To, u32 Length);
+
+    CPU& cpu;
+    Word Source = 0;
+    Word Destination = 0;
+    u32 Remaining = 0;
+    bool SetupDone = false;
+    u64 TotalCycles = 0;
+    u64 TotalBytes = 0;
+};
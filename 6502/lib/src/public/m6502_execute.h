@@ -0,0 +1,316 @@
+#pragma once
+
+// definitions of the templated interpreter, included at the end of m6502.h
+// so Execute can run in constant evaluation (see CPU::Execute)
+
+template<typename TVariant, typename TMem>
+constexpr m6502::s32 m6502::CPU::Execute(s32 Cycles, TMem &memory)
+{
+    // the operation of each mnemonic of the opcode table, on the address its mode gives
+    auto Load = [&memory, this](Word Address, Byte& Register)
+    {
+        Register = ReadByte(Address, memory);
+        LoadRegisterSetStatus(Register);
+    };
+    auto LDA = [&](Word Address) { Load(Address, A); };
+    auto LDX = [&](Word Address) { Load(Address, X); };
+    auto LDY = [&](Word Address) { Load(Address, Y); };
+    auto STA = [&](Word Address) { WriteByte(A, Address, memory); };
+    auto STX = [&](Word Address) { WriteByte(X, Address, memory); };
+    auto STY = [&](Word Address) { WriteByte(Y, Address, memory); };
+    auto STZ = [&](Word Address) { WriteByte(0, Address, memory); };
+    auto ADC = [&](Word Address) { AddWithCarry<TVariant>(ReadByte(Address, memory)); };
+    auto SBC = [&](Word Address) { SubtractWithCarry<TVariant>(ReadByte(Address, memory)); };
+    auto JMP = [&](Word Address) { PC = Address; };
+    auto JSR = [&](Word Address)
+    {
+        PushPCToStack(memory);
+        PC = Address;
+    };
+    auto RTS = [&](Word) { PC = PopWordFromStack(memory) + 1; };
+    //the byte after BRK was skipped by its addressing
+    auto BRK = [&](Word) { Interrupt(IRQ_VECTOR, GetPS() | FLAG_BREAK | FLAG_UNUSED, memory); };
+    auto RTI = [&](Word)
+    {
+        SetPS(PopByteFromStack(memory));
+        Flag.B = 0;
+        Flag.Unused = 0;
+        PC = PopWordFromStack(memory);
+    };
+    auto SEI = [&](Word) { Flag.I = 1; };
+    auto CLI = [&](Word) { Flag.I = 0; };
+    auto SEC = [&](Word) { Flag.C = 1; };
+    auto CLC = [&](Word) { Flag.C = 0; };
+    auto SED = [&](Word) { Flag.D = 1; };
+    auto CLD = [&](Word) { Flag.D = 0; };
+    auto PHX = [&](Word) { PushByteToStack(X, memory); };
+    auto PHY = [&](Word) { PushByteToStack(Y, memory); };
+    auto PLX = [&](Word)
+    {
+        X = PopByteFromStack(memory);
+        LoadRegisterSetStatus(X);
+    };
+    auto PLY = [&](Word)
+    {
+        Y = PopByteFromStack(memory);
+        LoadRegisterSetStatus(Y);
+    };
+
+    const s32 CyclesRequested = Cycles;
+    u64 InstructionsRun = 0;
+    u64 InterruptsTaken = 0;
+    while (Cycles > 0)
+    {
+        if (Interrupts.Any())
+        {
+            if constexpr (HasInterruptHook<TMem>)
+            {
+                memory.BeginInterrupt(PC);
+            }
+            //a dma burst is always followed by an instruction, an interrupt entry can end the run
+            if (ServiceInterrupts(Cycles, memory))
+            {
+                InterruptsTaken++;
+                if (Cycles <= 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        if constexpr (HasInstructionHook<TMem>)
+        {
+            if (!memory.BeginInstruction(PC, CyclesRequested - Cycles))
+            {
+                break;
+            }
+        }
+
+        Byte Instruction = FetchByte(memory); // 8 bit instruction grabbed from PC
+        InstructionsRun++;
+        switch (Instruction)
+        {
+        // one case per row of m6502_opcodetable.h, charged the cycles of the row
+#define M6502_EXECUTE_OPCODE(Name, Opcode, Mnemonic, Mode, BaseCycles, PageCross, Affects, Set, CMOSExtra) \
+        case INS_##Name: \
+        { \
+            if constexpr (OpcodeSet::Set == OpcodeSet::CMOS && !TVariant::HasCMOSInstructions) \
+            { \
+                UnhandledInstruction(Instruction); \
+                Cycles--; \
+            } \
+            else \
+            { \
+                bool PageCrossed = false; \
+                Mnemonic(AddressOf<AddressMode::Mode, TVariant>(memory, PageCrossed)); \
+                Cycles -= BaseCycles + (PageCrossed ? PageCross : 0); \
+                if constexpr (CMOSExtra > 0 && TVariant::HasCMOSInstructions) \
+                { \
+                    if (AddressMode::Mode == AddressMode::Indirect || (TVariant::HasDecimalMode && Flag.D)) \
+                    { \
+                        Cycles -= CMOSExtra; \
+                    } \
+                } \
+            } \
+        } \
+        break;
+        M6502_OPCODE_TABLE(M6502_EXECUTE_OPCODE)
+#undef M6502_EXECUTE_OPCODE
+
+        default:
+        {
+            UnhandledInstruction(Instruction);
+            Cycles--;
+        }
+        break;
+        }
+    }
+    const s32 NumCyclesUsed = CyclesRequested - Cycles;
+    if (!std::is_constant_evaluated())
+    {
+        CountExecute(InstructionsRun, NumCyclesUsed, InterruptsTaken);
+    }
+    return NumCyclesUsed;
+}
+
+template<typename TVariant>
+constexpr void m6502::CPU::AddWithCarry(Byte Operand)
+{
+    const u32 Sum = A + Operand + Flag.C;
+    if (TVariant::HasDecimalMode && Flag.D)
+    {
+        u32 Lo = (A & 0x0F) + (Operand & 0x0F) + Flag.C;
+        if (Lo > 0x09)
+        {
+            Lo += 0x06;
+        }
+        u32 Hi = (A >> 4) + (Operand >> 4) + (Lo > 0x0F);
+
+        //NMOS takes Z from the binary sum and N/V from the half adjusted result
+        Flag.Z = (Sum & 0xFF) == 0;
+        Flag.N = (Hi & 0x08) != 0;
+        Flag.V = ((~(A ^ Operand) & (A ^ (Hi << 4))) & 0x80) != 0;
+        if (Hi > 0x09)
+        {
+            Hi += 0x06;
+        }
+        Flag.C = Hi > 0x0F;
+        A = static_cast<Byte>((Hi << 4) | (Lo & 0x0F));
+
+        if constexpr (TVariant::HasCMOSInstructions)
+        {
+            //65C02 spends a cycle (CMOSExtra of the table) to get valid N and Z
+            LoadRegisterSetStatus(A);
+        }
+        return;
+    }
+
+    Flag.V = ((~(A ^ Operand) & (A ^ Sum)) & 0x80) != 0;
+    Flag.C = Sum > 0xFF;
+    A = static_cast<Byte>(Sum);
+    LoadRegisterSetStatus(A);
+}
+
+template<typename TVariant>
+constexpr void m6502::CPU::SubtractWithCarry(Byte Operand)
+{
+    if (TVariant::HasDecimalMode && Flag.D)
+    {
+        const Byte Borrow = 1 - Flag.C;
+        const u32 Difference = A - Operand - Borrow;
+        s32 Lo = (A & 0x0F) - (Operand & 0x0F) - Borrow;
+        s32 Hi = (A >> 4) - (Operand >> 4);
+        if (Lo < 0)
+        {
+            Lo -= 0x06;
+            Hi--;
+        }
+        if (Hi < 0)
+        {
+            Hi -= 0x06;
+        }
+
+        //flags come from the binary subtraction
+        Flag.V = (((A ^ Operand) & (A ^ Difference)) & 0x80) != 0;
+        Flag.C = Difference < 0x100;
+        LoadRegisterSetStatus(static_cast<Byte>(Difference));
+        A = static_cast<Byte>((Hi << 4) | (Lo & 0x0F));
+
+        if constexpr (TVariant::HasCMOSInstructions)
+        {
+            LoadRegisterSetStatus(A);
+        }
+        return;
+    }
+
+    AddWithCarry<TVariant>(~Operand);
+}
+
+template<typename TMem>
+constexpr void m6502::CPU::Interrupt(Word Vector, Byte PushedFlags, TMem& memory)
+{
+    PushWordToStack(PC, memory);
+    PushByteToStack(PushedFlags, memory);
+    Flag.I = 1;
+    PC = ReadWord(Vector, memory);
+}
+
+template<typename TMem>
+bool m6502::CPU::ServiceInterrupts(s32& Cycles, TMem& memory)
+{
+    const u32 Pending = Interrupts.Pending.load(std::memory_order_acquire);
+    const Byte PushedFlags = (GetPS() | FLAG_UNUSED) & ~FLAG_BREAK;
+    if (Pending & InterruptLines::DMA_BIT)
+    {
+        //the cpu is halted while the transfer has the bus
+        Cycles -= static_cast<s32>(ServiceDMA(DmaBus::Of(memory)));
+    }
+    if (Pending & InterruptLines::NMI_BIT)
+    {
+        Interrupts.Pending.fetch_and(~InterruptLines::NMI_BIT, std::memory_order_acq_rel);
+        Cycles -= INTERRUPT_CYCLES;
+        Interrupt(NMI_VECTOR, PushedFlags, memory);
+        return true;
+    }
+    if ((Pending & InterruptLines::IRQ_MASK) && !Flag.I)
+    {
+        Cycles -= INTERRUPT_CYCLES;
+        Interrupt(IRQ_VECTOR, PushedFlags, memory);
+        return true;
+    }
+    return false;
+}
+
+template<m6502::AddressMode Mode, typename TVariant, typename TMem>
+constexpr m6502::Word m6502::CPU::AddressOf(const TMem& memory, bool& PageCrossed)
+{
+    if constexpr (Mode == AddressMode::Immediate)
+    {
+        return PC++;
+    }
+    else if constexpr (Mode == AddressMode::ZeroPage)
+    {
+        return FetchByte(memory);
+    }
+    else if constexpr (Mode == AddressMode::ZeroPageX || Mode == AddressMode::ZeroPageY)
+    {
+        //wraps within the zero page
+        return static_cast<Byte>(FetchByte(memory) + (Mode == AddressMode::ZeroPageX ? X : Y));
+    }
+    else if constexpr (Mode == AddressMode::Absolute)
+    {
+        return FetchWord(memory);
+    }
+    else if constexpr (Mode == AddressMode::AbsoluteX || Mode == AddressMode::AbsoluteY)
+    {
+        const Word AbsAddress = FetchWord(memory);
+        const Word Indexed = AbsAddress + (Mode == AddressMode::AbsoluteX ? X : Y);
+        PageCrossed = ((Indexed ^ AbsAddress) >> 8) != 0;
+        return Indexed;
+    }
+    else if constexpr (Mode == AddressMode::IndirectX)
+    {
+        const Byte ZPAddress = FetchByte(memory) + X;
+        return ReadWord(ZPAddress, memory);
+    }
+    else if constexpr (Mode == AddressMode::IndirectY)
+    {
+        const Byte ZPAddress = FetchByte(memory);
+        const Word EffectiveAddress = ReadWord(ZPAddress, memory);
+        const Word Indexed = EffectiveAddress + Y;
+        PageCrossed = ((Indexed ^ EffectiveAddress) >> 8) != 0;
+        return Indexed;
+    }
+    else if constexpr (Mode == AddressMode::ZeroPageIndirect)
+    {
+        //the pointer wraps within the zero page
+        const Byte ZPAddress = FetchByte(memory);
+        const Byte LoByte = ReadByte(ZPAddress, memory);
+        const Byte HiByte = ReadByte(static_cast<Byte>(ZPAddress + 1), memory);
+        return LoByte | (HiByte << 8);
+    }
+    else if constexpr (Mode == AddressMode::Indirect)
+    {
+        const Word Pointer = FetchWord(memory);
+        if constexpr (TVariant::HasJMPIndirectBug)
+        {
+            //the high byte is fetched without carrying into the pointer's page
+            const Word HiPointer = (Pointer & 0xFF00) | ((Pointer + 1) & 0x00FF);
+            return ReadByte(Pointer, memory) | (ReadByte(HiPointer, memory) << 8);
+        }
+        else
+        {
+            return ReadWord(Pointer, memory);
+        }
+    }
+    else if constexpr (Mode == AddressMode::Break)
+    {
+        FetchByte(memory);
+        return 0;
+    }
+    else
+    {
+        static_assert(Mode == AddressMode::Implied, "no addressing for this mode");
+        return 0;
+    }
+}
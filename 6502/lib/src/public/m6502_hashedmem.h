@@ -0,0 +1,76 @@
+#pragma once
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct HashedMem;
+}
+
+/**
+ * 64KB of ram that keeps a Merkle tree of page hashes, so a whole machine
+ * state can be identified by one 64 bit value. Writes only mark their page
+ * dirty; Root rehashes the dirty pages and the tree nodes above them the
+ * next time it is asked, so hashing after a step costs a page or two
+ * instead of 64KB. Copies keep their hashes, so a search can clone a state
+ * and keep hashing it incrementally.
+ */
+struct m6502::HashedMem
+{
+    static constexpr u32 MAX_MEM = Mem::MAX_MEM;
+    static constexpr u32 PAGE_SIZE = 256;
+    static constexpr u32 NUM_PAGES = MAX_MEM / PAGE_SIZE;
+
+    HashedMem();
+
+    void Initialize();
+
+    // read 1 byte
+    Byte operator[](u32 Address) const
+    {
+        return Data[Address];
+    }
+
+    // write 1 byte, the page is marked dirty even if the value stays the same
+    Byte& operator[](u32 Address)
+    {
+        MarkDirty(Address >> 8);
+        return Data[Address];
+    }
+
+    // read 1 byte on behalf of the cpu
+    Byte Read(Word Address) const
+    {
+        return Data[Address];
+    }
+
+    // write 1 byte on behalf of the cpu
+    void Write(Word Address, Byte Value)
+    {
+        MarkDirty(Address >> 8);
+        Data[Address] = Value;
+    }
+
+    // hash of all 64KB
+    u64 Root();
+
+    // Root combined with the cpu registers and interrupt lines, equal for equal machine states
+    u64 StateHash(const CPU& cpu);
+
+    u32 NumDirtyPages() const;
+
+private:
+    static constexpr u32 NUM_NODES = 2 * NUM_PAGES - 1;    // heap order, leaves last
+    static constexpr u32 FIRST_LEAF = NUM_PAGES - 1;
+
+    void MarkDirty(u32 PageIndex)
+    {
+        DirtyPages[PageIndex >> 5] |= 1u << (PageIndex & 31);
+    }
+
+    u64 HashPage(u32 PageIndex) const;
+
+    Byte Data[MAX_MEM];
+    u32 DirtyPages[NUM_PAGES / 32];
+    u64 Nodes[NUM_NODES];
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct InputLog;
+	struct InputMem;
+	struct InputRecorder;
+}
+
+/**
+ * Every value external devices fed into the machine, in the order the cpu
+ * read them, keyed by the cycle the reading instruction started on.
+ * Saved as a varint stream of cycle deltas, with the address only written
+ * when it changes, so a busy keyboard port costs about 3 bytes per read.
+ */
+struct m6502::InputLog
+{
+    struct Entry
+    {
+        u64 Cycle;
+        Word Address;
+        Byte Value;
+    };
+
+    std::vector<Entry> Entries;
+
+    bool Save(const char* Path) const;
+    bool Load(const char* Path);
+
+    // encoded form used by Save and Load
+    std::vector<Byte> Encode() const;
+    bool Decode(const std::vector<Byte>& Encoded);
+};
+
+/**
+ * 64KB of ram with memory-mapped input ports. Reading a port asks its
+ * InputSource for the value, unless an InputRecorder is attached: then the
+ * read is recorded or, when replaying, answered from the log.
+ */
+struct m6502::InputMem
+{
+    static constexpr u32 MAX_MEM = Mem::MAX_MEM;
+
+    using InputSource = std::function<Byte(Word Address)>;
+
+    InputMem();
+
+    InputMem(const InputMem&) = delete;
+    InputMem& operator=(const InputMem&) = delete;
+
+    // clear the ram, input ports stay mapped
+    void Initialize();
+
+    // reads of Address come from Source instead of ram
+    void MapInput(Word Address, InputSource Source);
+
+    bool IsInput(Word Address) const
+    {
+        return (InputBits[Address >> 5] >> (Address & 31)) & 1;
+    }
+
+    // read 1 byte
+    Byte operator[](u32 Address) const
+    {
+        return Data[Address];
+    }
+
+    // write 1 byte
+    Byte& operator[](u32 Address)
+    {
+        return Data[Address];
+    }
+
+    // read 1 byte on behalf of the cpu
+    Byte Read(Word Address) const
+    {
+        if (IsInput(Address))
+        {
+            return ReadInput(Address);
+        }
+        return Data[Address];
+    }
+
+    // write 1 byte on behalf of the cpu
+    void Write(Word Address, Byte Value)
+    {
+        Data[Address] = Value;
+    }
+
+    InputRecorder* Recorder = nullptr;
+
+private:
+    friend struct InputRecorder;
+
+    Byte ReadInput(Word Address) const;
+    Byte ReadSource(Word Address) const;
+
+    u32 InputBits[MAX_MEM / 32];
+    std::unordered_map<Word, InputSource> Sources;
+    Byte Data[MAX_MEM];
+};
+
+/**
+ * Runs a cpu on an InputMem while recording its input into a log, or
+ * replays a log so the run is bit for bit the same as the recorded one.
+ * Recording steps one instruction at a time to timestamp each read; it runs
+ * at the speed the live input arrives anyway. Replay runs the cpu in large
+ * slices that end exactly on the next logged cycle and only steps the
+ * instruction that reads the port, so it runs close to full speed.
+ */
+struct m6502::InputRecorder
+{
+    InputRecorder(InputMem& Memory, InputLog& Log);
+    ~InputRecorder();
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    /** Run live input for at least Cycles cycles, appending it to the log
+     *  @return the number of cycles that were used */
+    template<typename TVariant = NMOS6502>
+    u64 Record(CPU& cpu, u64 Cycles);
+
+    /** Run at least Cycles cycles feeding the cpu from the log
+     *  @return the number of cycles that were used */
+    template<typename TVariant = NMOS6502>
+    u64 Replay(CPU& cpu, u64 Cycles);
+
+    // cycles run since the recorder was attached
+    u64 Cycle() const
+    {
+        return Now;
+    }
+
+    // a replayed read did not match the log, the run is no longer the recorded one
+    bool Diverged() const
+    {
+        return HasDiverged;
+    }
+
+    // log entries replayed so far
+    size_t Position() const
+    {
+        return Cursor;
+    }
+
+private:
+    friend struct InputMem;
+
+    Byte Input(Word Address);
+
+    InputMem& Memory;
+    InputLog& Log;
+    bool Replaying = false;
+    bool Stepping = false;      // running the single instruction at InstructionStart
+    bool HasDiverged = false;
+    u64 Now = 0;
+    u64 InstructionStart = 0;
+    size_t Cursor = 0;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct Numa;
+	struct MemPool;
+}
+
+/**
+ * The few bits of NUMA topology the pool and the server scheduler need.
+ * On systems without NUMA information everything is node 0.
+ */
+struct m6502::Numa
+{
+    static u32 NumNodes();
+
+    // node of the cpu the calling thread is running on
+    static u32 CurrentNode();
+
+    // restrict the calling thread to the cpus of one node, false if that is not possible
+    static bool PinThisThread(u32 Node);
+};
+
+/**
+ * Hands out Mem instances as 64KB aligned slabs carved from 2MB huge pages,
+ * so ten thousand machines cost a few hundred TLB entries instead of tens of
+ * thousands. Each NUMA node has its own huge pages and free list: a slab is
+ * bound to the node it was allocated for and goes back to that node's list
+ * when freed. Memory is never returned to the OS before the pool is destroyed.
+ */
+struct m6502::MemPool
+{
+    static constexpr u32 SLAB_SIZE = Mem::MAX_MEM;
+    static constexpr u32 HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    static constexpr u32 SLABS_PER_HUGE_PAGE = HUGE_PAGE_SIZE / SLAB_SIZE;
+
+    MemPool();
+    ~MemPool();
+
+    MemPool(const MemPool&) = delete;
+    MemPool& operator=(const MemPool&) = delete;
+
+    // pool shared by the whole process
+    static MemPool& Global();
+
+    // a Mem on the calling thread's node, contents are not cleared
+    Mem* Allocate()
+    {
+        return Allocate(Numa::CurrentNode());
+    }
+
+    // a Mem on the given node, contents are not cleared
+    Mem* Allocate(u32 Node);
+
+    void Free(Mem* Memory);
+
+    // node a Mem from this pool was allocated for
+    u32 NodeOf(const Mem* Memory) const;
+
+    u32 NumHugePages() const;
+    u32 NumFree(u32 Node) const;
+
+private:
+    struct FreeSlab
+    {
+        FreeSlab* Next;
+    };
+
+    struct NodeSlabs
+    {
+        std::mutex Lock;
+        FreeSlab* FreeList = nullptr;
+        u32 NumFree = 0;
+    };
+
+    // map, bind and split one more huge page for Node, called with the node's lock held
+    bool Refill(u32 Node, NodeSlabs& Slabs);
+
+    std::vector<std::unique_ptr<NodeSlabs>> Nodes;
+
+    mutable std::mutex HugePagesLock;
+    std::unordered_map<uintptr_t, u32> HugePages;   // base address -> node
+    std::vector<std::pair<void*, size_t>> Mappings;
+};
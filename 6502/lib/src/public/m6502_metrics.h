@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct Metrics;
+	struct MachineMetricsScope;
+}
+
+/**
+ * Always on counters of the interpreter: instructions, cycles, interrupts
+ * and unhandled opcodes, per worker thread and per machine. Execute adds
+ * its totals to the calling thread's MetricsShard when it returns and, in a
+ * MachineMetricsScope, to that machine's shard too, so nothing is shared on
+ * that path. Format sums the shards when asked, in the Prometheus text
+ * format, with the emulated MHz each shard ran at since the previous Format.
+ * The shard of a thread that exits is folded into a "retired" row and reused.
+ */
+struct m6502::Metrics
+{
+    static Metrics& Global();
+
+    // label of the calling thread's row, "thread-N" until it is named
+    void NameThread(const std::string& Name);
+
+    // a shard for one emulated machine, in the dump until it is removed
+    MetricsShard* AddMachine(const std::string& Name);
+    void RemoveMachine(MetricsShard* Shard);
+
+    std::string Format();
+
+    // write Format through a temporary file and a rename, so readers never see half a dump
+    bool WriteFile(const std::string& Path);
+
+private:
+    struct Entry;
+    struct ThreadExit;
+    friend MetricsShard* m6502::RegisterThreadMetrics();
+
+    MetricsShard* RegisterThread();
+    void RetireThread(MetricsShard* Shard);
+
+    std::mutex Lock;
+    std::vector<std::unique_ptr<Entry>> Threads;
+    std::vector<std::unique_ptr<Entry>> Machines;
+    std::unique_ptr<Entry> Retired;
+    u32 NextThread = 0;
+};
+
+// counts Execute calls on this thread into Shard as well, until the scope ends
+struct m6502::MachineMetricsScope
+{
+    explicit MachineMetricsScope(MetricsShard* Shard)
+        : Previous(MachineMetrics)
+    {
+        MachineMetrics = Shard;
+    }
+
+    ~MachineMetricsScope()
+    {
+        MachineMetrics = Previous;
+    }
+
+    MachineMetricsScope(const MachineMetricsScope&) = delete;
+    MachineMetricsScope& operator=(const MachineMetricsScope&) = delete;
+
+private:
+    MetricsShard* Previous;
+};
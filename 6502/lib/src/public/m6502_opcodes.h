@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	// status bits an instruction can change, bit 0 carry to bit 7 negative as in GetPS
+	inline constexpr Byte
+	AFFECTS_NONE = 0,
+	AFFECTS_C = 0b00000001,
+	AFFECTS_I = 0b00000100,
+	AFFECTS_D = 0b00001000,
+	AFFECTS_NZ = 0b10000010,
+	AFFECTS_NVZC = 0b11000011,
+	AFFECTS_ALL = 0b11111111;
+
+	struct OpcodeInfo
+	{
+		const char* Mnemonic = "???";
+		AddressMode Mode = AddressMode::Unknown;
+		Byte Cycles = 0;
+		Byte PageCrossCycles = 0;
+		Byte CMOSExtraCycles = 0;
+		Byte Affects = AFFECTS_NONE;
+		OpcodeSet Set = OpcodeSet::None;
+	};
+
+	// every opcode by value, rows of m6502_opcodetable.h and defaults for the rest
+	constexpr std::array<OpcodeInfo, 256> MakeOpcodeTable()
+	{
+		std::array<OpcodeInfo, 256> Table{};
+#define M6502_OPCODE_INFO(Name, Opcode, Mnemonic, Mode, Cycles, PageCross, Affects, Set, CMOSExtra) \
+		Table[Opcode] = { #Mnemonic, AddressMode::Mode, Cycles, PageCross, CMOSExtra, AFFECTS_##Affects, OpcodeSet::Set };
+		M6502_OPCODE_TABLE(M6502_OPCODE_INFO)
+#undef M6502_OPCODE_INFO
+		return Table;
+	}
+
+	inline constexpr std::array<OpcodeInfo, 256> OPCODE_TABLE = MakeOpcodeTable();
+
+	// the opcodes of the table in the order they are listed
+	inline constexpr Byte TABLE_OPCODES[] = {
+#define M6502_OPCODE_VALUE(Name, Opcode, ...) Opcode,
+		M6502_OPCODE_TABLE(M6502_OPCODE_VALUE)
+#undef M6502_OPCODE_VALUE
+	};
+
+	constexpr bool OpcodesAreUnique()
+	{
+		bool Seen[256] = {};
+		for (Byte Opcode : TABLE_OPCODES)
+		{
+			if (Seen[Opcode])
+			{
+				return false;
+			}
+			Seen[Opcode] = true;
+		}
+		return true;
+	}
+
+	static_assert(OpcodesAreUnique(), "an opcode is listed twice in m6502_opcodetable.h");
+
+	// opcodes the interpreter implements, 65C02 ones only with CMOS, Unknown for the rest
+	constexpr OpcodeInfo DecodeOpcode(Byte Instruction, bool CMOS = false)
+	{
+		const OpcodeInfo& Info = OPCODE_TABLE[Instruction];
+		if (Info.Set == OpcodeSet::NMOS || (CMOS && Info.Set == OpcodeSet::CMOS))
+		{
+			return Info;
+		}
+		return OpcodeInfo();
+	}
+
+	constexpr u32 OperandSize(AddressMode Mode)
+	{
+		switch (Mode)
+		{
+		case AddressMode::Implied:
+		case AddressMode::Unknown:
+			return 0;
+		case AddressMode::Absolute:
+		case AddressMode::AbsoluteX:
+		case AddressMode::AbsoluteY:
+		case AddressMode::Indirect:
+			return 2;
+		default:
+			return 1;
+		}
+	}
+}
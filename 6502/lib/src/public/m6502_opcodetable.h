@@ -0,0 +1,106 @@
+#pragma once
+
+/**
+ * Every opcode the interpreter implements, one row each. The INS_ constants
+ * of CPU, the dispatch of CPU::Execute and the cycles it charges, the decode
+ * table of m6502_opcodes.h (mnemonics, addressing, cycle counts for the
+ * disassembler and the code generators) and the opcode timing tests are all
+ * expanded from this list, so a new opcode is added here once.
+ *
+ * X(Name, Opcode, Mnemonic, Mode, Cycles, PageCross, Affects, Set, CMOSExtra)
+ *  Mnemonic    also names the operation Execute runs on the operand address
+ *  Mode        AddressMode, how CPU::AddressOf finds that address
+ *  Cycles      cycles without a page crossing
+ *  PageCross   extra cycle when an indexed read crosses a page
+ *  Affects     status flags it can change, AFFECTS_ in m6502_opcodes.h
+ *  Set         NMOS for every variant, CMOS for the 65C02 only
+ *  CMOSExtra   extra cycles on the 65C02 (JMP (ind) always, ADC/SBC only in decimal mode)
+ */
+#define M6502_OPCODE_TABLE(X) \
+    /* Load Accumulator */ \
+    X(LDA_IM,   0xA9, LDA,   Immediate,        2, 0, NZ,   NMOS, 0) \
+    X(LDA_ZP,   0xA5, LDA,   ZeroPage,         3, 0, NZ,   NMOS, 0) \
+    X(LDA_ZPX,  0xB5, LDA,   ZeroPageX,        4, 0, NZ,   NMOS, 0) \
+    X(LDA_ABS,  0xAD, LDA,   Absolute,         4, 0, NZ,   NMOS, 0) \
+    X(LDA_ABSX, 0xBD, LDA,   AbsoluteX,        4, 1, NZ,   NMOS, 0) \
+    X(LDA_ABSY, 0xB9, LDA,   AbsoluteY,        4, 1, NZ,   NMOS, 0) \
+    X(LDA_INDX, 0xA1, LDA,   IndirectX,        6, 0, NZ,   NMOS, 0) \
+    X(LDA_INDY, 0xB1, LDA,   IndirectY,        5, 1, NZ,   NMOS, 0) \
+    /* Load X Register */ \
+    X(LDX_IM,   0xA2, LDX,   Immediate,        2, 0, NZ,   NMOS, 0) \
+    X(LDX_ZP,   0xA6, LDX,   ZeroPage,         3, 0, NZ,   NMOS, 0) \
+    X(LDX_ZPY,  0xB6, LDX,   ZeroPageY,        4, 0, NZ,   NMOS, 0) \
+    X(LDX_ABS,  0xAE, LDX,   Absolute,         4, 0, NZ,   NMOS, 0) \
+    X(LDX_ABSY, 0xBE, LDX,   AbsoluteY,        4, 1, NZ,   NMOS, 0) \
+    /* Load Y Register */ \
+    X(LDY_IM,   0xA0, LDY,   Immediate,        2, 0, NZ,   NMOS, 0) \
+    X(LDY_ZP,   0xA4, LDY,   ZeroPage,         3, 0, NZ,   NMOS, 0) \
+    X(LDY_ZPX,  0xB4, LDY,   ZeroPageX,        4, 0, NZ,   NMOS, 0) \
+    X(LDY_ABS,  0xAC, LDY,   Absolute,         4, 0, NZ,   NMOS, 0) \
+    X(LDY_ABSX, 0xBC, LDY,   AbsoluteX,        4, 1, NZ,   NMOS, 0) \
+    /* Store Accumulator in Memory */ \
+    X(STA_ZP,   0x85, STA,   ZeroPage,         3, 0, NONE, NMOS, 0) \
+    X(STA_ZPX,  0x95, STA,   ZeroPageX,        4, 0, NONE, NMOS, 0) \
+    X(STA_ABS,  0x8D, STA,   Absolute,         4, 0, NONE, NMOS, 0) \
+    X(STA_ABSX, 0x9D, STA,   AbsoluteX,        5, 0, NONE, NMOS, 0) \
+    X(STA_ABSY, 0x99, STA,   AbsoluteY,        5, 0, NONE, NMOS, 0) \
+    X(STA_INDX, 0x81, STA,   IndirectX,        6, 0, NONE, NMOS, 0) \
+    X(STA_INDY, 0x91, STA,   IndirectY,        6, 0, NONE, NMOS, 0) \
+    /* Store X Register in Memory */ \
+    X(STX_ZP,   0x86, STX,   ZeroPage,         3, 0, NONE, NMOS, 0) \
+    X(STX_ZPY,  0x96, STX,   ZeroPageY,        4, 0, NONE, NMOS, 0) \
+    X(STX_ABS,  0x8E, STX,   Absolute,         4, 0, NONE, NMOS, 0) \
+    /* Store Y Register in Memory */ \
+    X(STY_ZP,   0x84, STY,   ZeroPage,         3, 0, NONE, NMOS, 0) \
+    X(STY_ZPX,  0x94, STY,   ZeroPageX,        4, 0, NONE, NMOS, 0) \
+    X(STY_ABS,  0x8C, STY,   Absolute,         4, 0, NONE, NMOS, 0) \
+    /* Jump to Subroutine / Return from Subroutine */ \
+    X(JSR,      0x20, JSR,   Absolute,         6, 0, NONE, NMOS, 0) \
+    X(RTS,      0x60, RTS,   Implied,          6, 0, NONE, NMOS, 0) \
+    /* Force Interrupt, skips a padding byte / Return from Interrupt */ \
+    X(BRK,      0x00, BRK,   Break,            7, 0, I,    NMOS, 0) \
+    X(RTI,      0x40, RTI,   Implied,          6, 0, ALL,  NMOS, 0) \
+    /* Set / Clear Interrupt Disable */ \
+    X(SEI,      0x78, SEI,   Implied,          2, 0, I,    NMOS, 0) \
+    X(CLI,      0x58, CLI,   Implied,          2, 0, I,    NMOS, 0) \
+    /* Set / Clear Carry and Decimal flags */ \
+    X(SEC,      0x38, SEC,   Implied,          2, 0, C,    NMOS, 0) \
+    X(CLC,      0x18, CLC,   Implied,          2, 0, C,    NMOS, 0) \
+    X(SED,      0xF8, SED,   Implied,          2, 0, D,    NMOS, 0) \
+    X(CLD,      0xD8, CLD,   Implied,          2, 0, D,    NMOS, 0) \
+    /* Jump, the 65C02 spends a cycle fixing JMP ($xxFF) */ \
+    X(JMP_ABS,  0x4C, JMP,   Absolute,         3, 0, NONE, NMOS, 0) \
+    X(JMP_IND,  0x6C, JMP,   Indirect,         5, 0, NONE, NMOS, 1) \
+    /* Add with Carry */ \
+    X(ADC_IM,   0x69, ADC,   Immediate,        2, 0, NVZC, NMOS, 1) \
+    X(ADC_ZP,   0x65, ADC,   ZeroPage,         3, 0, NVZC, NMOS, 1) \
+    X(ADC_ZPX,  0x75, ADC,   ZeroPageX,        4, 0, NVZC, NMOS, 1) \
+    X(ADC_ABS,  0x6D, ADC,   Absolute,         4, 0, NVZC, NMOS, 1) \
+    X(ADC_ABSX, 0x7D, ADC,   AbsoluteX,        4, 1, NVZC, NMOS, 1) \
+    X(ADC_ABSY, 0x79, ADC,   AbsoluteY,        4, 1, NVZC, NMOS, 1) \
+    X(ADC_INDX, 0x61, ADC,   IndirectX,        6, 0, NVZC, NMOS, 1) \
+    X(ADC_INDY, 0x71, ADC,   IndirectY,        5, 1, NVZC, NMOS, 1) \
+    /* Subtract with Carry */ \
+    X(SBC_IM,   0xE9, SBC,   Immediate,        2, 0, NVZC, NMOS, 1) \
+    X(SBC_ZP,   0xE5, SBC,   ZeroPage,         3, 0, NVZC, NMOS, 1) \
+    X(SBC_ZPX,  0xF5, SBC,   ZeroPageX,        4, 0, NVZC, NMOS, 1) \
+    X(SBC_ABS,  0xED, SBC,   Absolute,         4, 0, NVZC, NMOS, 1) \
+    X(SBC_ABSX, 0xFD, SBC,   AbsoluteX,        4, 1, NVZC, NMOS, 1) \
+    X(SBC_ABSY, 0xF9, SBC,   AbsoluteY,        4, 1, NVZC, NMOS, 1) \
+    X(SBC_INDX, 0xE1, SBC,   IndirectX,        6, 0, NVZC, NMOS, 1) \
+    X(SBC_INDY, 0xF1, SBC,   IndirectY,        5, 1, NVZC, NMOS, 1) \
+    /* 65C02 only: zero page indirect addressing */ \
+    X(LDA_ZPI,  0xB2, LDA,   ZeroPageIndirect, 5, 0, NZ,   CMOS, 0) \
+    X(STA_ZPI,  0x92, STA,   ZeroPageIndirect, 5, 0, NONE, CMOS, 0) \
+    X(ADC_ZPI,  0x72, ADC,   ZeroPageIndirect, 5, 0, NVZC, CMOS, 1) \
+    X(SBC_ZPI,  0xF2, SBC,   ZeroPageIndirect, 5, 0, NVZC, CMOS, 1) \
+    /* 65C02 only: Store Zero */ \
+    X(STZ_ZP,   0x64, STZ,   ZeroPage,         3, 0, NONE, CMOS, 0) \
+    X(STZ_ZPX,  0x74, STZ,   ZeroPageX,        4, 0, NONE, CMOS, 0) \
+    X(STZ_ABS,  0x9C, STZ,   Absolute,         4, 0, NONE, CMOS, 0) \
+    X(STZ_ABSX, 0x9E, STZ,   AbsoluteX,        5, 0, NONE, CMOS, 0) \
+    /* 65C02 only: Push / Pull X and Y */ \
+    X(PHX,      0xDA, PHX,   Implied,          3, 0, NONE, CMOS, 0) \
+    X(PHY,      0x5A, PHY,   Implied,          3, 0, NONE, CMOS, 0) \
+    X(PLX,      0xFA, PLX,   Implied,          4, 0, NZ,   CMOS, 0) \
+    X(PLY,      0x7A, PLY,   Implied,          4, 0, NZ,   CMOS, 0)
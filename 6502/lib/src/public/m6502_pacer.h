@@ -0,0 +1,102 @@
+#pragma once
+
+#include <math.h>
+#include <algorithm>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct PacerConfig;
+	struct JitterStats;
+	struct Pacer;
+}
+
+struct m6502::PacerConfig
+{
+    u64 ClockHz = 1000000;          // 1.79MHz for an NTSC NES, 1MHz for most boards
+    s32 SliceCycles = 1000;         // cycles run between two sleeps
+    s64 SpinNanoseconds = 50000;    // busy wait this long before each deadline instead of sleeping
+    s64 MaxLagNanoseconds = 100000000;  // further behind than this the timeline restarts instead of catching up
+};
+
+// how far from their deadlines the slices finished, in nanoseconds
+struct m6502::JitterStats
+{
+    u64 Slices = 0;
+    u64 Overruns = 0;       // slices whose emulation alone took longer than their time
+    u64 Resyncs = 0;        // times the timeline restarted after falling too far behind
+    s64 MaxLate = 0;        // worst wake up after a deadline
+    s64 TotalLate = 0;
+    double TotalLateSquared = 0.0;
+
+    double MeanLate() const
+    {
+        return Slices > 0 ? static_cast<double>(TotalLate) / Slices : 0.0;
+    }
+
+    double StdDevLate() const
+    {
+        const double Mean = MeanLate();
+        return Slices > 0 ? sqrt(std::max(0.0, TotalLateSquared / Slices - Mean * Mean)) : 0.0;
+    }
+
+    void Reset()
+    {
+        *this = JitterStats();
+    }
+};
+
+/**
+ * Runs a cpu at a real clock rate. Execute runs SliceCycles at a time and
+ * after each slice sleeps until the moment those cycles would have ended on
+ * hardware: clock_nanosleep on an absolute CLOCK_MONOTONIC timeline (a
+ * plain sleep off Linux), then a short spin for the last SpinNanoseconds
+ * because sleeps wake late.
+ * Deadlines come from the cycles Execute reports, so instructions that run
+ * over a slice boundary shift the timeline instead of accumulating drift.
+ */
+struct m6502::Pacer
+{
+    // a SliceCycles or ClockHz that is not positive is replaced by the default
+    explicit Pacer(const PacerConfig& Config = PacerConfig());
+
+    // start the timeline now, the next Execute paces from here
+    void Restart();
+
+    /** Run at least Cycles cycles in real time, starts the timeline on first use
+     *  @return the number of cycles that were used */
+    template<typename TVariant = NMOS6502, typename TMem = Mem>
+    u64 Execute(CPU& cpu, TMem& memory, u64 Cycles);
+
+    const JitterStats& Stats() const
+    {
+        return Jitter;
+    }
+
+    void ResetStats()
+    {
+        Jitter.Reset();
+    }
+
+    // monotonic clock in nanoseconds
+    static s64 Now();
+
+private:
+    // sleep and spin until Deadline, returns how late it woke up
+    s64 WaitUntil(s64 Deadline) const;
+
+    s64 DeadlineFor(u64 Cycles) const
+    {
+        // split so long runs do not overflow
+        const u64 Seconds = Cycles / Config.ClockHz;
+        const u64 Rest = Cycles % Config.ClockHz;
+        return Origin + static_cast<s64>(Seconds * 1000000000ull + (Rest * 1000000000ull) / Config.ClockHz);
+    }
+
+    PacerConfig Config;
+    JitterStats Jitter;
+    bool Started = false;
+    s64 Origin = 0;         // time at which CyclesRun was 0
+    u64 CyclesRun = 0;
+};
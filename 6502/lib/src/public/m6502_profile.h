@@ -0,0 +1,54 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct OpcodeProfile;
+}
+
+/**
+ * Counts which opcodes follow each other in execution order, as pairs and
+ * triples. Profiles are saved as text so runs over several workloads can be
+ * merged by loading them into the same OpcodeProfile; M6502Superinstructions
+ * turns the hottest sequences into fused handlers.
+ */
+struct m6502::OpcodeProfile
+{
+    OpcodeProfile();
+
+    /** Runs the interpreter one instruction at a time and records each opcode
+     *  @return the number of cycles that were used */
+    s32 Execute(CPU& cpu, Mem& memory, s32 Cycles);
+
+    void Record(Byte Opcode);
+
+    // an interrupt or a jump into other code breaks the current sequence
+    void BreakSequence()
+    {
+        HistoryLength = 0;
+    }
+
+    u64 PairCount(Byte First, Byte Second) const
+    {
+        return Pairs[(First << 8) | Second];
+    }
+
+    u64 TripleCount(Byte First, Byte Second, Byte Third) const;
+
+    // text lines "pair AA BB count" and "triple AA BB CC count"
+    bool Save(const char* Path) const;
+
+    // adds the counts in the file to this profile
+    bool Load(const char* Path);
+
+    std::vector<u64> Pairs;
+    std::unordered_map<u32, u64> Triples;
+
+private:
+    Byte History[2];
+    u32 HistoryLength = 0;
+};
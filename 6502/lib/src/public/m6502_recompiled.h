@@ -0,0 +1,43 @@
+#pragma once
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct RecompiledProgram;
+}
+
+/**
+ * Runtime side of the static recompiler (see 6502/recompiler).
+ * The generated source defines one RecompiledProgram whose RunBlock runs
+ * the native code for the basic block starting at cpu.PC. Execute mixes
+ * those blocks with the interpreter: anything the recompiler could not
+ * prove (indirect jumps, code that has been overwritten, pending
+ * interrupts) runs one instruction at a time through CPU::Execute, so the
+ * results match the interpreter's register, memory and cycle results.
+ * Generated code follows the NMOS6502 variant.
+ */
+struct m6502::RecompiledProgram
+{
+    // runs the block at cpu.PC, false if there is none or its code changed
+    using RunBlockFunction = bool (*)(CPU& cpu, Mem& memory, s32& Cycles);
+
+    RunBlockFunction RunBlock;
+
+    /** Same contract as CPU::Execute
+     *  @return the number of cycles that were used */
+    s32 Execute(CPU& cpu, Mem& memory, s32 Cycles) const;
+
+    // true when memory still holds the bytes a block was compiled from
+    static bool CodeMatches(const Mem& memory, Word Address, const Byte* Code, u32 Size)
+    {
+        for (u32 i = 0; i < Size; i++)
+        {
+            if (memory.Read(static_cast<Word>(Address + i)) != Code[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
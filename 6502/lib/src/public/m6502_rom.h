@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct RomImage;
+}
+
+/**
+ * Immutable firmware image that can be mapped into any number of SparseMem
+ * instances by reference. Register it once with Create and hand the shared
+ * pointer to every machine that runs the same firmware.
+ */
+struct m6502::RomImage
+{
+    static constexpr u32 PAGE_SIZE = 256;
+
+    // copy Size bytes into a new image, the last page is padded with zeros
+    static std::shared_ptr<const RomImage> Create(const Byte* Data, u32 Size);
+
+    u32 Size() const
+    {
+        return ImageSize;
+    }
+
+    u32 NumPages() const
+    {
+        return (ImageSize + PAGE_SIZE - 1) / PAGE_SIZE;
+    }
+
+    const Byte* Page(u32 PageIndex) const
+    {
+        return Bytes.data() + PageIndex * PAGE_SIZE;
+    }
+
+    Byte operator[](u32 Offset) const
+    {
+        return Bytes[Offset];
+    }
+
+private:
+    RomImage() = default;
+
+    std::vector<Byte> Bytes;
+    u32 ImageSize = 0;
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct SanitizerReport;
+	struct SanitizedMem;
+}
+
+struct m6502::SanitizerReport
+{
+    enum ErrorKind : Byte
+    {
+        NONE,
+        UNINITIALIZED_READ,     // the cpu read a byte nothing had written since Reset
+        STACK_OVERFLOW,         // a push wrapped the stack pointer below $0100
+        STACK_UNDERFLOW,        // a pop wrapped the stack pointer above $01FF
+        EXECUTE_NON_CODE,       // an opcode was fetched from a page not marked as code
+    };
+
+    ErrorKind Kind = NONE;
+    Word PC = 0;                // first byte of the instruction (or interrupt entry) at fault
+    Word Address = 0;           // the byte read, the stack pointer or the opcode address
+
+    static const char* KindName(ErrorKind Kind);
+};
+
+/**
+ * 64KB of ram with a shadow bitmap of the bytes that have been written, for
+ * runs that should catch program bugs instead of running through them.
+ * Execute<TVariant, SanitizedMem> is the sanitizer build of the cpu: it tells
+ * the memory where each instruction starts and checks the stack pointer on
+ * every push and pop, the other backends compile those hooks away. The first
+ * problem is kept in Report (and printed), and by default Execute stops at
+ * the next instruction boundary.
+ *
+ * Reset clears the shadow so power on ram counts as uninitialized, bytes
+ * loaded through operator[] count as written. Executing from a non-code page
+ * is only checked once MarkCode has been called.
+ */
+struct m6502::SanitizedMem
+{
+    static constexpr u32 MAX_MEM = Mem::MAX_MEM;
+    static constexpr u32 NUM_PAGES = MAX_MEM / 256;
+
+    SanitizedMem();
+
+    void Initialize();
+
+    // read 1 byte, not checked
+    Byte operator[](u32 Address) const
+    {
+        return Data[Address];
+    }
+
+    // write 1 byte, loading an image marks it as initialized
+    Byte& operator[](u32 Address)
+    {
+        MarkWritten(Address);
+        return Data[Address];
+    }
+
+    // read 1 byte on behalf of the cpu
+    Byte Read(Word Address) const
+    {
+        if ((Written[Address >> 5] & (1u << (Address & 31))) == 0)
+        {
+            Fail(SanitizerReport::UNINITIALIZED_READ, Address);
+        }
+        return Data[Address];
+    }
+
+    // write 1 byte on behalf of the cpu
+    void Write(Word Address, Byte Value)
+    {
+        MarkWritten(Address);
+        Data[Address] = Value;
+    }
+
+    // the pages holding [Address, Address + Size) may be executed
+    void MarkCode(Word Address, u32 Size);
+
+    // treat [Address, Address + Size) as initialized, e.g. memory mapped inputs
+    void MarkInitialized(Word Address, u32 Size);
+
+    bool HasReport() const
+    {
+        return Report.Kind != SanitizerReport::NONE;
+    }
+
+    // forget the report so the run can go on
+    void ClearReport()
+    {
+        Report = SanitizerReport();
+    }
+
+    mutable SanitizerReport Report;    // filled in by const reads
+    bool HaltOnReport = true;   // Execute returns at the instruction after the report
+
+    // hooks called by CPU::Execute, see the class comment
+
+    // false stops Execute
+    bool BeginInstruction(Word PC, s32 /*Elapsed*/)
+    {
+        InstructionPC = PC;
+        if (CheckCode && (CodePages[PC >> 13] & (1u << ((PC >> 8) & 31))) == 0)
+        {
+            Fail(SanitizerReport::EXECUTE_NON_CODE, PC);
+        }
+        return !(HaltOnReport && HasReport());
+    }
+
+    void BeginInterrupt(Word PC)
+    {
+        InstructionPC = PC;
+    }
+
+    // Count bytes are about to be pushed at SP
+    void CheckPush(Byte SP, Byte Count) const
+    {
+        if (SP < Count)
+        {
+            Fail(SanitizerReport::STACK_OVERFLOW, 0x100 | SP);
+        }
+    }
+
+    // Count bytes are about to be popped above SP
+    void CheckPop(Byte SP, Byte Count) const
+    {
+        if (SP > 0xFF - Count)
+        {
+            Fail(SanitizerReport::STACK_UNDERFLOW, 0x100 | SP);
+        }
+    }
+
+private:
+    void MarkWritten(u32 Address)
+    {
+        Written[Address >> 5] |= 1u << (Address & 31);
+    }
+
+    // keeps the first report only
+    void Fail(SanitizerReport::ErrorKind Kind, Word Address) const;
+
+    Byte Data[MAX_MEM];
+    u32 Written[MAX_MEM / 32];
+    u32 CodePages[NUM_PAGES / 32];
+    bool CheckCode = false;
+    Word InstructionPC = 0;
+};
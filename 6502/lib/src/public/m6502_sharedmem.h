@@ -0,0 +1,118 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct SharedRegion;
+	struct SystemMem;
+}
+
+/**
+ * Pages of ram that several cpus see at once, like a dual port ram window
+ * or a block of mailbox registers. Every byte is a std::atomic so cores on
+ * different host threads can read and write it without locks; stores
+ * release and loads acquire, so a core that sees a mailbox byte change also
+ * sees everything the other core wrote to shared memory before it.
+ */
+struct m6502::SharedRegion
+{
+    static constexpr u32 PAGE_SIZE = 256;
+
+    static std::shared_ptr<SharedRegion> Create(u32 NumPages);
+
+    u32 NumPages() const
+    {
+        return PageCount;
+    }
+
+    std::atomic<Byte>* Page(u32 PageIndex)
+    {
+        return Bytes.get() + PageIndex * PAGE_SIZE;
+    }
+
+    Byte Read(u32 Offset) const
+    {
+        return Bytes[Offset].load(std::memory_order_acquire);
+    }
+
+    void Write(u32 Offset, Byte Value)
+    {
+        Bytes[Offset].store(Value, std::memory_order_release);
+    }
+
+private:
+    SharedRegion() = default;
+
+    std::unique_ptr<std::atomic<Byte>[]> Bytes;
+    u32 PageCount = 0;
+};
+
+/**
+ * Memory of one core in a System: 64KB of private ram with SharedRegions
+ * mapped over whole pages. Private accesses are plain loads and stores,
+ * only pages that are mapped shared pay for the atomic.
+ */
+struct m6502::SystemMem
+{
+    static constexpr u32 MAX_MEM = Mem::MAX_MEM;
+    static constexpr u32 PAGE_SIZE = SharedRegion::PAGE_SIZE;
+    static constexpr u32 NUM_PAGES = MAX_MEM / PAGE_SIZE;
+
+    SystemMem();
+
+    SystemMem(const SystemMem&) = delete;
+    SystemMem& operator=(const SystemMem&) = delete;
+
+    // clear the private ram, shared regions belong to the system and keep their contents
+    void Initialize();
+
+    // NumPages pages starting at Address lie on page boundaries inside 64KB
+    static bool Fits(Word Address, u32 NumPages)
+    {
+        return (Address & 0xFF) == 0 && (Address >> 8) + NumPages <= NUM_PAGES;
+    }
+
+    // map a shared region at a page aligned address, false (nothing mapped) if it does not fit
+    bool MapShared(std::shared_ptr<SharedRegion> Region, Word Address);
+
+    bool IsShared(Word Address) const
+    {
+        return SharedPages[Address >> 8] != nullptr;
+    }
+
+    // read 1 byte
+    Byte operator[](u32 Address) const
+    {
+        return Read(static_cast<Word>(Address));
+    }
+
+    // read 1 byte on behalf of the cpu
+    Byte Read(Word Address) const
+    {
+        if (std::atomic<Byte>* Page = SharedPages[Address >> 8])
+        {
+            return Page[Address & 0xFF].load(std::memory_order_acquire);
+        }
+        return Data[Address];
+    }
+
+    // write 1 byte on behalf of the cpu
+    void Write(Word Address, Byte Value)
+    {
+        if (std::atomic<Byte>* Page = SharedPages[Address >> 8])
+        {
+            Page[Address & 0xFF].store(Value, std::memory_order_release);
+            return;
+        }
+        Data[Address] = Value;
+    }
+
+private:
+    std::atomic<Byte>* SharedPages[NUM_PAGES];
+    std::vector<std::shared_ptr<SharedRegion>> Regions;
+    Byte Data[MAX_MEM];
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "m6502.h"
+#include "m6502_rom.h"
+
+namespace m6502
+{
+	struct SparseMem;
+	struct PagePool;
+}
+
+/**
+ * Hands out zeroed 256 byte pages for SparseMem.
+ * Each thread has its own free list so allocating a page never takes a lock,
+ * pages left on a thread's list when it exits go back to a shared list.
+ */
+struct m6502::PagePool
+{
+    static constexpr u32 PAGE_SIZE = 256;
+    static constexpr u32 PAGES_PER_CHUNK = 64;
+
+    // get the pool for the calling thread
+    static PagePool& ThisThread();
+
+    // read only page of zeros that unallocated pages point at
+    static const Byte* ZeroPage();
+
+    // scratch page that swallows writes to rom
+    Byte* DiscardPage()
+    {
+        return Discard;
+    }
+
+    Byte* Allocate();
+    void Free(Byte* Page);
+
+    ~PagePool();
+
+private:
+    struct FreePage
+    {
+        FreePage* Next;
+    };
+
+    void Refill();
+
+    FreePage* FreeList = nullptr;
+    Byte Discard[PAGE_SIZE];
+};
+
+/**
+ * 64KB address space made of 256 byte pages that are only allocated on first write.
+ * Pages that were never written read as zero, so a program touching the zero page,
+ * the stack and a few code pages costs a few KB instead of the full 64KB.
+ */
+struct m6502::SparseMem
+{
+    static constexpr u32 MAX_MEM = Mem::MAX_MEM;
+    static constexpr u32 PAGE_SIZE = PagePool::PAGE_SIZE;
+    static constexpr u32 NUM_PAGES = MAX_MEM / PAGE_SIZE;
+
+    SparseMem();
+    ~SparseMem();
+
+    SparseMem(const SparseMem&) = delete;
+    SparseMem& operator=(const SparseMem&) = delete;
+
+    // give all ram pages back to the pool, everything but rom reads as zero again
+    void Initialize();
+
+    // map a rom image read only at a page aligned address, writes to it are ignored,
+    // false (nothing mapped) if the address is not page aligned or the image runs past 64KB
+    bool MapRom(std::shared_ptr<const RomImage> Rom, Word Address);
+
+    // read 1 byte
+    Byte operator[](u32 Address) const
+    {
+        return Read(Address);
+    }
+
+    // write 1 byte, allocates the page if needed (writes to rom are dropped)
+    Byte& operator[](u32 Address)
+    {
+        return WritablePage(Address >> 8)[Address & 0xFF];
+    }
+
+    // read 1 byte on behalf of the cpu
+    Byte Read(Word Address) const
+    {
+        return Pages[Address >> 8][Address & 0xFF];
+    }
+
+    // write 1 byte on behalf of the cpu
+    void Write(Word Address, Byte Value)
+    {
+        WritablePage(Address >> 8)[Address & 0xFF] = Value;
+    }
+
+    // number of pages that are backed by their own storage
+    u32 NumAllocatedPages() const;
+
+private:
+    Byte* WritablePage(u32 PageIndex)
+    {
+        if (!IsSet(Owned, PageIndex))
+        {
+            return UnownedPage(PageIndex);
+        }
+        return const_cast<Byte*>(Pages[PageIndex]);
+    }
+
+    static bool IsSet(const u32* Bits, u32 PageIndex)
+    {
+        return (Bits[PageIndex >> 5] >> (PageIndex & 31)) & 1;
+    }
+
+    // first write to a zero page or any write to rom
+    Byte* UnownedPage(u32 PageIndex);
+
+    const Byte* Pages[NUM_PAGES];
+    u32 Owned[NUM_PAGES / 32];
+    u32 RomPages[NUM_PAGES / 32];
+    std::vector<std::shared_ptr<const RomImage>> Roms;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct Superinstructions;
+}
+
+/**
+ * Runtime side of profile-guided superinstructions (see
+ * M6502Superinstructions). Handlers[Opcode] runs the fused handler for
+ * sequences starting with that opcode: it executes the first instruction,
+ * then keeps going for as long as the following opcodes match one of the
+ * generated sequences, updating the cycle count once at the end. Opcodes
+ * without a handler, and every instruction while an interrupt is pending,
+ * go through CPU::Execute. Generated handlers follow the NMOS6502 variant.
+ */
+struct m6502::Superinstructions
+{
+    static constexpr u32 MAX_LENGTH = 3;
+
+    using Handler = void (*)(CPU& cpu, Mem& memory, s32& Cycles);
+
+    // one of the fused opcode sequences, in execution order
+    struct Sequence
+    {
+        u32 Length;
+        Byte Opcodes[MAX_LENGTH];
+    };
+
+    const Handler* Handlers;    // 256 entries, nullptr where nothing is fused
+    const Sequence* Sequences;
+    u32 NumSequences;
+
+    /** Same contract as CPU::Execute
+     *  @return the number of cycles that were used */
+    s32 Execute(CPU& cpu, Mem& memory, s32 Cycles) const;
+};
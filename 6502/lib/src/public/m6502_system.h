@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "m6502.h"
+#include "m6502_sharedmem.h"
+
+namespace m6502
+{
+	struct SystemConfig;
+	struct System;
+}
+
+struct m6502::SystemConfig
+{
+    u32 NumCores = 2;
+    s32 Quantum = 256;      // cycles a core runs between looking at the others, more than 0
+    u64 MaxSkew = 1024;     // how far a core may run ahead of the slowest one
+};
+
+/**
+ * Several cpus with private memory and shared regions, each running on its
+ * own host thread. Instead of stepping the cores in lockstep every core runs
+ * Quantum cycles at a time and only waits when it gets more than MaxSkew
+ * cycles ahead of the slowest running core, so the cores stay within a
+ * bounded number of cycles of each other and rarely wait at all.
+ */
+struct m6502::System
+{
+    struct Core
+    {
+        CPU cpu;
+        SystemMem memory;
+
+        // total cycles this core has run, read by the other cores while running
+        alignas(64) std::atomic<u64> CyclesRun{0};
+        std::atomic<bool> Running{false};
+    };
+
+    explicit System(const SystemConfig& Config = SystemConfig());
+
+    u32 NumCores() const
+    {
+        return static_cast<u32>(Cores.size());
+    }
+
+    Core& GetCore(u32 Index)
+    {
+        return *Cores[Index];
+    }
+
+    // create a shared region and map it at the same address in every core,
+    // nullptr if the pages are not aligned or run past 64KB
+    std::shared_ptr<SharedRegion> MapShared(Word Address, u32 NumPages);
+
+    // run every core for at least Cycles more cycles, one host thread per core
+    template<typename TVariant = NMOS6502>
+    void Run(u64 Cycles);
+
+private:
+    template<typename TVariant>
+    void RunCore(u32 Index, u64 Cycles);
+
+    // cycles run by the slowest other core that has not finished
+    bool SlowestOther(u32 Index, u64& Slowest) const;
+
+    SystemConfig Config;
+    std::vector<std::unique_ptr<Core>> Cores;
+};
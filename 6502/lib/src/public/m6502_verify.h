@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct Checkpoint;
+	struct CheckpointLog;
+	struct VerifyReport;
+	struct RunVerifier;
+}
+
+// a machine at Cycle: registers, interrupt lines and all 64KB of ram
+struct m6502::Checkpoint
+{
+    u64 Cycle = 0;
+    Word PC = 0;
+    Byte SP = 0, A = 0, X = 0, Y = 0;
+    Byte PS = 0;                // as GetPS
+    u32 Interrupts = 0;         // pending lines
+    std::vector<Byte> Memory;   // Mem::MAX_MEM bytes
+
+    static Checkpoint Capture(u64 Cycle, const CPU& cpu, const Mem& memory);
+    void Restore(CPU& cpu, Mem& memory) const;
+
+    bool SameRegisters(const CPU& cpu) const
+    {
+        return PC == cpu.PC && SP == cpu.SP && A == cpu.A && X == cpu.X && Y == cpu.Y && PS == cpu.GetPS()
+            && Interrupts == cpu.Interrupts.Pending.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * A recorded run as checkpoints in cycle order, the first one where the run
+ * started. Saved with each checkpoint holding only the pages that differ
+ * from the one before, so an hour of emulated time at a checkpoint every few
+ * million cycles takes little more than the ram the program touches.
+ */
+struct m6502::CheckpointLog
+{
+    std::vector<Checkpoint> Checkpoints;
+
+    /** Run the cpu for at least Cycles cycles, capturing it every Interval cycles
+     *  (at the first instruction boundary at or past it). An empty log gets the
+     *  starting state first, otherwise the cpu has to be in the state of the last
+     *  checkpoint and the run carries on from its cycle.
+     *  @return the number of cycles that were used */
+    template<typename TVariant = NMOS6502>
+    u64 Record(CPU& cpu, Mem& memory, u64 Cycles, u64 Interval);
+
+    bool Save(const char* Path) const;
+    bool Load(const char* Path);
+
+    // encoded form used by Save and Load
+    std::vector<Byte> Encode() const;
+    bool Decode(const std::vector<Byte>& Encoded);
+};
+
+struct m6502::VerifyReport
+{
+    enum DifferenceKind : Byte
+    {
+        NONE,
+        OVERSHOT,       // no instruction ended on the next checkpoint's cycle
+        REGISTERS,      // registers, flags or interrupt lines differ
+        MEMORY,         // a byte of ram differs, the lowest one is Address
+    };
+
+    DifferenceKind Kind = NONE;
+    size_t Segment = 0;         // the segment runs from checkpoint Segment to Segment + 1
+    u64 StartCycle = 0;         // cycle of the checkpoint it started from
+    u64 Cycle = 0;              // cycle the difference was seen on
+    Word Address = 0;
+    u64 SegmentsRun = 0;
+
+    bool Diverged() const
+    {
+        return Kind != NONE;
+    }
+
+    static const char* KindName(DifferenceKind Kind);
+};
+
+/**
+ * Re-runs a CheckpointLog on the current interpreter, every segment
+ * between two checkpoints on its own thread from the state it started in,
+ * so verifying a long run takes its length divided by the number of cores.
+ * Each segment is executed to the cycle of the next checkpoint and the
+ * machine compared with it. Runs on Mem only: a recording of a machine fed
+ * by devices or live input needs those replayed as well.
+ */
+struct m6502::RunVerifier
+{
+    /** Verify every segment of Log on NumThreads threads
+     *  @return the earliest segment that diverged, or Kind NONE */
+    template<typename TVariant = NMOS6502>
+    static VerifyReport Verify(const CheckpointLog& Log, u32 NumThreads);
+
+    // one segment on the calling thread, cpu and memory are the scratch machine
+    template<typename TVariant = NMOS6502>
+    static VerifyReport VerifySegment(const CheckpointLog& Log, size_t Segment, CPU& cpu, Mem& memory);
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "m6502_devices.h"
+
+namespace m6502
+{
+	struct Via6522;
+}
+
+/**
+ * MOS 6522 VIA on a DeviceMem, its 16 registers at Base. The timers are
+ * not counted down: loading a counter notes the cycle it was loaded on and
+ * reading it works the value out from the cycles since, so a timer nobody
+ * looks at costs nothing. The cycle of the next underflow goes to the
+ * DeviceScheduler only while its interrupt is enabled, one wake up per
+ * interrupt, and flags are brought up to date when the cpu reads a
+ * register. Accesses happen at the cycle their instruction starts.
+ *
+ * T1 underflows N + 1 cycles after N is loaded and reloads from the latch
+ * a cycle later in continuous mode (a period of latch + 2), in one shot
+ * mode it interrupts once and keeps counting down. Ports read
+ * (OR & DDR) | (Pins & ~DDR). The shift register, the PCR handshakes and
+ * CA/CB lines, the PB7 output and T2 pulse counting are not emulated, SR
+ * and PCR only hold what was written.
+ */
+struct m6502::Via6522
+{
+    enum Register : Byte
+    {
+        ORB, ORA, DDRB, DDRA, T1CL, T1CH, T1LL, T1LH,
+        T2CL, T2CH, SR, ACR, PCR, IFR, IER, ORA_NH,
+        NUM_REGISTERS
+    };
+
+    // IFR and IER bits
+    enum InterruptBit : Byte
+    {
+        IRQ_CA2 = 0x01,
+        IRQ_CA1 = 0x02,
+        IRQ_SR = 0x04,
+        IRQ_CB2 = 0x08,
+        IRQ_CB1 = 0x10,
+        IRQ_T2 = 0x20,
+        IRQ_T1 = 0x40,
+        IRQ_ANY = 0x80,     // IFR: an enabled flag is set, IER: write sets instead of clears
+    };
+
+    static constexpr Byte ACR_T1_CONTINUOUS = 0x40;
+
+    // IrqSource is the InterruptLines bit the chip holds the irq line with
+    Via6522(DeviceScheduler& Scheduler, DeviceMem& Memory, CPU& cpu, Word Base, u32 IrqSource = 1);
+
+    Via6522(const Via6522&) = delete;
+    Via6522& operator=(const Via6522&) = delete;
+
+    // a register access as the cpu makes it, at the scheduler's current cycle
+    Byte Read(Byte Reg);
+    void Write(Byte Reg, Byte Value);
+
+    // levels driven onto the port pins from outside
+    Byte PinsA = 0xFF;
+    Byte PinsB = 0xFF;
+
+    // levels the chip drives onto the output pins
+    Byte OutputA() const
+    {
+        return Ora & Ddra;
+    }
+
+    Byte OutputB() const
+    {
+        return Orb & Ddrb;
+    }
+
+private:
+    DeviceTask Bus();
+
+    // set the flags of underflows up to Cycle
+    void Update(u64 Cycle);
+    void UpdateIrq();
+    void Schedule();
+
+    // T1 at Cycle, Reload when it loads the latch on the next cycle
+    void T1At(u64 Cycle, Word& Value, bool& Reload) const;
+
+    // restart the T1 arithmetic from its state at Cycle
+    void RebaseT1(u64 Cycle);
+
+    u64 T1FirstUnderflow() const
+    {
+        return T1Base + (T1Reload ? u64(T1Latch) + 2 : u64(T1Value) + 1);
+    }
+
+    u64 T2Underflow() const
+    {
+        return T2Base + u64(T2Value) + 1;
+    }
+
+    DeviceScheduler& Scheduler;
+    DeviceMem& Memory;
+    CPU& cpu;
+    Word Base;
+    u32 IrqSource;
+
+    Byte Orb = 0, Ora = 0, Ddrb = 0, Ddra = 0;
+    Byte Sr = 0, Acr = 0, Pcr = 0, Ifr = 0, Ier = 0;
+
+    Word T1Latch = 0;
+    Word T1Value = 0;           // T1 at T1Base
+    u64 T1Base = 0;
+    bool T1Reload = false;      // T1 loads the latch on the cycle after T1Base
+    bool T1Armed = false;       // the next underflow sets the T1 flag
+    u64 T1Next = 0;             // cycle of that underflow
+
+    Byte T2LatchLow = 0;
+    Word T2Value = 0;           // T2 at T2Base
+    u64 T2Base = 0;
+    bool T2Armed = false;
+
+    DeviceAlarm T1Alarm;
+    DeviceAlarm T2Alarm;
+};
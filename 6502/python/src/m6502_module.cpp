@@ -0,0 +1,290 @@
+// Python extension module wrapping the C API.
+//
+//   import m6502
+//   m = m6502.Machine()
+//   mem = memoryview(m)          # writable, no copy (numpy.asarray(m) works too)
+//   mem[0xFFFC] = 0xA9
+//   m.run(1000)                  # releases the GIL while the cpu runs
+//   print(m.a, m.pc)
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <atomic>
+#include <new>
+
+#include "m6502_capi.h"
+
+namespace
+{
+    struct MachineObject
+    {
+        PyObject_HEAD
+        m6502_machine* Machine;
+        std::atomic<bool> Running;
+    };
+
+    // the machine is created here, not in __init__, so no Machine object exists without one
+    PyObject* Machine_new(PyTypeObject* Type, PyObject*, PyObject*)
+    {
+        MachineObject* self = reinterpret_cast<MachineObject*>(Type->tp_alloc(Type, 0));
+        if (self == nullptr)
+        {
+            return nullptr;
+        }
+        new (&self->Running) std::atomic<bool>(false);
+        self->Machine = m6502_create();
+        if (self->Machine == nullptr)
+        {
+            Py_DECREF(self);
+            return PyErr_NoMemory();
+        }
+        return reinterpret_cast<PyObject*>(self);
+    }
+
+    int Machine_init(MachineObject*, PyObject* args, PyObject* kwds)
+    {
+        static const char* Keywords[] = { nullptr };
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "", const_cast<char**>(Keywords)))
+        {
+            return -1;
+        }
+        return 0;
+    }
+
+    void Machine_dealloc(MachineObject* self)
+    {
+        if (self->Machine != nullptr)
+        {
+            m6502_destroy(self->Machine);
+        }
+        // instances of a heap type hold a reference to it
+        PyTypeObject* Type = Py_TYPE(self);
+        Type->tp_free(reinterpret_cast<PyObject*>(self));
+        Py_DECREF(Type);
+    }
+
+    // only one thread may drive a machine at a time, the GIL is not held while it runs
+    bool AcquireMachine(MachineObject* self)
+    {
+        bool Expected = false;
+        if (!self->Running.compare_exchange_strong(Expected, true))
+        {
+            PyErr_SetString(PyExc_RuntimeError, "machine is already running on another thread");
+            return false;
+        }
+        return true;
+    }
+
+    PyObject* Machine_run(MachineObject* self, PyObject* args)
+    {
+        long long Cycles = 0;
+        if (!PyArg_ParseTuple(args, "L", &Cycles))
+        {
+            return nullptr;
+        }
+        if (!AcquireMachine(self))
+        {
+            return nullptr;
+        }
+
+        long long CyclesUsed = 0;
+        Py_BEGIN_ALLOW_THREADS
+        // execute in slices so a very long run does not overflow the 32 bit budget
+        while (CyclesUsed < Cycles)
+        {
+            const long long Remaining = Cycles - CyclesUsed;
+            const int32_t Slice = Remaining > 0x40000000 ? 0x40000000 : static_cast<int32_t>(Remaining);
+            CyclesUsed += m6502_execute(self->Machine, Slice);
+        }
+        Py_END_ALLOW_THREADS
+
+        self->Running.store(false);
+        return PyLong_FromLongLong(CyclesUsed);
+    }
+
+    PyObject* Machine_reset(MachineObject* self, PyObject*)
+    {
+        if (!AcquireMachine(self))
+        {
+            return nullptr;
+        }
+        m6502_reset(self->Machine);
+        self->Running.store(false);
+        Py_RETURN_NONE;
+    }
+
+    PyObject* Machine_irq(MachineObject* self, PyObject* args)
+    {
+        unsigned int SourceMask = 1;
+        if (!PyArg_ParseTuple(args, "|I", &SourceMask))
+        {
+            return nullptr;
+        }
+        m6502_raise_irq(self->Machine, SourceMask);
+        Py_RETURN_NONE;
+    }
+
+    PyObject* Machine_clear_irq(MachineObject* self, PyObject* args)
+    {
+        unsigned int SourceMask = 1;
+        if (!PyArg_ParseTuple(args, "|I", &SourceMask))
+        {
+            return nullptr;
+        }
+        m6502_clear_irq(self->Machine, SourceMask);
+        Py_RETURN_NONE;
+    }
+
+    PyObject* Machine_nmi(MachineObject* self, PyObject*)
+    {
+        m6502_raise_nmi(self->Machine);
+        Py_RETURN_NONE;
+    }
+
+    PyMethodDef Machine_methods[] =
+    {
+        { "run", reinterpret_cast<PyCFunction>(Machine_run), METH_VARARGS,
+          "run(cycles) -> cycles used. Runs without holding the GIL." },
+        { "reset", reinterpret_cast<PyCFunction>(Machine_reset), METH_NOARGS,
+          "Reset the cpu and clear memory." },
+        { "irq", reinterpret_cast<PyCFunction>(Machine_irq), METH_VARARGS,
+          "irq(source_mask=1) asserts the irq line." },
+        { "clear_irq", reinterpret_cast<PyCFunction>(Machine_clear_irq), METH_VARARGS,
+          "clear_irq(source_mask=1) releases the irq line." },
+        { "nmi", reinterpret_cast<PyCFunction>(Machine_nmi), METH_NOARGS,
+          "Signal an nmi." },
+        { nullptr, nullptr, 0, nullptr }
+    };
+
+    // register accessors, the closure says which register
+    enum Register { REG_PC, REG_SP, REG_A, REG_X, REG_Y, REG_PS };
+
+    PyObject* Machine_get_reg(MachineObject* self, void* Closure)
+    {
+        if (!AcquireMachine(self))
+        {
+            return nullptr;
+        }
+        m6502_regs Regs;
+        m6502_get_regs(self->Machine, &Regs);
+        self->Running.store(false);
+        switch (static_cast<Register>(reinterpret_cast<intptr_t>(Closure)))
+        {
+        case REG_PC: return PyLong_FromLong(Regs.pc);
+        case REG_SP: return PyLong_FromLong(Regs.sp);
+        case REG_A: return PyLong_FromLong(Regs.a);
+        case REG_X: return PyLong_FromLong(Regs.x);
+        case REG_Y: return PyLong_FromLong(Regs.y);
+        case REG_PS: return PyLong_FromLong(Regs.ps);
+        }
+        Py_RETURN_NONE;
+    }
+
+    int Machine_set_reg(MachineObject* self, PyObject* Value, void* Closure)
+    {
+        const Register Reg = static_cast<Register>(reinterpret_cast<intptr_t>(Closure));
+        const long Max = Reg == REG_PC ? 0xFFFF : 0xFF;
+        const long NewValue = Value != nullptr ? PyLong_AsLong(Value) : -1;
+        if (PyErr_Occurred() || NewValue < 0 || NewValue > Max)
+        {
+            PyErr_Clear();
+            PyErr_Format(PyExc_ValueError, "register value must be between 0 and %ld", Max);
+            return -1;
+        }
+
+        if (!AcquireMachine(self))
+        {
+            return -1;
+        }
+        m6502_regs Regs;
+        m6502_get_regs(self->Machine, &Regs);
+        switch (Reg)
+        {
+        case REG_PC: Regs.pc = static_cast<uint16_t>(NewValue); break;
+        case REG_SP: Regs.sp = static_cast<uint8_t>(NewValue); break;
+        case REG_A: Regs.a = static_cast<uint8_t>(NewValue); break;
+        case REG_X: Regs.x = static_cast<uint8_t>(NewValue); break;
+        case REG_Y: Regs.y = static_cast<uint8_t>(NewValue); break;
+        case REG_PS: Regs.ps = static_cast<uint8_t>(NewValue); break;
+        }
+        m6502_set_regs(self->Machine, &Regs);
+        self->Running.store(false);
+        return 0;
+    }
+
+    void* RegisterClosure(Register Reg)
+    {
+        return reinterpret_cast<void*>(static_cast<intptr_t>(Reg));
+    }
+
+    PyGetSetDef Machine_getset[] =
+    {
+        { "pc", reinterpret_cast<getter>(Machine_get_reg), reinterpret_cast<setter>(Machine_set_reg), "program counter", RegisterClosure(REG_PC) },
+        { "sp", reinterpret_cast<getter>(Machine_get_reg), reinterpret_cast<setter>(Machine_set_reg), "stack pointer", RegisterClosure(REG_SP) },
+        { "a", reinterpret_cast<getter>(Machine_get_reg), reinterpret_cast<setter>(Machine_set_reg), "accumulator", RegisterClosure(REG_A) },
+        { "x", reinterpret_cast<getter>(Machine_get_reg), reinterpret_cast<setter>(Machine_set_reg), "index register x", RegisterClosure(REG_X) },
+        { "y", reinterpret_cast<getter>(Machine_get_reg), reinterpret_cast<setter>(Machine_set_reg), "index register y", RegisterClosure(REG_Y) },
+        { "ps", reinterpret_cast<getter>(Machine_get_reg), reinterpret_cast<setter>(Machine_set_reg), "processor status", RegisterClosure(REG_PS) },
+        { nullptr, nullptr, nullptr, nullptr, nullptr }
+    };
+
+    // the machine itself is the buffer: memoryview(m) / numpy.asarray(m) see Mem::Data directly
+    int Machine_getbuffer(MachineObject* self, Py_buffer* View, int Flags)
+    {
+        return PyBuffer_FillInfo(View, reinterpret_cast<PyObject*>(self),
+            m6502_memory(self->Machine), m6502_memory_size(), 0, Flags);
+    }
+
+    PyType_Slot Machine_slots[] =
+    {
+        { Py_tp_doc, const_cast<char*>("A 6502 cpu with 64KB of memory. Supports the buffer protocol for zero copy memory access.") },
+        { Py_tp_new, reinterpret_cast<void*>(Machine_new) },
+        { Py_tp_init, reinterpret_cast<void*>(Machine_init) },
+        { Py_tp_dealloc, reinterpret_cast<void*>(Machine_dealloc) },
+        { Py_tp_methods, Machine_methods },
+        { Py_tp_getset, Machine_getset },
+        { Py_bf_getbuffer, reinterpret_cast<void*>(Machine_getbuffer) },
+        { 0, nullptr }
+    };
+
+    PyType_Spec MachineSpec =
+    {
+        "m6502.Machine",
+        sizeof(MachineObject),
+        0,
+        Py_TPFLAGS_DEFAULT,
+        Machine_slots
+    };
+
+    PyModuleDef Module =
+    {
+        PyModuleDef_HEAD_INIT,
+        "m6502",
+        "6502 cpu emulator",
+        -1,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr
+    };
+}
+
+PyMODINIT_FUNC PyInit_m6502(void)
+{
+    PyObject* Mod = PyModule_Create(&Module);
+    if (Mod == nullptr)
+    {
+        return nullptr;
+    }
+    PyObject* MachineType = PyType_FromSpec(&MachineSpec);
+    if (MachineType == nullptr || PyModule_AddObject(Mod, "Machine", MachineType) < 0)
+    {
+        Py_XDECREF(MachineType);
+        Py_DECREF(Mod);
+        return nullptr;
+    }
+    PyModule_AddIntConstant(Mod, "ABI_VERSION", m6502_abi_version());
+    return Mod;
+}
@@ -0,0 +1,39 @@
+# Smoke test for the m6502 module, run by ctest with the built module on PYTHONPATH
+import unittest
+
+import m6502
+
+
+class MachineTests(unittest.TestCase):
+
+    def test_a_loaded_program_runs_and_sets_a_register(self):
+        # given:
+        m = m6502.Machine()
+        m.reset()
+        mem = memoryview(m)
+        mem[0x8000] = 0xA9      # LDA #$84
+        mem[0x8001] = 0x84
+
+        # when:
+        m.pc = 0x8000
+        used = m.run(2)
+
+        # then:
+        self.assertEqual(used, 2)
+        self.assertEqual(m.a, 0x84)
+        self.assertEqual(m.pc, 0x8002)
+
+    def test_a_machine_made_without_init_is_usable(self):
+        # given:
+        m = m6502.Machine.__new__(m6502.Machine)
+
+        # when:
+        m.a = 0x42
+
+        # then:
+        self.assertEqual(m.a, 0x42)
+        self.assertEqual(len(memoryview(m)), 0x10000)
+
+
+if __name__ == "__main__":
+    unittest.main()
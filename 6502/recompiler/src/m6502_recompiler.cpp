@@ -0,0 +1,266 @@
+#include "m6502_recompiler.h"
+
+#include <stdarg.h>
+
+namespace
+{
+    void Append(std::string& Out, const char* Format, ...)
+    {
+        char Buffer[512];
+        va_list Args;
+        va_start(Args, Format);
+        vsnprintf(Buffer, sizeof(Buffer), Format, Args);
+        va_end(Args);
+        Out += Buffer;
+    }
+
+    // cycles of an indexed access from Base, with the opcode table's page crossing penalty when it has one
+    void EmitIndexedCycles(std::string& Out, const m6502::OpcodeInfo& Op, const char* Base)
+    {
+        if (Op.PageCrossCycles != 0)
+        {
+            Append(Out, "            Cycles -= ((%s ^ Address) >> 8) ? %u : %u;\n",
+                Base, Op.Cycles + Op.PageCrossCycles, Op.Cycles);
+        }
+        else
+        {
+            Append(Out, "            Cycles -= %u;\n", Op.Cycles);
+        }
+    }
+}
+
+m6502::Recompiler::Recompiler(const std::vector<Byte>& Image, const RecompilerOptions& Options)
+    : Image(Image), Options(Options)
+{
+}
+
+bool m6502::Recompiler::SetsPC(Byte Instruction)
+{
+    return Instruction == CPU::INS_JSR || Instruction == CPU::INS_RTS
+        || Instruction == CPU::INS_JMP_ABS || Instruction == CPU::INS_JMP_IND
+        || Instruction == CPU::INS_BRK || Instruction == CPU::INS_RTI;
+}
+
+m6502::Byte m6502::Recompiler::ByteAt(Word Address) const
+{
+    return Image[static_cast<Word>(Address - Options.Origin)];
+}
+
+m6502::Word m6502::Recompiler::OperandAt(Word Address, AddressMode Mode) const
+{
+    if (OperandSize(Mode) == 2)
+    {
+        return ByteAt(Address + 1) | (ByteAt(Address + 2) << 8);
+    }
+    return ByteAt(Address + 1);
+}
+
+void m6502::Recompiler::Trace()
+{
+    DisassemblerOptions TraceOptions;
+    TraceOptions.Origin = Options.Origin;
+    TraceOptions.Entries = Options.Entries;
+    const ImageAnalysis Analysis = Disassembler::Analyze(Image, TraceOptions);
+
+    Blocks.clear();
+    for (const BasicBlock& Block : Analysis.Blocks)
+    {
+        // zero page and stack code is left to the interpreter, the stack writes of JSR could change it
+        if (Block.Start >= 0x200)
+        {
+            Blocks[Block.Start] = Block.End;
+        }
+    }
+}
+
+std::string m6502::Recompiler::GenerateSource(const std::string& SourceName) const
+{
+    std::string Out;
+    Append(Out, "// Generated by M6502Recompiler from %s, do not edit.\n", SourceName.c_str());
+    Append(Out, "#include \"m6502_recompiled.h\"\n\n");
+    Append(Out, "namespace\n{\n    using namespace m6502;\n");
+
+    for (const std::pair<const Word, u32>& Block : Blocks)
+    {
+        EmitBlock(Out, Block.first);
+    }
+
+    Append(Out, "\n    bool RunBlock(CPU& cpu, Mem& mem, s32& Cycles)\n    {\n");
+    Append(Out, "        switch (cpu.PC)\n        {\n");
+    for (const std::pair<const Word, u32>& Block : Blocks)
+    {
+        Append(Out, "        case 0x%04X: return Block_%04X(cpu, mem, Cycles);\n", Block.first, Block.first);
+    }
+    Append(Out, "        default: return false;\n        }\n    }\n}\n\n");
+    Append(Out, "extern const m6502::RecompiledProgram %s;\n", Options.Name.c_str());
+    Append(Out, "const m6502::RecompiledProgram %s = { RunBlock };\n", Options.Name.c_str());
+    return Out;
+}
+
+void m6502::Recompiler::EmitBlock(std::string& Out, Word Start) const
+{
+    // stores into the block's own bytes must leave it
+    const Word End = static_cast<Word>(Blocks.at(Start));
+    const u32 Size = static_cast<Word>(End - Start);
+
+    Append(Out, "\n    const Byte Code_%04X[] = {", Start);
+    for (u32 i = 0; i < Size; i++)
+    {
+        Append(Out, "%s0x%02X", i == 0 ? " " : ", ", ByteAt(static_cast<Word>(Start + i)));
+    }
+    Append(Out, " };\n\n");
+
+    Append(Out, "    bool Block_%04X(CPU& cpu, Mem& mem, s32& Cycles)\n    {\n", Start);
+    if (Options.CheckCode)
+    {
+        Append(Out, "        if (!RecompiledProgram::CodeMatches(mem, 0x%04X, Code_%04X, sizeof(Code_%04X)))\n", Start, Start, Start);
+        Append(Out, "        {\n            return false;\n        }\n");
+    }
+
+    Word Address = Start;
+    Byte Instruction = 0;
+    while (Address != End)
+    {
+        if (Address != Start)
+        {
+            Append(Out, "        if (Cycles <= 0 || cpu.Interrupts.Pending.load(std::memory_order_relaxed) != 0)\n");
+            Append(Out, "        {\n            cpu.PC = 0x%04X;\n            return true;\n        }\n", Address);
+        }
+        EmitInstruction(Out, Address, Start, End);
+        Instruction = ByteAt(Address);
+        Address = static_cast<Word>(Address + 1 + OperandSize(DecodeOpcode(Instruction).Mode));
+    }
+
+    // fell through into the next block or into code the tracer did not reach
+    if (!SetsPC(Instruction))
+    {
+        Append(Out, "        cpu.PC = 0x%04X;\n        return true;\n", End);
+    }
+    Append(Out, "    }\n");
+}
+
+void m6502::Recompiler::EmitInstruction(std::string& Out, Word Address, Word BlockStart, Word BlockEnd) const
+{
+    const Byte Instruction = ByteAt(Address);
+    const OpcodeInfo Op = DecodeOpcode(Instruction);
+    const Word Operand = OperandAt(Address, Op.Mode);
+    const Word Next = static_cast<Word>(Address + 1 + OperandSize(Op.Mode));
+    const std::string Name = Op.Mnemonic;
+    const bool IsStore = Name == "STA" || Name == "STX" || Name == "STY";
+
+    Append(Out, "        // %04X %s\n", Address, Op.Mnemonic);
+
+    // control flow and flags
+    switch (Instruction)
+    {
+    case CPU::INS_JSR:
+        Append(Out, "        cpu.PushWordToStack(0x%04X, mem);\n", static_cast<Word>(Next - 1));
+        Append(Out, "        cpu.PC = 0x%04X;\n        Cycles -= %u;\n        return true;\n", Operand, Op.Cycles);
+        return;
+    case CPU::INS_RTS:
+        Append(Out, "        cpu.PC = cpu.PopWordFromStack(mem) + 1;\n");
+        Append(Out, "        Cycles -= %u;\n        return true;\n", Op.Cycles);
+        return;
+    case CPU::INS_JMP_ABS:
+        Append(Out, "        cpu.PC = 0x%04X;\n        Cycles -= %u;\n        return true;\n", Operand, Op.Cycles);
+        return;
+    case CPU::INS_JMP_IND:
+    case CPU::INS_BRK:
+    case CPU::INS_RTI:
+        // target is only known at run time, let the interpreter take it
+        Append(Out, "        cpu.PC = 0x%04X;\n        Cycles -= cpu.Execute(1, mem);\n        return true;\n", Address);
+        return;
+    case CPU::INS_SEC: Append(Out, "        cpu.Flag.C = 1;\n        Cycles -= %u;\n", Op.Cycles); return;
+    case CPU::INS_CLC: Append(Out, "        cpu.Flag.C = 0;\n        Cycles -= %u;\n", Op.Cycles); return;
+    case CPU::INS_SED: Append(Out, "        cpu.Flag.D = 1;\n        Cycles -= %u;\n", Op.Cycles); return;
+    case CPU::INS_CLD: Append(Out, "        cpu.Flag.D = 0;\n        Cycles -= %u;\n", Op.Cycles); return;
+    case CPU::INS_SEI: Append(Out, "        cpu.Flag.I = 1;\n        Cycles -= %u;\n", Op.Cycles); return;
+    case CPU::INS_CLI: Append(Out, "        cpu.Flag.I = 0;\n        Cycles -= %u;\n", Op.Cycles); return;
+    }
+
+    // loads, stores and arithmetic: compute Address the way the interpreter's CPU::AddressOf does
+    Append(Out, "        {\n");
+    bool StaticAddress = true;
+    switch (Op.Mode)
+    {
+    case AddressMode::Immediate:
+        break;
+    case AddressMode::ZeroPage:
+        Append(Out, "            const Word Address = 0x%02X;\n            Cycles -= %u;\n", Operand, Op.Cycles);
+        break;
+    case AddressMode::ZeroPageX:
+    case AddressMode::ZeroPageY:
+        StaticAddress = false;
+        Append(Out, "            const Word Address = static_cast<Byte>(0x%02X + cpu.%c);\n            Cycles -= %u;\n",
+            Operand, Op.Mode == AddressMode::ZeroPageX ? 'X' : 'Y', Op.Cycles);
+        break;
+    case AddressMode::Absolute:
+        Append(Out, "            const Word Address = 0x%04X;\n            Cycles -= %u;\n", Operand, Op.Cycles);
+        break;
+    case AddressMode::AbsoluteX:
+    case AddressMode::AbsoluteY:
+    {
+        StaticAddress = false;
+        Append(Out, "            const Word Address = static_cast<Word>(0x%04X + cpu.%c);\n",
+            Operand, Op.Mode == AddressMode::AbsoluteX ? 'X' : 'Y');
+        char Base[8];
+        snprintf(Base, sizeof(Base), "0x%04X", Operand);
+        EmitIndexedCycles(Out, Op, Base);
+    }
+    break;
+    case AddressMode::IndirectX:
+        StaticAddress = false;
+        Append(Out, "            const Byte Pointer = static_cast<Byte>(0x%02X + cpu.X);\n", Operand);
+        Append(Out, "            const Word Address = mem.Read(Pointer) | (mem.Read(static_cast<Word>(Pointer + 1)) << 8);\n");
+        Append(Out, "            Cycles -= %u;\n", Op.Cycles);
+        break;
+    case AddressMode::IndirectY:
+        StaticAddress = false;
+        Append(Out, "            const Word Base = mem.Read(0x%04X) | (mem.Read(0x%04X) << 8);\n", Operand, Operand + 1);
+        Append(Out, "            const Word Address = static_cast<Word>(Base + cpu.Y);\n");
+        EmitIndexedCycles(Out, Op, "Base");
+        break;
+    default:
+        break;
+    }
+
+    const char* Value = "mem.Read(Address)";
+    char Immediate[8];
+    if (Op.Mode == AddressMode::Immediate)
+    {
+        snprintf(Immediate, sizeof(Immediate), "0x%02X", Operand);
+        Value = Immediate;
+        Append(Out, "            Cycles -= %u;\n", Op.Cycles);
+    }
+
+    if (Name == "LDA" || Name == "LDX" || Name == "LDY")
+    {
+        const char Register = Name[2];
+        Append(Out, "            cpu.%c = %s;\n            cpu.LoadRegisterSetStatus(cpu.%c);\n", Register, Value, Register);
+    }
+    else if (Name == "ADC")
+    {
+        Append(Out, "            cpu.AddWithCarry<NMOS6502>(%s);\n", Value);
+    }
+    else if (Name == "SBC")
+    {
+        Append(Out, "            cpu.SubtractWithCarry<NMOS6502>(%s);\n", Value);
+    }
+    else if (IsStore)
+    {
+        Append(Out, "            mem.Write(Address, cpu.%c);\n", Name[2]);
+
+        // a store into this block's own code ends it so the next instruction is fetched again
+        const u32 BlockSize = static_cast<Word>(BlockEnd - BlockStart);
+        if (!StaticAddress)
+        {
+            Append(Out, "            if (static_cast<Word>(Address - 0x%04X) < %u)\n", BlockStart, BlockSize);
+            Append(Out, "            {\n                cpu.PC = 0x%04X;\n                return true;\n            }\n", Next);
+        }
+        else if (static_cast<Word>(Operand - BlockStart) < BlockSize)
+        {
+            Append(Out, "            cpu.PC = 0x%04X;\n            return true;\n", Next);
+        }
+    }
+    Append(Out, "        }\n");
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "m6502_disassembler.h"
+#include "m6502_opcodes.h"
+
+namespace m6502
+{
+	struct RecompilerOptions;
+	struct Recompiler;
+}
+
+struct m6502::RecompilerOptions
+{
+    std::string Name = "RecompiledProgram";     // symbol of the generated RecompiledProgram
+    Word Origin = 0x8000;                       // address the image is loaded at
+    std::vector<Word> Entries;                  // extra entry points besides the vectors
+    bool CheckCode = true;                      // verify block bytes before running them
+};
+
+/**
+ * Offline half of the static recompiler. Takes the basic blocks the
+ * Disassembler traces from the vectors and entry points and writes C++ that
+ * runs each block against CPU and Mem. Instructions it has no native
+ * translation for are left to the interpreter.
+ */
+struct m6502::Recompiler
+{
+    Recompiler(const std::vector<Byte>& Image, const RecompilerOptions& Options);
+
+    void Trace();
+
+    std::string GenerateSource(const std::string& SourceName) const;
+
+    // start and end of each block it generates code for
+    const std::map<Word, u32>& BlockEnds() const
+    {
+        return Blocks;
+    }
+
+private:
+    Byte ByteAt(Word Address) const;
+    Word OperandAt(Word Address, AddressMode Mode) const;
+
+    // the translation of the instruction sets cpu.PC itself
+    static bool SetsPC(Byte Instruction);
+
+    void EmitBlock(std::string& Out, Word Start) const;
+    void EmitInstruction(std::string& Out, Word Address, Word BlockStart, Word BlockEnd) const;
+
+    std::vector<Byte> Image;
+    RecompilerOptions Options;
+    std::map<Word, u32> Blocks;     // start to end, $10000 for a block that ends with the address space
+};
@@ -0,0 +1,328 @@
+#include "m6502_superinstruction_generator.h"
+
+#include <stdarg.h>
+#include <algorithm>
+
+namespace
+{
+    // appends one line indented by Indent spaces
+    void Line(std::string& Out, m6502::u32 Indent, const char* Format, ...)
+    {
+        char Buffer[512];
+        va_list Args;
+        va_start(Args, Format);
+        vsnprintf(Buffer, sizeof(Buffer), Format, Args);
+        va_end(Args);
+        Out.append(Indent, ' ');
+        Out += Buffer;
+        Out += '\n';
+    }
+
+    const char* ModeSuffix(m6502::AddressMode Mode)
+    {
+        using m6502::AddressMode;
+        switch (Mode)
+        {
+        case AddressMode::Immediate: return " #imm";
+        case AddressMode::ZeroPage: return " zp";
+        case AddressMode::ZeroPageX: return " zp,X";
+        case AddressMode::ZeroPageY: return " zp,Y";
+        case AddressMode::Absolute: return " abs";
+        case AddressMode::AbsoluteX: return " abs,X";
+        case AddressMode::AbsoluteY: return " abs,Y";
+        case AddressMode::IndirectX: return " (zp,X)";
+        case AddressMode::IndirectY: return " (zp),Y";
+        default: return "";
+        }
+    }
+
+    // cycles of an access at Address indexed from Base, with the opcode table's page crossing penalty
+    void IndexedCycles(std::string& Out, m6502::u32 Indent, const m6502::OpcodeInfo& Op)
+    {
+        if (Op.PageCrossCycles != 0)
+        {
+            Line(Out, Indent, "Left -= ((Base ^ Address) >> 8) ? %u : %u;", Op.Cycles + Op.PageCrossCycles, Op.Cycles);
+        }
+        else
+        {
+            Line(Out, Indent, "Left -= %u;", Op.Cycles);
+        }
+    }
+}
+
+m6502::SuperinstructionGenerator::SuperinstructionGenerator(const OpcodeProfile& Profile, const SuperinstructionOptions& Options)
+    : Options(Options)
+{
+    Select(Profile);
+}
+
+bool m6502::SuperinstructionGenerator::Fusible(Byte Instruction)
+{
+    // the interrupt paths are left to the interpreter
+    return DecodeOpcode(Instruction).Mode != AddressMode::Unknown
+        && Instruction != CPU::INS_JMP_IND && Instruction != CPU::INS_BRK && Instruction != CPU::INS_RTI;
+}
+
+void m6502::SuperinstructionGenerator::Select(const OpcodeProfile& Profile)
+{
+    struct Candidate
+    {
+        u64 Count;
+        Superinstructions::Sequence Ops;
+    };
+    auto Hottest = [](std::vector<Candidate>& Candidates, u32 Max)
+    {
+        std::stable_sort(Candidates.begin(), Candidates.end(),
+            [](const Candidate& A, const Candidate& B) { return A.Count > B.Count; });
+        if (Candidates.size() > Max)
+        {
+            Candidates.resize(Max);
+        }
+    };
+
+    std::vector<Candidate> Pairs;
+    for (u32 i = 0; i < Profile.Pairs.size(); i++)
+    {
+        const Byte First = static_cast<Byte>(i >> 8);
+        const Byte Second = static_cast<Byte>(i);
+        if (Profile.Pairs[i] != 0 && Fusible(First) && Fusible(Second))
+        {
+            Pairs.push_back({ Profile.Pairs[i], { 2, { First, Second } } });
+        }
+    }
+    Hottest(Pairs, Options.MaxPairs);
+
+    std::vector<Candidate> Triples;
+    for (const auto& Triple : Profile.Triples)
+    {
+        const Byte First = static_cast<Byte>(Triple.first >> 16);
+        const Byte Second = static_cast<Byte>(Triple.first >> 8);
+        const Byte Third = static_cast<Byte>(Triple.first);
+        if (Fusible(First) && Fusible(Second) && Fusible(Third))
+        {
+            Triples.push_back({ Triple.second, { 3, { First, Second, Third } } });
+        }
+    }
+    // unordered_map order is not stable, sort by opcodes first so equal counts always pick the same triples
+    std::sort(Triples.begin(), Triples.end(), [](const Candidate& A, const Candidate& B)
+    {
+        return std::lexicographical_compare(A.Ops.Opcodes, A.Ops.Opcodes + 3, B.Ops.Opcodes, B.Ops.Opcodes + 3);
+    });
+    Hottest(Triples, Options.MaxTriples);
+
+    for (const std::vector<Candidate>* Selected : { &Pairs, &Triples })
+    {
+        for (const Candidate& Chosen : *Selected)
+        {
+            Sequences.push_back(Chosen.Ops);
+            Counts.push_back(Chosen.Count);
+
+            Node* At = &Roots[Chosen.Ops.Opcodes[0]];
+            for (u32 i = 1; i < Chosen.Ops.Length; i++)
+            {
+                At = &At->Next[Chosen.Ops.Opcodes[i]];
+            }
+        }
+    }
+}
+
+std::string m6502::SuperinstructionGenerator::GenerateSource(const std::string& SourceName) const
+{
+    std::string Out;
+    Line(Out, 0, "// Generated by M6502Superinstructions from %s, do not edit.", SourceName.c_str());
+    Line(Out, 0, "#include \"m6502_superinstructions.h\"");
+    Line(Out, 0, "");
+    Line(Out, 0, "namespace");
+    Line(Out, 0, "{");
+    Line(Out, 4, "using namespace m6502;");
+
+    for (const auto& Root : Roots)
+    {
+        Line(Out, 0, "");
+        Line(Out, 4, "void Fused_%02X(CPU& cpu, Mem& mem, s32& Cycles)", Root.first);
+        Line(Out, 4, "{");
+        Line(Out, 8, "Word PC = cpu.PC;");
+        Line(Out, 8, "s32 Left = Cycles;");
+        EmitInstruction(Out, Root.first, 8);
+        EmitNode(Out, Root.second, 8);
+        Line(Out, 8, "cpu.PC = PC;");
+        Line(Out, 8, "Cycles = Left;");
+        Line(Out, 4, "}");
+    }
+
+    Line(Out, 0, "");
+    Line(Out, 4, "const Superinstructions::Handler Handlers[256] = {");
+    for (u32 Row = 0; Row < 256; Row += 8)
+    {
+        std::string Entries;
+        for (u32 i = Row; i < Row + 8; i++)
+        {
+            char Entry[32];
+            snprintf(Entry, sizeof(Entry), Roots.count(static_cast<Byte>(i)) ? "Fused_%02X," : "nullptr,", i);
+            Entries += Entries.empty() ? "" : " ";
+            Entries += Entry;
+        }
+        Line(Out, 8, "%s", Entries.c_str());
+    }
+    Line(Out, 4, "};");
+
+    Line(Out, 0, "");
+    Line(Out, 4, "const Superinstructions::Sequence Sequences[] = {");
+    for (u32 i = 0; i < Sequences.size(); i++)
+    {
+        const Superinstructions::Sequence& Fused = Sequences[i];
+        std::string Names;
+        std::string Opcodes;
+        for (u32 Op = 0; Op < Fused.Length; Op++)
+        {
+            char Hex[8];
+            snprintf(Hex, sizeof(Hex), "0x%02X", Fused.Opcodes[Op]);
+            Opcodes += Op == 0 ? "" : ", ";
+            Opcodes += Hex;
+            Names += Op == 0 ? "" : "; ";
+            Names += DecodeOpcode(Fused.Opcodes[Op]).Mnemonic;
+        }
+        Line(Out, 8, "{ %u, { %s } },   // %s, seen %llu times", Fused.Length, Opcodes.c_str(), Names.c_str(), Counts[i]);
+    }
+    Line(Out, 8, "{ 0, { 0 } }      // keeps the array non-empty, not counted");
+    Line(Out, 4, "};");
+    Line(Out, 0, "}");
+    Line(Out, 0, "");
+    Line(Out, 0, "extern const m6502::Superinstructions %s;", Options.Name.c_str());
+    Line(Out, 0, "const m6502::Superinstructions %s = { Handlers, Sequences, %zu };", Options.Name.c_str(), Sequences.size());
+    return Out;
+}
+
+void m6502::SuperinstructionGenerator::EmitNode(std::string& Out, const Node& From, u32 Depth) const
+{
+    if (From.Next.empty())
+    {
+        return;
+    }
+
+    // the interpreter would stop here, so stop too and let it take the interrupt
+    Line(Out, Depth, "if (Left > 0 && cpu.Interrupts.Pending.load(std::memory_order_relaxed) == 0)");
+    Line(Out, Depth, "{");
+    Line(Out, Depth + 4, "switch (mem.Read(PC))");
+    Line(Out, Depth + 4, "{");
+    for (const auto& Child : From.Next)
+    {
+        Line(Out, Depth + 4, "case 0x%02X:", Child.first);
+        EmitInstruction(Out, Child.first, Depth + 8);
+        EmitNode(Out, Child.second, Depth + 8);
+        Line(Out, Depth + 8, "break;");
+    }
+    Line(Out, Depth + 4, "}");
+    Line(Out, Depth, "}");
+}
+
+void m6502::SuperinstructionGenerator::EmitInstruction(std::string& Out, Byte Instruction, u32 Depth)
+{
+    const OpcodeInfo Op = DecodeOpcode(Instruction);
+    const std::string Name = Op.Mnemonic;
+    const bool IsStore = Name == "STA" || Name == "STX" || Name == "STY";
+    const u32 In = Depth + 4;
+
+    Line(Out, Depth, "// %s%s", Op.Mnemonic, ModeSuffix(Op.Mode));
+    Line(Out, Depth, "{");
+
+    // control flow and flags
+    switch (Instruction)
+    {
+    case CPU::INS_JSR:
+        Line(Out, In, "const Word Target = mem.Read(static_cast<Word>(PC + 1)) | (mem.Read(static_cast<Word>(PC + 2)) << 8);");
+        Line(Out, In, "cpu.PushWordToStack(static_cast<Word>(PC + 2), mem);");
+        Line(Out, In, "PC = Target;");
+        Line(Out, In, "Left -= %u;", Op.Cycles);
+        Line(Out, Depth, "}");
+        return;
+    case CPU::INS_RTS:
+        Line(Out, In, "PC = cpu.PopWordFromStack(mem) + 1;");
+        Line(Out, In, "Left -= %u;", Op.Cycles);
+        Line(Out, Depth, "}");
+        return;
+    case CPU::INS_JMP_ABS:
+        Line(Out, In, "PC = mem.Read(static_cast<Word>(PC + 1)) | (mem.Read(static_cast<Word>(PC + 2)) << 8);");
+        Line(Out, In, "Left -= %u;", Op.Cycles);
+        Line(Out, Depth, "}");
+        return;
+    case CPU::INS_SEC:
+    case CPU::INS_CLC:
+    case CPU::INS_SED:
+    case CPU::INS_CLD:
+    case CPU::INS_SEI:
+    case CPU::INS_CLI:
+    {
+        const char Flag = Name == "SEC" || Name == "CLC" ? 'C' : Name == "SED" || Name == "CLD" ? 'D' : 'I';
+        Line(Out, In, "cpu.Flag.%c = %d;", Flag, Name[0] == 'S' ? 1 : 0);
+        Line(Out, In, "PC += 1;");
+        Line(Out, In, "Left -= %u;", Op.Cycles);
+        Line(Out, Depth, "}");
+        return;
+    }
+    }
+
+    // loads, stores and arithmetic: operands are read at run time the way CPU::AddressOf reads them
+    const char* Operand = "mem.Read(static_cast<Word>(PC + 1))";
+    const char* WordOperand = "mem.Read(static_cast<Word>(PC + 1)) | (mem.Read(static_cast<Word>(PC + 2)) << 8)";
+    switch (Op.Mode)
+    {
+    case AddressMode::Immediate:
+        Line(Out, In, "const Byte Value = %s;", Operand);
+        Line(Out, In, "Left -= %u;", Op.Cycles);
+        break;
+    case AddressMode::ZeroPage:
+        Line(Out, In, "const Word Address = %s;", Operand);
+        Line(Out, In, "Left -= %u;", Op.Cycles);
+        break;
+    case AddressMode::ZeroPageX:
+    case AddressMode::ZeroPageY:
+        Line(Out, In, "const Word Address = static_cast<Byte>(%s + cpu.%c);", Operand, Op.Mode == AddressMode::ZeroPageX ? 'X' : 'Y');
+        Line(Out, In, "Left -= %u;", Op.Cycles);
+        break;
+    case AddressMode::Absolute:
+        Line(Out, In, "const Word Address = %s;", WordOperand);
+        Line(Out, In, "Left -= %u;", Op.Cycles);
+        break;
+    case AddressMode::AbsoluteX:
+    case AddressMode::AbsoluteY:
+        Line(Out, In, "const Word Base = %s;", WordOperand);
+        Line(Out, In, "const Word Address = static_cast<Word>(Base + cpu.%c);", Op.Mode == AddressMode::AbsoluteX ? 'X' : 'Y');
+        IndexedCycles(Out, In, Op);
+        break;
+    case AddressMode::IndirectX:
+        Line(Out, In, "const Byte Pointer = static_cast<Byte>(%s + cpu.X);", Operand);
+        Line(Out, In, "const Word Address = mem.Read(Pointer) | (mem.Read(static_cast<Word>(Pointer + 1)) << 8);");
+        Line(Out, In, "Left -= %u;", Op.Cycles);
+        break;
+    case AddressMode::IndirectY:
+        Line(Out, In, "const Byte Pointer = %s;", Operand);
+        Line(Out, In, "const Word Base = mem.Read(Pointer) | (mem.Read(static_cast<Word>(Pointer + 1)) << 8);");
+        Line(Out, In, "const Word Address = static_cast<Word>(Base + cpu.Y);");
+        IndexedCycles(Out, In, Op);
+        break;
+    default:
+        break;
+    }
+    Line(Out, In, "PC += %u;", 1 + OperandSize(Op.Mode));
+
+    const char* Value = Op.Mode == AddressMode::Immediate ? "Value" : "mem.Read(Address)";
+    if (Name == "LDA" || Name == "LDX" || Name == "LDY")
+    {
+        Line(Out, In, "cpu.%c = %s;", Name[2], Value);
+        Line(Out, In, "cpu.LoadRegisterSetStatus(cpu.%c);", Name[2]);
+    }
+    else if (Name == "ADC")
+    {
+        Line(Out, In, "cpu.AddWithCarry<NMOS6502>(%s);", Value);
+    }
+    else if (Name == "SBC")
+    {
+        Line(Out, In, "cpu.SubtractWithCarry<NMOS6502>(%s);", Value);
+    }
+    else if (IsStore)
+    {
+        Line(Out, In, "mem.Write(Address, cpu.%c);", Name[2]);
+    }
+    Line(Out, Depth, "}");
+}
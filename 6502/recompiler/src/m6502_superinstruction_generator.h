@@ -0,0 +1,58 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "m6502_opcodes.h"
+#include "m6502_profile.h"
+#include "m6502_superinstructions.h"
+
+namespace m6502
+{
+	struct SuperinstructionOptions;
+	struct SuperinstructionGenerator;
+}
+
+struct m6502::SuperinstructionOptions
+{
+    std::string Name = "FusedInstructions";    // symbol of the generated Superinstructions
+    u32 MaxPairs = 8;                           // hottest opcode pairs to fuse
+    u32 MaxTriples = 8;                         // hottest opcode triples to fuse
+};
+
+/**
+ * Picks the hottest fusible opcode pairs and triples from a profile and
+ * writes C++ for a Superinstructions table. Sequences sharing a first opcode
+ * are merged into one handler that walks them like a trie, so each
+ * instruction after the first costs a compare instead of a dispatch.
+ */
+struct m6502::SuperinstructionGenerator
+{
+    SuperinstructionGenerator(const OpcodeProfile& Profile, const SuperinstructionOptions& Options);
+
+    // the interpreter runs this opcode without needing anything the generator cannot see
+    static bool Fusible(Byte Instruction);
+
+    const std::vector<Superinstructions::Sequence>& Selected() const
+    {
+        return Sequences;
+    }
+
+    std::string GenerateSource(const std::string& SourceName) const;
+
+private:
+    struct Node
+    {
+        std::map<Byte, Node> Next;
+    };
+
+    void Select(const OpcodeProfile& Profile);
+    void EmitNode(std::string& Out, const Node& From, u32 Depth) const;
+    static void EmitInstruction(std::string& Out, Byte Instruction, u32 Depth);
+
+    SuperinstructionOptions Options;
+    std::vector<Superinstructions::Sequence> Sequences;
+    std::vector<u64> Counts;
+    std::map<Byte, Node> Roots;
+};
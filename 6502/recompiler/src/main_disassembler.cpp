@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <thread>
+
+#include "m6502_disassembler.h"
+
+namespace
+{
+    void PrintUsage(const char* Program)
+    {
+        printf("usage: %s [--hex] [--origin addr] [--entry addr]... [--threads n] [--cache dir] [--listing] <image>...\n", Program);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    m6502::DisassemblerOptions Options;
+    bool Hex = false;
+    bool PrintListing = false;
+    m6502::u32 NumThreads = std::thread::hardware_concurrency();
+    const char* CacheDirectory = nullptr;
+    std::vector<const char*> ImagePaths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const bool HasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--hex") == 0)
+        {
+            Hex = true;
+        }
+        else if (strcmp(argv[i], "--listing") == 0)
+        {
+            PrintListing = true;
+        }
+        else if (strcmp(argv[i], "--origin") == 0 && HasValue)
+        {
+            Options.Origin = static_cast<m6502::Word>(strtoul(argv[++i], nullptr, 0));
+        }
+        else if (strcmp(argv[i], "--entry") == 0 && HasValue)
+        {
+            Options.Entries.push_back(static_cast<m6502::Word>(strtoul(argv[++i], nullptr, 0)));
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && HasValue)
+        {
+            NumThreads = static_cast<m6502::u32>(strtoul(argv[++i], nullptr, 0));
+        }
+        else if (strcmp(argv[i], "--cache") == 0 && HasValue)
+        {
+            CacheDirectory = argv[++i];
+        }
+        else if (argv[i][0] != '-')
+        {
+            ImagePaths.push_back(argv[i]);
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (ImagePaths.empty())
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::vector<m6502::Byte>> Images(ImagePaths.size());
+    for (size_t i = 0; i < ImagePaths.size(); i++)
+    {
+        if (!m6502::ReadImageFile(ImagePaths[i], Hex, Images[i]))
+        {
+            return 1;
+        }
+        if (!m6502::Disassembler::Fits(Images[i], Options.Origin))
+        {
+            printf("%s does not fit in memory at $%04X\n", ImagePaths[i], Options.Origin);
+            return 1;
+        }
+    }
+
+    std::unique_ptr<m6502::AnalysisCache> Cache;
+    if (CacheDirectory != nullptr)
+    {
+        Cache.reset(new m6502::AnalysisCache(CacheDirectory));
+    }
+    const std::vector<m6502::ImageAnalysis> Results =
+        m6502::Disassembler::AnalyzeAll(Images, Options, NumThreads > 0 ? NumThreads : 1, Cache.get());
+
+    for (size_t i = 0; i < Results.size(); i++)
+    {
+        const m6502::ImageAnalysis& Analysis = Results[i];
+        printf("%s: %016llx %zu instructions, %zu blocks, %zu routines, %zu calls%s\n", ImagePaths[i], Analysis.Key,
+            Analysis.Instructions.size(), Analysis.Blocks.size(), Analysis.Routines.size(), Analysis.Calls.size(),
+            Analysis.FromCache ? " (cached)" : "");
+        if (PrintListing)
+        {
+            const std::string Listing = m6502::Disassembler::Listing(Images[i], Options, Analysis);
+            fwrite(Listing.data(), 1, Listing.size(), stdout);
+            for (const std::pair<m6502::Word, m6502::Word>& Call : Analysis.Calls)
+            {
+                printf("; call $%04X -> $%04X\n", Call.first, Call.second);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "m6502_disassembler.h"
+#include "m6502_recompiler.h"
+
+namespace
+{
+    void PrintUsage(const char* Program)
+    {
+        printf("usage: %s [--hex] [--origin addr] [--entry addr]... [--name symbol] [--no-code-check] <image> -o <out.cpp>\n", Program);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    m6502::RecompilerOptions Options;
+    bool Hex = false;
+    const char* ImagePath = nullptr;
+    const char* OutputPath = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const bool HasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--hex") == 0)
+        {
+            Hex = true;
+        }
+        else if (strcmp(argv[i], "--no-code-check") == 0)
+        {
+            Options.CheckCode = false;
+        }
+        else if (strcmp(argv[i], "--origin") == 0 && HasValue)
+        {
+            Options.Origin = static_cast<m6502::Word>(strtoul(argv[++i], nullptr, 0));
+        }
+        else if (strcmp(argv[i], "--entry") == 0 && HasValue)
+        {
+            Options.Entries.push_back(static_cast<m6502::Word>(strtoul(argv[++i], nullptr, 0)));
+        }
+        else if (strcmp(argv[i], "--name") == 0 && HasValue)
+        {
+            Options.Name = argv[++i];
+        }
+        else if (strcmp(argv[i], "-o") == 0 && HasValue)
+        {
+            OutputPath = argv[++i];
+        }
+        else if (argv[i][0] != '-' && ImagePath == nullptr)
+        {
+            ImagePath = argv[i];
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (ImagePath == nullptr || OutputPath == nullptr)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<m6502::Byte> Image;
+    if (!m6502::ReadImageFile(ImagePath, Hex, Image))
+    {
+        return 1;
+    }
+    if (!m6502::Disassembler::Fits(Image, Options.Origin))
+    {
+        printf("%s does not fit in memory at $%04X\n", ImagePath, Options.Origin);
+        return 1;
+    }
+
+    m6502::Recompiler Compiler(Image, Options);
+    Compiler.Trace();
+    const std::string Source = Compiler.GenerateSource(ImagePath);
+
+    FILE* Output = fopen(OutputPath, "w");
+    if (Output == nullptr)
+    {
+        printf("cannot write %s\n", OutputPath);
+        return 1;
+    }
+    fwrite(Source.data(), 1, Source.size(), Output);
+    fclose(Output);
+
+    printf("%s: %zu blocks\n", OutputPath, Compiler.BlockEnds().size());
+    return 0;
+}
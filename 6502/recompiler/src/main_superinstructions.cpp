@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "m6502_superinstruction_generator.h"
+
+namespace
+{
+    void PrintUsage(const char* Program)
+    {
+        printf("usage: %s [--pairs n] [--triples n] [--name symbol] <profile>... -o <out.cpp>\n", Program);
+    }
+}
+
+// profiles from several workloads are merged before the hottest sequences are picked
+int main(int argc, char** argv)
+{
+    m6502::SuperinstructionOptions Options;
+    m6502::OpcodeProfile Profile;
+    std::string Profiles;
+    const char* OutputPath = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const bool HasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--pairs") == 0 && HasValue)
+        {
+            Options.MaxPairs = static_cast<m6502::u32>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--triples") == 0 && HasValue)
+        {
+            Options.MaxTriples = static_cast<m6502::u32>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--name") == 0 && HasValue)
+        {
+            Options.Name = argv[++i];
+        }
+        else if (strcmp(argv[i], "-o") == 0 && HasValue)
+        {
+            OutputPath = argv[++i];
+        }
+        else if (argv[i][0] != '-')
+        {
+            if (!Profile.Load(argv[i]))
+            {
+                return 1;
+            }
+            Profiles += Profiles.empty() ? "" : ", ";
+            Profiles += argv[i];
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (Profiles.empty() || OutputPath == nullptr)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    m6502::SuperinstructionGenerator Generator(Profile, Options);
+    const std::string Source = Generator.GenerateSource(Profiles);
+
+    FILE* Output = fopen(OutputPath, "w");
+    if (Output == nullptr)
+    {
+        printf("cannot write %s\n", OutputPath);
+        return 1;
+    }
+    fwrite(Source.data(), 1, Source.size(), Output);
+    fclose(Output);
+
+    printf("%s: %zu sequences\n", OutputPath, Generator.Selected().size());
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include "m6502_client.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace m6502::protocol;
+
+m6502::EmulationClient::~EmulationClient()
+{
+    Disconnect();
+}
+
+bool m6502::EmulationClient::Connect(const std::string& SocketPath)
+{
+    Disconnect();
+
+    sockaddr_un Address = {};
+    Address.sun_family = AF_UNIX;
+    if (SocketPath.size() >= sizeof(Address.sun_path))
+    {
+        return false;
+    }
+    strcpy(Address.sun_path, SocketPath.c_str());
+
+    Fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (Fd < 0 || connect(Fd, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) < 0)
+    {
+        Disconnect();
+        return false;
+    }
+    return true;
+}
+
+void m6502::EmulationClient::Disconnect()
+{
+    if (Fd >= 0)
+    {
+        close(Fd);
+        Fd = -1;
+    }
+}
+
+bool m6502::EmulationClient::SendAll(const void* Data, size_t Size)
+{
+    const Byte* Bytes = static_cast<const Byte*>(Data);
+    while (Size > 0)
+    {
+        const ssize_t Sent = send(Fd, Bytes, Size, MSG_NOSIGNAL);
+        if (Sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (Sent <= 0)
+        {
+            return false;
+        }
+        Bytes += Sent;
+        Size -= Sent;
+    }
+    return true;
+}
+
+bool m6502::EmulationClient::ReceiveAll(void* Data, size_t Size)
+{
+    Byte* Bytes = static_cast<Byte*>(Data);
+    while (Size > 0)
+    {
+        const ssize_t Received = recv(Fd, Bytes, Size, 0);
+        if (Received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (Received <= 0)
+        {
+            return false;
+        }
+        Bytes += Received;
+        Size -= Received;
+    }
+    return true;
+}
+
+Status m6502::EmulationClient::Call(Command Cmd, u32 SessionId, const std::vector<Byte>& Payload,
+    ResponseHeader& Header, std::vector<Byte>& Response)
+{
+    RequestHeader Request = {};
+    Request.PayloadSize = static_cast<u32>(Payload.size());
+    Request.SessionId = SessionId;
+    Request.Cmd = Cmd;
+    if (Fd < 0 || !SendAll(&Request, sizeof(Request)) || !SendAll(Payload.data(), Payload.size()))
+    {
+        return Status::BadRequest;
+    }
+
+    if (!ReceiveAll(&Header, sizeof(Header)) || Header.PayloadSize > MAX_PAYLOAD)
+    {
+        return Status::BadRequest;
+    }
+    Response.resize(Header.PayloadSize);
+    if (!ReceiveAll(Response.data(), Response.size()))
+    {
+        return Status::BadRequest;
+    }
+    return Header.Result;
+}
+
+Status m6502::EmulationClient::OpenSession(u32& SessionId)
+{
+    ResponseHeader Header;
+    std::vector<Byte> Response;
+    const Status Result = Call(Command::OpenSession, 0, {}, Header, Response);
+    SessionId = Result == Status::Ok ? Header.SessionId : 0;
+    return Result;
+}
+
+Status m6502::EmulationClient::CloseSession(u32 SessionId)
+{
+    ResponseHeader Header;
+    std::vector<Byte> Response;
+    return Call(Command::CloseSession, SessionId, {}, Header, Response);
+}
+
+Status m6502::EmulationClient::LoadImage(u32 SessionId, Word Address, const Byte* Image, u32 Size)
+{
+    LoadImageRequest Request = {};
+    Request.Address = Address;
+    std::vector<Byte> Payload(sizeof(Request) + Size);
+    memcpy(Payload.data(), &Request, sizeof(Request));
+    if (Size > 0)
+    {
+        memcpy(Payload.data() + sizeof(Request), Image, Size);
+    }
+
+    ResponseHeader Header;
+    std::vector<Byte> Response;
+    return Call(Command::LoadImage, SessionId, Payload, Header, Response);
+}
+
+Status m6502::EmulationClient::Run(u32 SessionId, s32 Cycles, RunResponse& Result)
+{
+    RunRequest Request = { Cycles };
+    std::vector<Byte> Payload(sizeof(Request));
+    memcpy(Payload.data(), &Request, sizeof(Request));
+
+    ResponseHeader Header;
+    std::vector<Byte> Response;
+    const Status Outcome = Call(Command::Run, SessionId, Payload, Header, Response);
+    if (Outcome == Status::Ok && Response.size() == sizeof(Result))
+    {
+        memcpy(&Result, Response.data(), sizeof(Result));
+    }
+    return Outcome;
+}
+
+Status m6502::EmulationClient::ReadState(u32 SessionId, Registers& Regs)
+{
+    ResponseHeader Header;
+    std::vector<Byte> Response;
+    const Status Outcome = Call(Command::ReadState, SessionId, {}, Header, Response);
+    if (Outcome == Status::Ok && Response.size() == sizeof(Regs))
+    {
+        memcpy(&Regs, Response.data(), sizeof(Regs));
+    }
+    return Outcome;
+}
+
+Status m6502::EmulationClient::Snapshot(u32 SessionId, Registers& Regs, std::vector<Byte>& Memory)
+{
+    ResponseHeader Header;
+    std::vector<Byte> Response;
+    const Status Outcome = Call(Command::Snapshot, SessionId, {}, Header, Response);
+    if (Outcome == Status::Ok && Response.size() == sizeof(Regs) + Mem::MAX_MEM)
+    {
+        memcpy(&Regs, Response.data(), sizeof(Regs));
+        Memory.assign(Response.begin() + sizeof(Regs), Response.end());
+    }
+    return Outcome;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "m6502_protocol.h"
+
+namespace m6502
+{
+	struct EmulationClient;
+}
+
+/**
+ * Minimal blocking client for the emulation server, for tests and as a
+ * reference for orchestrators that speak the protocol themselves.
+ * Each call returns the Status from the server, or BadRequest if the
+ * connection failed.
+ */
+struct m6502::EmulationClient
+{
+    EmulationClient() = default;
+    ~EmulationClient();
+
+    EmulationClient(const EmulationClient&) = delete;
+    EmulationClient& operator=(const EmulationClient&) = delete;
+
+    bool Connect(const std::string& SocketPath);
+    void Disconnect();
+
+    protocol::Status OpenSession(u32& SessionId);
+    protocol::Status CloseSession(u32 SessionId);
+    protocol::Status LoadImage(u32 SessionId, Word Address, const Byte* Image, u32 Size);
+    protocol::Status Run(u32 SessionId, s32 Cycles, protocol::RunResponse& Result);
+    protocol::Status ReadState(u32 SessionId, protocol::Registers& Regs);
+    protocol::Status Snapshot(u32 SessionId, protocol::Registers& Regs, std::vector<Byte>& Memory);
+
+    // send one request and wait for its response
+    protocol::Status Call(protocol::Command Cmd, u32 SessionId, const std::vector<Byte>& Payload,
+        protocol::ResponseHeader& Header, std::vector<Byte>& Response);
+
+private:
+    bool SendAll(const void* Data, size_t Size);
+    bool ReceiveAll(void* Data, size_t Size);
+
+    int Fd = -1;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "m6502.h"
+
+/**
+ * Wire format spoken over the emulation server's unix domain socket.
+ * Every message is a fixed size header followed by PayloadSize bytes.
+ * Both ends live on the same host so fields are in host byte order.
+ * A connection sends one request and then waits for its response.
+ */
+namespace m6502
+{
+namespace protocol
+{
+    static constexpr u32 MAX_PAYLOAD = 16 + Mem::MAX_MEM;
+
+    enum class Command : Byte
+    {
+        OpenSession = 1,    // -> SessionId in the response header
+        CloseSession = 2,   // session goes back to the pool
+        LoadImage = 3,      // LoadImageRequest + bytes
+        Run = 4,            // RunRequest -> RunResponse
+        ReadState = 5,      // -> Registers
+        Snapshot = 6,       // -> Registers + 64KB of memory
+    };
+
+    enum class Status : Byte
+    {
+        Ok = 0,
+        BadRequest = 1,
+        UnknownSession = 2,
+        NoSessions = 3,
+    };
+
+    struct RequestHeader
+    {
+        u32 PayloadSize;
+        u32 SessionId;
+        Command Cmd;
+        Byte Pad[3];
+    };
+
+    struct ResponseHeader
+    {
+        u32 PayloadSize;
+        u32 SessionId;
+        Status Result;
+        Byte Pad[3];
+    };
+
+    struct Registers
+    {
+        Word PC;
+        Byte SP;
+        Byte A, X, Y;
+        Byte PS;
+        Byte Pad;
+    };
+
+    struct LoadImageRequest
+    {
+        Word Address;
+        Byte Pad[2];
+        // followed by the image bytes, wrapping at 0xFFFF
+    };
+
+    struct RunRequest
+    {
+        s32 Cycles;
+    };
+
+    struct RunResponse
+    {
+        s32 CyclesUsed;
+        Registers Regs;
+    };
+
+    static_assert(sizeof(RequestHeader) == 12, "wire format changed");
+    static_assert(sizeof(ResponseHeader) == 12, "wire format changed");
+    static_assert(sizeof(Registers) == 8, "wire format changed");
+    static_assert(sizeof(RunResponse) == 12, "wire format changed");
+
+    inline Registers RegistersFromCPU(const CPU& cpu)
+    {
+        Registers Regs = {};
+        Regs.PC = cpu.PC;
+        Regs.SP = cpu.SP;
+        Regs.A = cpu.A;
+        Regs.X = cpu.X;
+        Regs.Y = cpu.Y;
+        Regs.PS = cpu.GetPS();
+        return Regs;
+    }
+}
+}
@@ -0,0 +1,650 @@
+#include "m6502_server.h"
+
+#include "m6502_mempool.h"
+#include "m6502_metrics.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace m6502::protocol;
+
+struct m6502::EmulationServer::Connection
+{
+    int Fd = -1;
+    std::vector<Byte> In;
+    std::vector<Byte> Out;
+    size_t OutOffset = 0;
+    u32 Events = 0;
+    bool Busy = false;   // a worker is handling one of its requests
+    bool Closed = false; // peer went away while a worker was busy
+    bool CloseWhenSent = false; // a metrics client, nothing is read from it
+
+    // sessions opened by this client, SessionId is the index + 1
+    std::vector<Session*> Sessions;
+};
+
+struct m6502::EmulationServer::Job
+{
+    Connection* Conn;
+    RequestHeader Header;
+    std::vector<Byte> Payload;
+    std::vector<Byte> Response;
+};
+
+// jobs waiting for the workers of one numa node
+struct m6502::EmulationServer::NodeQueue
+{
+    std::condition_variable Ready;
+    std::deque<std::unique_ptr<Job>> Pending;
+};
+
+namespace
+{
+    void AppendBytes(std::vector<m6502::Byte>& Buffer, const void* Data, m6502::u32 Size)
+    {
+        const m6502::Byte* Bytes = static_cast<const m6502::Byte*>(Data);
+        Buffer.insert(Buffer.end(), Bytes, Bytes + Size);
+    }
+
+    void Respond(std::vector<m6502::Byte>& Response, Status Result, m6502::u32 SessionId,
+        const void* Data = nullptr, m6502::u32 Size = 0,
+        const void* MoreData = nullptr, m6502::u32 MoreSize = 0)
+    {
+        ResponseHeader Header = {};
+        Header.PayloadSize = Size + MoreSize;
+        Header.SessionId = SessionId;
+        Header.Result = Result;
+        Response.reserve(sizeof(Header) + Header.PayloadSize);
+        AppendBytes(Response, &Header, sizeof(Header));
+        AppendBytes(Response, Data, Size);
+        AppendBytes(Response, MoreData, MoreSize);
+    }
+}
+
+m6502::EmulationServer::EmulationServer(const ServerConfig& Config)
+    : Config(Config),
+    // only nodes that get a worker can run sessions
+    NumNodes(std::max(1u, std::min(Numa::NumNodes(), Config.NumWorkers))),
+    Pool(Config.InitialSessions, Config.MaxSessions, NumNodes)
+{
+    for (u32 i = 0; i < NumNodes; i++)
+    {
+        Queues.emplace_back(new NodeQueue());
+    }
+}
+
+m6502::EmulationServer::~EmulationServer()
+{
+    {
+        std::lock_guard<std::mutex> Guard(QueueLock);
+        StopWorkers = true;
+    }
+    for (std::unique_ptr<NodeQueue>& Queue : Queues)
+    {
+        Queue->Ready.notify_all();
+    }
+    for (std::thread& Worker : Workers)
+    {
+        Worker.join();
+    }
+
+    while (!Connections.empty())
+    {
+        Connection* Conn = Connections.begin()->second.get();
+        Conn->Busy = false;
+        CloseConnection(Conn);
+    }
+
+    if (ListenFd >= 0)
+    {
+        close(ListenFd);
+        unlink(Config.SocketPath.c_str());
+    }
+    if (MetricsFd >= 0)
+    {
+        close(MetricsFd);
+        unlink(Config.MetricsSocketPath.c_str());
+    }
+    if (EpollFd >= 0)
+    {
+        close(EpollFd);
+    }
+    if (WakeFd >= 0)
+    {
+        close(WakeFd);
+    }
+}
+
+namespace
+{
+    // non blocking unix socket listening on Path, -1 (with a message) on failure
+    int Listen(const std::string& Path)
+    {
+        sockaddr_un Address = {};
+        Address.sun_family = AF_UNIX;
+        if (Path.empty() || Path.size() >= sizeof(Address.sun_path))
+        {
+            printf("Socket path is empty or too long: %s\n", Path.c_str());
+            return -1;
+        }
+        strcpy(Address.sun_path, Path.c_str());
+
+        const int Fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        unlink(Path.c_str());
+        if (Fd < 0
+            || bind(Fd, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) < 0
+            || listen(Fd, SOMAXCONN) < 0)
+        {
+            printf("Could not listen on %s: %s\n", Path.c_str(), strerror(errno));
+            if (Fd >= 0)
+            {
+                close(Fd);
+            }
+            return -1;
+        }
+        return Fd;
+    }
+}
+
+bool m6502::EmulationServer::Start()
+{
+    ListenFd = Listen(Config.SocketPath);
+    if (ListenFd < 0)
+    {
+        return false;
+    }
+    if (!Config.MetricsSocketPath.empty())
+    {
+        MetricsFd = Listen(Config.MetricsSocketPath);
+        if (MetricsFd < 0)
+        {
+            return false;
+        }
+    }
+
+    EpollFd = epoll_create1(EPOLL_CLOEXEC);
+    WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (EpollFd < 0 || WakeFd < 0)
+    {
+        printf("Could not create the event loop: %s\n", strerror(errno));
+        return false;
+    }
+
+    for (int Fd : { ListenFd, WakeFd, MetricsFd })
+    {
+        if (Fd < 0)
+        {
+            continue;
+        }
+        epoll_event Event = {};
+        Event.events = EPOLLIN;
+        Event.data.fd = Fd;
+        epoll_ctl(EpollFd, EPOLL_CTL_ADD, Fd, &Event);
+    }
+
+    for (u32 i = 0; i < Config.NumWorkers || i == 0; i++)
+    {
+        Workers.emplace_back(&EmulationServer::WorkerLoop, this, i % NumNodes, i);
+    }
+    return true;
+}
+
+void m6502::EmulationServer::Stop()
+{
+    StopRequested.store(true);
+    // without Start there is no event loop to wake
+    if (WakeFd >= 0)
+    {
+        const uint64_t One = 1;
+        ssize_t Ignored = write(WakeFd, &One, sizeof(One));
+        (void)Ignored;
+    }
+}
+
+void m6502::EmulationServer::Run()
+{
+    epoll_event Events[64];
+    while (!StopRequested.load())
+    {
+        const int NumEvents = epoll_wait(EpollFd, Events, 64, -1);
+        if (NumEvents < 0 && errno != EINTR)
+        {
+            printf("epoll_wait failed: %s\n", strerror(errno));
+            return;
+        }
+
+        for (int i = 0; i < NumEvents; i++)
+        {
+            const int Fd = Events[i].data.fd;
+            if (Fd == ListenFd)
+            {
+                Accept();
+                continue;
+            }
+            if (Fd == WakeFd)
+            {
+                CollectFinishedJobs();
+                continue;
+            }
+            if (Fd == MetricsFd)
+            {
+                ServeMetrics();
+                continue;
+            }
+
+            auto Found = Connections.find(Fd);
+            if (Found == Connections.end())
+            {
+                continue;
+            }
+            Connection* Conn = Found->second.get();
+            if (Events[i].events & (EPOLLHUP | EPOLLERR))
+            {
+                // reported even while reads are paused, nothing can be answered any more
+                CloseConnection(Conn);
+                continue;
+            }
+            if (Events[i].events & EPOLLOUT)
+            {
+                WriteTo(Conn);
+            }
+            if (Connections.count(Fd) && (Events[i].events & EPOLLIN))
+            {
+                ReadFrom(Conn);
+            }
+        }
+    }
+}
+
+void m6502::EmulationServer::Accept()
+{
+    for (;;)
+    {
+        const int Fd = accept4(ListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (Fd < 0)
+        {
+            return;
+        }
+
+        std::unique_ptr<Connection> Conn(new Connection());
+        Conn->Fd = Fd;
+        Conn->Events = EPOLLIN;
+        epoll_event Event = {};
+        Event.events = Conn->Events;
+        Event.data.fd = Fd;
+        epoll_ctl(EpollFd, EPOLL_CTL_ADD, Fd, &Event);
+        Connections[Fd] = std::move(Conn);
+    }
+}
+
+void m6502::EmulationServer::ServeMetrics()
+{
+    for (;;)
+    {
+        const int Fd = accept4(MetricsFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (Fd < 0)
+        {
+            return;
+        }
+
+        // the dump grows with the sessions and threads, what the socket does not take now goes out on EPOLLOUT
+        const std::string Text = Metrics::Global().Format();
+        std::unique_ptr<Connection> Conn(new Connection());
+        Conn->Fd = Fd;
+        Conn->CloseWhenSent = true;
+        Conn->Out.assign(Text.begin(), Text.end());
+        Conn->Events = EPOLLOUT;
+        epoll_event Event = {};
+        Event.events = Conn->Events;
+        Event.data.fd = Fd;
+        epoll_ctl(EpollFd, EPOLL_CTL_ADD, Fd, &Event);
+        Connection* Added = Conn.get();
+        Connections[Fd] = std::move(Conn);
+        WriteTo(Added);
+    }
+}
+
+void m6502::EmulationServer::ReadFrom(Connection* Conn)
+{
+    Byte Buffer[16 * 1024];
+    for (;;)
+    {
+        // a whole request of the largest size is enough to dispatch, the rest waits in the socket
+        if (Conn->In.size() >= sizeof(RequestHeader) + MAX_PAYLOAD)
+        {
+            break;
+        }
+        const ssize_t Received = recv(Conn->Fd, Buffer, sizeof(Buffer), 0);
+        if (Received > 0)
+        {
+            Conn->In.insert(Conn->In.end(), Buffer, Buffer + Received);
+            continue;
+        }
+        if (Received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        if (Received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        // peer closed or the socket failed
+        CloseConnection(Conn);
+        return;
+    }
+    DispatchNextRequest(Conn);
+}
+
+void m6502::EmulationServer::WriteTo(Connection* Conn)
+{
+    while (Conn->OutOffset < Conn->Out.size())
+    {
+        const ssize_t Sent = send(Conn->Fd, Conn->Out.data() + Conn->OutOffset,
+            Conn->Out.size() - Conn->OutOffset, MSG_NOSIGNAL);
+        if (Sent > 0)
+        {
+            Conn->OutOffset += Sent;
+            continue;
+        }
+        if (Sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (Sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        CloseConnection(Conn);
+        return;
+    }
+
+    if (Conn->OutOffset == Conn->Out.size())
+    {
+        Conn->Out.clear();
+        Conn->OutOffset = 0;
+        if (Conn->CloseWhenSent)
+        {
+            CloseConnection(Conn);
+            return;
+        }
+    }
+    UpdateEvents(Conn);
+}
+
+void m6502::EmulationServer::UpdateEvents(Connection* Conn)
+{
+    // no reads while a worker has the connection, a client that keeps sending waits in its socket
+    const bool Reads = !Conn->Busy && !Conn->CloseWhenSent;
+    const u32 Wanted = (Reads ? static_cast<u32>(EPOLLIN) : 0u) | (Conn->Out.empty() ? 0u : static_cast<u32>(EPOLLOUT));
+    if (Wanted != Conn->Events)
+    {
+        Conn->Events = Wanted;
+        epoll_event Event = {};
+        Event.events = Wanted;
+        Event.data.fd = Conn->Fd;
+        epoll_ctl(EpollFd, EPOLL_CTL_MOD, Conn->Fd, &Event);
+    }
+}
+
+void m6502::EmulationServer::DispatchNextRequest(Connection* Conn)
+{
+    if (Conn->Busy || Conn->In.size() < sizeof(RequestHeader))
+    {
+        return;
+    }
+
+    RequestHeader Header;
+    memcpy(&Header, Conn->In.data(), sizeof(Header));
+    if (Header.PayloadSize > MAX_PAYLOAD)
+    {
+        printf("Dropping client that sent a %u byte request\n", Header.PayloadSize);
+        CloseConnection(Conn);
+        return;
+    }
+    const size_t RequestSize = sizeof(Header) + Header.PayloadSize;
+    if (Conn->In.size() < RequestSize)
+    {
+        return;
+    }
+
+    std::unique_ptr<Job> NewJob(new Job());
+    NewJob->Conn = Conn;
+    NewJob->Header = Header;
+    NewJob->Payload.assign(Conn->In.begin() + sizeof(Header), Conn->In.begin() + RequestSize);
+    Conn->In.erase(Conn->In.begin(), Conn->In.begin() + RequestSize);
+    Conn->Busy = true;
+    UpdateEvents(Conn);
+
+    // new sessions go round robin over the nodes, everything else runs on its session's node
+    u32 Node = 0;
+    const u32 Index = Header.SessionId - 1;
+    if (Header.Cmd == Command::OpenSession)
+    {
+        Node = NextNode;
+        NextNode = (NextNode + 1) % NumNodes;
+    }
+    else if (Header.SessionId != 0 && Index < Conn->Sessions.size() && Conn->Sessions[Index] != nullptr)
+    {
+        Node = Conn->Sessions[Index]->HomeNode;
+    }
+    QueueJob(std::move(NewJob), Node);
+}
+
+void m6502::EmulationServer::QueueJob(std::unique_ptr<Job> NewJob, u32 Node)
+{
+    NodeQueue& Queue = *Queues[Node < NumNodes ? Node : 0];
+    {
+        std::lock_guard<std::mutex> Guard(QueueLock);
+        Queue.Pending.push_back(std::move(NewJob));
+    }
+    Queue.Ready.notify_one();
+}
+
+void m6502::EmulationServer::CollectFinishedJobs()
+{
+    uint64_t Count;
+    ssize_t Ignored = read(WakeFd, &Count, sizeof(Count));
+    (void)Ignored;
+
+    std::deque<std::unique_ptr<Job>> Done;
+    {
+        std::lock_guard<std::mutex> Guard(QueueLock);
+        Done.swap(Finished);
+    }
+
+    for (std::unique_ptr<Job>& FinishedJob : Done)
+    {
+        Connection* Conn = FinishedJob->Conn;
+        Conn->Busy = false;
+        if (Conn->Closed)
+        {
+            CloseConnection(Conn);
+            continue;
+        }
+
+        Conn->Out.insert(Conn->Out.end(), FinishedJob->Response.begin(), FinishedJob->Response.end());
+        const int Fd = Conn->Fd;
+        WriteTo(Conn);
+        if (Connections.count(Fd))
+        {
+            DispatchNextRequest(Conn);
+        }
+    }
+}
+
+void m6502::EmulationServer::CloseConnection(Connection* Conn)
+{
+    if (Conn->Busy)
+    {
+        // a worker still uses its sessions, finish closing when the job comes back
+        if (!Conn->Closed)
+        {
+            Conn->Closed = true;
+            epoll_ctl(EpollFd, EPOLL_CTL_DEL, Conn->Fd, nullptr);
+        }
+        return;
+    }
+
+    for (Session* session : Conn->Sessions)
+    {
+        if (session != nullptr)
+        {
+            Pool.Release(session);
+        }
+    }
+    if (!Conn->Closed)
+    {
+        epoll_ctl(EpollFd, EPOLL_CTL_DEL, Conn->Fd, nullptr);
+    }
+    const int Fd = Conn->Fd;
+    close(Fd);
+    Connections.erase(Fd);
+}
+
+void m6502::EmulationServer::WorkerLoop(u32 Node, u32 Worker)
+{
+    if (Numa::NumNodes() > 1)
+    {
+        Numa::PinThisThread(Node);
+    }
+    Metrics::Global().NameThread("node" + std::to_string(Node) + "-worker" + std::to_string(Worker));
+
+    NodeQueue& Queue = *Queues[Node];
+    for (;;)
+    {
+        std::unique_ptr<Job> NextJob;
+        {
+            std::unique_lock<std::mutex> Guard(QueueLock);
+            Queue.Ready.wait(Guard, [this, &Queue] { return StopWorkers || !Queue.Pending.empty(); });
+            if (StopWorkers)
+            {
+                return;
+            }
+            NextJob = std::move(Queue.Pending.front());
+            Queue.Pending.pop_front();
+        }
+
+        HandleRequest(*NextJob, Node);
+
+        {
+            std::lock_guard<std::mutex> Guard(QueueLock);
+            Finished.push_back(std::move(NextJob));
+        }
+        const uint64_t One = 1;
+        ssize_t Ignored = write(WakeFd, &One, sizeof(One));
+        (void)Ignored;
+    }
+}
+
+void m6502::EmulationServer::HandleRequest(Job& job, u32 Node)
+{
+    const RequestHeader& Header = job.Header;
+    std::vector<Session*>& Sessions = job.Conn->Sessions;
+    std::vector<Byte>& Response = job.Response;
+
+    if (Header.Cmd == Command::OpenSession)
+    {
+        Session* NewSession = Pool.Acquire(Node);
+        if (NewSession == nullptr)
+        {
+            Respond(Response, Status::NoSessions, 0);
+            return;
+        }
+        u32 Index = 0;
+        while (Index < Sessions.size() && Sessions[Index] != nullptr)
+        {
+            Index++;
+        }
+        if (Index == Sessions.size())
+        {
+            Sessions.push_back(nullptr);
+        }
+        Sessions[Index] = NewSession;
+        Respond(Response, Status::Ok, Index + 1);
+        return;
+    }
+
+    const u32 Index = Header.SessionId - 1;
+    if (Header.SessionId == 0 || Index >= Sessions.size() || Sessions[Index] == nullptr)
+    {
+        Respond(Response, Status::UnknownSession, Header.SessionId);
+        return;
+    }
+    Session& session = *Sessions[Index];
+    const std::vector<Byte>& Payload = job.Payload;
+
+    switch (Header.Cmd)
+    {
+    case Command::CloseSession:
+    {
+        Pool.Release(&session);
+        Sessions[Index] = nullptr;
+        Respond(Response, Status::Ok, Header.SessionId);
+    }
+    break;
+
+    case Command::LoadImage:
+    {
+        LoadImageRequest Request;
+        if (Payload.size() < sizeof(Request) || Payload.size() - sizeof(Request) > Mem::MAX_MEM)
+        {
+            Respond(Response, Status::BadRequest, Header.SessionId);
+            break;
+        }
+        memcpy(&Request, Payload.data(), sizeof(Request));
+        Word Address = Request.Address;
+        for (size_t i = sizeof(Request); i < Payload.size(); i++)
+        {
+            session.mem[Address++] = Payload[i];
+        }
+        Respond(Response, Status::Ok, Header.SessionId);
+    }
+    break;
+
+    case Command::Run:
+    {
+        RunRequest Request;
+        if (Payload.size() != sizeof(Request))
+        {
+            Respond(Response, Status::BadRequest, Header.SessionId);
+            break;
+        }
+        memcpy(&Request, Payload.data(), sizeof(Request));
+        RunResponse Result = {};
+        MachineMetricsScope Scope(session.Metrics);
+        Result.CyclesUsed = Request.Cycles > 0 ? session.cpu.Execute(Request.Cycles, session.mem) : 0;
+        Result.Regs = RegistersFromCPU(session.cpu);
+        Respond(Response, Status::Ok, Header.SessionId, &Result, sizeof(Result));
+    }
+    break;
+
+    case Command::ReadState:
+    {
+        const Registers Regs = RegistersFromCPU(session.cpu);
+        Respond(Response, Status::Ok, Header.SessionId, &Regs, sizeof(Regs));
+    }
+    break;
+
+    case Command::Snapshot:
+    {
+        const Registers Regs = RegistersFromCPU(session.cpu);
+        Respond(Response, Status::Ok, Header.SessionId, &Regs, sizeof(Regs),
+            session.mem.Data, Mem::MAX_MEM);
+    }
+    break;
+
+    default:
+    {
+        Respond(Response, Status::BadRequest, Header.SessionId);
+    }
+    break;
+    }
+}
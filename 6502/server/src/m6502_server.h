@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "m6502_protocol.h"
+#include "m6502_sessionpool.h"
+
+namespace m6502
+{
+	struct ServerConfig;
+	struct EmulationServer;
+}
+
+struct m6502::ServerConfig
+{
+    std::string SocketPath;
+    u32 NumWorkers = 4;
+    u32 InitialSessions = 16;
+    u32 MaxSessions = 1024;
+    std::string MetricsSocketPath;  // when set, every connection to it gets one Metrics dump
+};
+
+/**
+ * Long running emulation daemon on a unix domain socket.
+ * One thread runs an epoll loop that owns every socket: it accepts clients,
+ * reads whole requests and writes responses. Complete requests go to a pool
+ * of worker threads that do the emulation and hand the response back through
+ * an eventfd. See m6502_protocol.h for the messages.
+ * Workers are spread over the NUMA nodes and pinned to them. Every session
+ * has a home node where its memory lives, and its requests are only queued
+ * for workers on that node.
+ */
+struct m6502::EmulationServer
+{
+    explicit EmulationServer(const ServerConfig& Config);
+    ~EmulationServer();
+
+    // bind the socket and start the workers, false (with a message) on failure
+    bool Start();
+
+    // serve clients until Stop is called
+    void Run();
+
+    // safe to call from any thread or a signal handler
+    void Stop();
+
+private:
+    struct Connection;
+    struct Job;
+    struct NodeQueue;
+
+    void Accept();
+    void ServeMetrics();
+    void ReadFrom(Connection* Conn);
+    void WriteTo(Connection* Conn);
+    void DispatchNextRequest(Connection* Conn);
+    void CollectFinishedJobs();
+    void CloseConnection(Connection* Conn);
+    void UpdateEvents(Connection* Conn);
+
+    // queue a job for the workers of one node
+    void QueueJob(std::unique_ptr<Job> NewJob, u32 Node);
+
+    void WorkerLoop(u32 Node, u32 Worker);
+    void HandleRequest(Job& job, u32 Node);
+
+    ServerConfig Config;
+    u32 NumNodes;
+    SessionPool Pool;
+
+    int ListenFd = -1;
+    int MetricsFd = -1;
+    int EpollFd = -1;
+    int WakeFd = -1;
+    std::atomic<bool> StopRequested{false};
+
+    std::unordered_map<int, std::unique_ptr<Connection>> Connections;
+
+    u32 NextNode = 0;   // where the next session is opened, round robin
+
+    std::vector<std::thread> Workers;
+    std::mutex QueueLock;
+    std::vector<std::unique_ptr<NodeQueue>> Queues;
+    std::deque<std::unique_ptr<Job>> Finished;
+    bool StopWorkers = false;
+};
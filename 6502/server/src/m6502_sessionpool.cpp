@@ -0,0 +1,108 @@
+#include "m6502_sessionpool.h"
+
+#include "m6502_mempool.h"
+#include "m6502_metrics.h"
+
+#include <string>
+
+m6502::SessionPool::SessionPool(u32 InitialSessions, u32 MaxSessions, u32 NumNodes)
+    : Free(NumNodes > 0 ? NumNodes : 1), MaxSessions(MaxSessions)
+{
+    Sessions.reserve(InitialSessions);
+    for (u32 i = 0; i < InitialSessions && i < MaxSessions; i++)
+    {
+        const u32 Node = i % Free.size();
+        std::unique_ptr<Session> session = Create(Node);
+        if (session == nullptr)
+        {
+            break;
+        }
+        Free[Node].push_back(Adopt(std::move(session)));
+    }
+}
+
+m6502::SessionPool::~SessionPool()
+{
+    for (std::unique_ptr<Session>& session : Sessions)
+    {
+        Metrics::Global().RemoveMachine(session->Metrics);
+        MemPool::Global().Free(&session->mem);
+    }
+}
+
+std::unique_ptr<m6502::Session> m6502::SessionPool::Create(u32 Node)
+{
+    Mem* Memory = MemPool::Global().Allocate(Node);
+    if (Memory == nullptr)
+    {
+        return nullptr;
+    }
+    std::unique_ptr<Session> session(new Session(*Memory, Node));
+    session->cpu.Reset(session->mem);
+    return session;
+}
+
+m6502::Session* m6502::SessionPool::Adopt(std::unique_ptr<Session> session)
+{
+    Sessions.push_back(std::move(session));
+    Session* Adopted = Sessions.back().get();
+    Adopted->Metrics = Metrics::Global().AddMachine("session-" + std::to_string(Sessions.size() - 1));
+    return Adopted;
+}
+
+m6502::Session* m6502::SessionPool::Acquire(u32 Node)
+{
+    if (Node >= Free.size())
+    {
+        Node = 0;
+    }
+
+    std::unique_lock<std::mutex> Guard(Lock);
+    if (!Free[Node].empty())
+    {
+        Session* session = Free[Node].back();
+        Free[Node].pop_back();
+        return session;
+    }
+    if (Sessions.size() + Creating < MaxSessions)
+    {
+        // the allocation and 64KB reset happen without the lock, other threads keep taking and giving back sessions
+        Creating++;
+        Guard.unlock();
+        std::unique_ptr<Session> session = Create(Node);
+        Guard.lock();
+        Creating--;
+        return session != nullptr ? Adopt(std::move(session)) : nullptr;
+    }
+
+    // at the limit, a free session on another node is better than none, it still runs on its own node
+    for (std::vector<Session*>& NodeFree : Free)
+    {
+        if (!NodeFree.empty())
+        {
+            Session* session = NodeFree.back();
+            NodeFree.pop_back();
+            return session;
+        }
+    }
+    return nullptr;
+}
+
+void m6502::SessionPool::Release(Session* session)
+{
+    session->cpu.Reset(session->mem);
+
+    std::lock_guard<std::mutex> Guard(Lock);
+    Free[session->HomeNode].push_back(session);
+}
+
+m6502::u32 m6502::SessionPool::NumFree() const
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    size_t Count = 0;
+    for (const std::vector<Session*>& NodeFree : Free)
+    {
+        Count += NodeFree.size();
+    }
+    return static_cast<u32>(Count);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct Session;
+	struct SessionPool;
+}
+
+// one emulated machine owned by a client while it is checked out of the pool
+struct m6502::Session
+{
+    Session(Mem& Memory, u32 Node)
+        : mem(Memory), HomeNode(Node)
+    {
+    }
+
+    Mem& mem;
+    CPU cpu;
+
+    // numa node its memory lives on, only workers on that node run it
+    const u32 HomeNode;
+
+    // its row in the Metrics dump, kept for the life of the pool
+    MetricsShard* Metrics = nullptr;
+};
+
+/**
+ * Sessions that are already reset and ready to hand out, so opening a
+ * session costs a list pop instead of an allocation and a 64KB clear.
+ * Session memory comes from MemPool on the session's home node and each
+ * node keeps its own free list. Sessions are reset when they are given back.
+ */
+struct m6502::SessionPool
+{
+    SessionPool(u32 InitialSessions, u32 MaxSessions, u32 NumNodes = 1);
+    ~SessionPool();
+
+    // a session on the given node, nullptr when MaxSessions are already checked out
+    Session* Acquire(u32 Node = 0);
+
+    // reset the session and make it available again
+    void Release(Session* session);
+
+    u32 NumFree() const;
+
+private:
+    // a reset session with memory on Node, not yet in the pool, nullptr when there is no memory
+    static std::unique_ptr<Session> Create(u32 Node);
+
+    // add a session made by Create to the pool, Lock held
+    Session* Adopt(std::unique_ptr<Session> session);
+
+    mutable std::mutex Lock;
+    std::vector<std::unique_ptr<Session>> Sessions;
+    size_t Creating = 0;                        // sessions being made outside the lock, they count against MaxSessions
+    std::vector<std::vector<Session*>> Free;    // per node
+    const u32 MaxSessions;
+};
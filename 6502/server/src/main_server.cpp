@@ -0,0 +1,59 @@
+#include <signal.h>
+#include <stdlib.h>
+
+#include "m6502_server.h"
+
+namespace
+{
+    m6502::EmulationServer* RunningServer = nullptr;
+
+    void HandleSignal(int)
+    {
+        if (RunningServer != nullptr)
+        {
+            RunningServer->Stop();
+        }
+    }
+}
+
+// usage: M6502Server <socket path> [workers] [initial sessions] [max sessions] [metrics socket path]
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: %s <socket path> [workers] [initial sessions] [max sessions] [metrics socket path]\n", argv[0]);
+        return 1;
+    }
+
+    m6502::ServerConfig Config;
+    Config.SocketPath = argv[1];
+    if (argc > 2)
+    {
+        Config.NumWorkers = static_cast<m6502::u32>(atoi(argv[2]));
+    }
+    if (argc > 3)
+    {
+        Config.InitialSessions = static_cast<m6502::u32>(atoi(argv[3]));
+    }
+    if (argc > 4)
+    {
+        Config.MaxSessions = static_cast<m6502::u32>(atoi(argv[4]));
+    }
+    if (argc > 5)
+    {
+        Config.MetricsSocketPath = argv[5];
+    }
+
+    m6502::EmulationServer Server(Config);
+    if (!Server.Start())
+    {
+        return 1;
+    }
+
+    RunningServer = &Server;
+    signal(SIGINT, HandleSignal);
+    signal(SIGTERM, HandleSignal);
+    Server.Run();
+    RunningServer = nullptr;
+    return 0;
+}
@@ -0,0 +1,18 @@
+# opcode profile used to generate the fused handlers under test
+pair A9 85 5000
+pair A6 A4 4000
+pair 20 60 3000
+pair 7D 9D 2500
+pair E1 81 2000
+pair 18 69 1500
+pair 4C B6 1200
+pair B1 91 1100
+pair 60 AD 900
+pair 00 A9 8000
+pair 38 F9 800
+pair 8E 8C 700
+pair 75 95 600
+triple A9 85 20 2400
+triple 20 60 A6 1800
+triple 38 F9 99 700
+triple 6C 30 80 9000
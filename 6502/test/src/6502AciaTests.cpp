@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+#include "m6502.h"
+#include "m6502_acia.h"
+#include "m6502_tickeddevices.h"
+
+class M6502AciaTests : public testing::Test
+{
+public:
+	m6502::DeviceMem mem;
+	m6502::CPU cpu;
+	m6502::TickedDeviceMem tickedMem;
+	m6502::CPU tickedCpu;
+
+	virtual void SetUp()
+	{
+		cpu.Reset( mem );
+		cpu.PC = 0x8000;
+		tickedCpu.Reset( tickedMem );
+		tickedCpu.PC = 0x8000;
+	}
+
+	virtual void TearDown()
+	{
+	}
+
+	// the same bytes into both memories
+	void Load( m6502::Word Address, std::initializer_list<m6502::Byte> Bytes )
+	{
+		for ( m6502::Byte Value : Bytes )
+		{
+			mem[Address] = Value;
+			tickedMem[Address] = Value;
+			Address++;
+		}
+	}
+};
+
+static constexpr m6502::Word ACIA = 0x9100;
+
+using Transmitted = std::vector<std::pair<m6502::Byte, m6502::u64>>;
+
+TEST_F( M6502AciaTests, CharacterCyclesFollowTheBaudRateAndFrame )
+{
+	// given:
+	using namespace m6502;
+
+	//when:
+	const u64 At9600 = Acia6551::CharacterCycles( 0x1E, 0x00, 1000000 );
+	const u64 At300With7E2 = Acia6551::CharacterCycles( 0xA6, 0x60, 1000000 );
+
+	//then:
+	EXPECT_EQ( At9600, 1042u );				//10 bits
+	EXPECT_EQ( At300With7E2, 36667u );		//11 bits
+}
+
+TEST_F( M6502AciaTests, AnInterruptDrivenTransmitterSendsTheSameBytesAtTheSameCyclesAsTheTickedOne )
+{
+	// given:
+	using namespace m6502;
+	Load( 0xFFFE, { 0x00, 0x81 } );
+	Load( 0x8000, {
+		CPU::INS_LDA_IM, 0x1E, CPU::INS_STA_ABS, 0x03, 0x91,	//9600 8N1
+		CPU::INS_LDA_IM, 0x07, CPU::INS_STA_ABS, 0x02, 0x91,	//transmit interrupts only
+		CPU::INS_LDA_IM, 'A', CPU::INS_STA_ABS, 0x00, 0x91,
+		CPU::INS_CLI,
+		CPU::INS_JMP_ABS, 0x10, 0x80 } );
+	Load( 0x8100, {
+		CPU::INS_LDA_ABS, 0x01, 0x91,							//status, acknowledges
+		CPU::INS_LDX_ABS, 0x00, 0x02,
+		CPU::INS_LDA_ABSX, 0x00, 0x04, CPU::INS_STA_ABS, 0x00, 0x91,
+		CPU::INS_LDA_ABS, 0x00, 0x02, CPU::INS_CLC, CPU::INS_ADC_IM, 0x01, CPU::INS_STA_ABS, 0x00, 0x02,
+		CPU::INS_RTI } );
+	for ( u32 i = 0; i < 256; i++ )
+	{
+		Load( static_cast<Word>( 0x0400 + i ), { static_cast<Byte>( 'a' + i % 26 ) } );
+	}
+	DeviceScheduler Scheduler( mem );
+	Acia6551 Acia( Scheduler, mem, cpu, ACIA );
+	TickedAcia6551 TickedAcia;
+	tickedMem.Map( TickedAcia, ACIA, Acia6551::NUM_REGISTERS, 2 );
+	Transmitted Sent, TickedSent;
+	Acia.OnTransmit = [&Sent]( Byte Value, u64 Cycle ) { Sent.push_back( { Value, Cycle } ); };
+	TickedAcia.OnTransmit = [&TickedSent]( Byte Value, u64 Cycle ) { TickedSent.push_back( { Value, Cycle } ); };
+
+	//when:
+	Scheduler.Run( cpu, 30000 );
+	tickedMem.Run( tickedCpu, 30000 );
+
+	//then:
+	ASSERT_GE( Sent.size(), 27u );
+	EXPECT_EQ( Sent, TickedSent );
+	EXPECT_EQ( Sent[0].first, 'A' );
+	EXPECT_EQ( Sent[1].first, 'a' );
+	EXPECT_EQ( Sent[2].first, 'b' );
+	EXPECT_EQ( Sent[1].second - Sent[0].second, 1042u );
+	EXPECT_EQ( mem[0x0200], tickedMem[0x0200] );
+}
+
+TEST_F( M6502AciaTests, AnInterruptDrivenEchoReceivesAndSendsBackEveryByte )
+{
+	// given:
+	using namespace m6502;
+	Load( 0xFFFE, { 0x00, 0x81 } );
+	Load( 0x8000, {
+		CPU::INS_LDA_IM, 0x1F, CPU::INS_STA_ABS, 0x03, 0x91,	//19200 8N1
+		CPU::INS_LDA_IM, 0x09, CPU::INS_STA_ABS, 0x02, 0x91,	//receive interrupts only
+		CPU::INS_CLI,
+		CPU::INS_JMP_ABS, 0x0B, 0x80 } );
+	Load( 0x8100, {
+		CPU::INS_LDA_ABS, 0x01, 0x91,
+		CPU::INS_LDX_ABS, 0x00, 0x02,
+		CPU::INS_LDA_ABS, 0x00, 0x91, CPU::INS_STA_ABS, 0x00, 0x91, CPU::INS_STA_ABSX, 0x00, 0x03,
+		CPU::INS_LDA_ABS, 0x00, 0x02, CPU::INS_CLC, CPU::INS_ADC_IM, 0x01, CPU::INS_STA_ABS, 0x00, 0x02,
+		CPU::INS_RTI } );
+	DeviceScheduler Scheduler( mem );
+	Acia6551 Acia( Scheduler, mem, cpu, ACIA );
+	TickedAcia6551 TickedAcia;
+	tickedMem.Map( TickedAcia, ACIA, Acia6551::NUM_REGISTERS, 2 );
+	Transmitted Sent, TickedSent;
+	Acia.OnTransmit = [&Sent]( Byte Value, u64 Cycle ) { Sent.push_back( { Value, Cycle } ); };
+	TickedAcia.OnTransmit = [&TickedSent]( Byte Value, u64 Cycle ) { TickedSent.push_back( { Value, Cycle } ); };
+	Scheduler.Run( cpu, 20 );
+	tickedMem.Run( tickedCpu, 20 );
+	const Byte Text[] = "hello";
+	Acia.Receive( Text, 5 );
+	TickedAcia.Receive( Text, 5 );
+
+	//when:
+	Scheduler.Run( cpu, 5000 );
+	tickedMem.Run( tickedCpu, 5000 );
+
+	//then:
+	ASSERT_EQ( Sent.size(), 5u );
+	EXPECT_EQ( Sent, TickedSent );
+	EXPECT_EQ( mem[0x0200], 5 );
+	for ( u32 i = 0; i < 5; i++ )
+	{
+		EXPECT_EQ( mem[0x0300 + i], Text[i] );
+		EXPECT_EQ( tickedMem[0x0300 + i], Text[i] );
+		EXPECT_EQ( Sent[i].first, Text[i] );
+	}
+}
+
+TEST_F( M6502AciaTests, APolledReceiverThatIsNotReadOverrunsWithoutWakingTheScheduler )
+{
+	// given:
+	using namespace m6502;
+	Load( 0x8000, { CPU::INS_JMP_ABS, 0x00, 0x80 } );
+	DeviceScheduler Scheduler( mem );
+	Acia6551 Acia( Scheduler, mem, cpu, ACIA );
+	Acia.Write( Acia6551::CONTROL, 0x1F );
+	Acia.Write( Acia6551::COMMAND, 0x0B );	//no interrupts
+	const Byte Text[] = "xyz";
+	Acia.Receive( Text, 3 );
+
+	//when:
+	Scheduler.Run( cpu, 3000 );
+	const size_t Waiting = Scheduler.NumWaiting();
+	const Byte Status = Acia.Read( Acia6551::STATUS );
+	const Byte Data = Acia.Read( Acia6551::DATA );
+	const Byte StatusAfterData = Acia.Read( Acia6551::STATUS );
+
+	//then:
+	EXPECT_EQ( Waiting, 1u );
+	EXPECT_EQ( Status, Acia6551::RDRF | Acia6551::OVERRUN | Acia6551::TDRE );
+	EXPECT_EQ( Data, 'x' );
+	EXPECT_EQ( StatusAfterData, Acia6551::TDRE );
+	EXPECT_FALSE( cpu.Interrupts.Any() );
+}
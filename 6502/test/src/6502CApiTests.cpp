@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "m6502_capi.h"
+#include "m6502.h"
+
+class M6502CApiTests : public testing::Test
+{
+public:
+	m6502_machine* machine = nullptr;
+
+	virtual void SetUp()
+	{
+		machine = m6502_create();
+	}
+
+	virtual void TearDown()
+	{
+		m6502_destroy( machine );
+	}
+};
+
+TEST_F( M6502CApiTests, ANewMachineIsReset )
+{
+	//given:
+	m6502_regs Regs;
+
+	//when:
+	m6502_get_regs( machine, &Regs );
+
+	//then:
+	EXPECT_EQ( Regs.pc, 0xFFFC );
+	EXPECT_EQ( Regs.sp, 0xFF );
+	EXPECT_EQ( Regs.a, 0 );
+	EXPECT_EQ( m6502_memory_size(), m6502::Mem::MAX_MEM );
+}
+
+TEST_F( M6502CApiTests, TheMachineRunsProgramsWrittenThroughTheMemoryPointer )
+{
+	// given:
+	using namespace m6502;
+	uint8_t* Memory = m6502_memory( machine );
+	Memory[0xFFFC] = CPU::INS_LDA_IM;
+	Memory[0xFFFD] = 0x84;
+	Memory[0xFFFE] = CPU::INS_STA_ZP;
+	Memory[0xFFFF] = 0x42;
+
+	//when:
+	int32_t CyclesUsed = m6502_execute( machine, 2 + 3 );
+
+	//then:
+	m6502_regs Regs;
+	m6502_get_regs( machine, &Regs );
+	EXPECT_EQ( CyclesUsed, 5 );
+	EXPECT_EQ( Regs.a, 0x84 );
+	EXPECT_EQ( Memory[0x0042], 0x84 );
+}
+
+TEST_F( M6502CApiTests, RegistersCanBeSet )
+{
+	// given:
+	using namespace m6502;
+	m6502_regs Regs = { 0x8000, 0xF0, 1, 2, 3, 0 };
+	m6502_memory( machine )[0x8000] = CPU::INS_LDX_IM;
+	m6502_memory( machine )[0x8001] = 0x00;
+
+	//when:
+	m6502_set_regs( machine, &Regs );
+	m6502_execute( machine, 2 );
+	m6502_get_regs( machine, &Regs );
+
+	//then:
+	EXPECT_EQ( Regs.pc, 0x8002 );
+	EXPECT_EQ( Regs.sp, 0xF0 );
+	EXPECT_EQ( Regs.a, 1 );
+	EXPECT_EQ( Regs.x, 0 );
+	EXPECT_EQ( Regs.y, 3 );
+	EXPECT_EQ( Regs.ps, 0b00000010 );	//zero flag
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <array>
+#include "m6502.h"
+
+namespace
+{
+	using namespace m6502;
+
+	// CLC, A = $10 + $11 + $12 + $13, STA $20, run at compile time
+	constexpr Byte Checksum( Byte B0, Byte B1, Byte B2, Byte B3 )
+	{
+		Mem mem;
+		CPU cpu;
+		cpu.Reset( mem );
+		mem[0x10] = B0;
+		mem[0x11] = B1;
+		mem[0x12] = B2;
+		mem[0x13] = B3;
+		const Byte Program[] = {
+			CPU::INS_CLC,
+			CPU::INS_LDA_ZP, 0x10,
+			CPU::INS_ADC_ZP, 0x11,
+			CPU::INS_ADC_ZP, 0x12,
+			CPU::INS_ADC_ZP, 0x13,
+			CPU::INS_STA_ZP, 0x20 };
+		for ( u32 i = 0; i < sizeof( Program ); i++ )
+		{
+			mem[0x8000 + i] = Program[i];
+		}
+		mem[0xFFFC] = CPU::INS_JMP_ABS;
+		mem[0xFFFD] = 0x00;
+		mem[0xFFFE] = 0x80;
+		cpu.Execute( 3 + 2 + 3 + 3 + 3 + 3 + 3, mem );
+		return mem[0x20];
+	}
+
+	// cycles used and A after A = Left + Right through a subroutine
+	template<typename TVariant>
+	constexpr std::array<s32, 2> AddThroughSubroutine( Byte Left, Byte Right, bool Decimal )
+	{
+		Mem mem;
+		CPU cpu;
+		cpu.Reset( mem );
+		mem[0xFFFC] = Decimal ? CPU::INS_SED : CPU::INS_CLD;
+		mem[0xFFFD] = CPU::INS_CLC;
+		mem[0xFFFE] = CPU::INS_JSR;
+		mem[0xFFFF] = 0x00;
+		mem[0x0000] = 0x40;
+		mem[0x4000] = CPU::INS_LDA_IM;
+		mem[0x4001] = Left;
+		mem[0x4002] = CPU::INS_ADC_IM;
+		mem[0x4003] = Right;
+		mem[0x4004] = CPU::INS_RTS;
+		const s32 CyclesUsed = cpu.Execute<TVariant>( 2 + 2 + 6 + 2 + 2 + 6, mem );
+		return { CyclesUsed, cpu.A };
+	}
+
+	// a table computed at build time: Squares[i] = i * i, by repeated addition
+	constexpr std::array<Byte, 16> MakeSquares()
+	{
+		std::array<Byte, 16> Table{};
+		for ( Byte i = 0; i < Table.size(); i++ )
+		{
+			Mem mem;
+			CPU cpu;
+			cpu.Reset( mem );
+			Word Address = 0x8000;
+			mem[Address++] = CPU::INS_LDA_IM;
+			mem[Address++] = 0;
+			for ( Byte Step = 0; Step < i; Step++ )
+			{
+				mem[Address++] = CPU::INS_CLC;
+				mem[Address++] = CPU::INS_ADC_IM;
+				mem[Address++] = i;
+			}
+			mem[0xFFFC] = CPU::INS_JMP_ABS;
+			mem[0xFFFD] = 0x00;
+			mem[0xFFFE] = 0x80;
+			cpu.Execute( 3 + 2 + 4 * i, mem );
+			Table[i] = cpu.A;
+		}
+		return Table;
+	}
+
+	constexpr std::array<Byte, 16> Squares = MakeSquares();
+
+	static_assert( Checksum( 1, 2, 3, 4 ) == 10 );
+	static_assert( Checksum( 0x80, 0x80, 0xFF, 0x02 ) == 0x03 );
+	static_assert( AddThroughSubroutine<NMOS6502>( 0x19, 0x28, false ) == std::array<s32, 2>{ 20, 0x41 } );
+	static_assert( AddThroughSubroutine<NMOS6502>( 0x19, 0x28, true ) == std::array<s32, 2>{ 20, 0x47 } );
+	static_assert( AddThroughSubroutine<Ricoh2A03>( 0x19, 0x28, true ) == std::array<s32, 2>{ 20, 0x41 } );
+	static_assert( Squares[0] == 0 && Squares[7] == 49 && Squares[15] == 225 );
+}
+
+class M6502ConstexprTests : public testing::Test
+{
+public:
+	m6502::Mem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		cpu.Reset( mem );
+	}
+
+	virtual void TearDown()
+	{
+	}
+};
+
+TEST_F( M6502ConstexprTests, CompileTimeTableMatchesARunTimeRun )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFC] = CPU::INS_LDA_IM;
+	mem[0xFFFD] = 0;
+	for ( Word Step = 0; Step < 11; Step++ )
+	{
+		mem[0x0200 + Step * 3] = CPU::INS_CLC;
+		mem[0x0201 + Step * 3] = CPU::INS_ADC_IM;
+		mem[0x0202 + Step * 3] = 11;
+	}
+	mem[0xFFFE] = CPU::INS_JMP_ABS;
+	mem[0xFFFF] = 0x00;
+	mem[0x0000] = 0x02;
+
+	//when:
+	cpu.Execute( 2 + 3 + 4 * 11, mem );
+
+	//then:
+	EXPECT_EQ( cpu.A, Squares[11] );
+}
+
+TEST_F( M6502ConstexprTests, StatusByteRoundTripsThroughTheFlags )
+{
+	// given:
+	using namespace m6502;
+
+	//when:
+	cpu.SetPS( 0b10100101 );
+
+	//then:
+	EXPECT_EQ( cpu.GetPS(), 0b10100101 );
+	EXPECT_TRUE( cpu.Flag.C );
+	EXPECT_TRUE( cpu.Flag.I );
+	EXPECT_TRUE( cpu.Flag.Unused );
+	EXPECT_TRUE( cpu.Flag.N );
+	EXPECT_FALSE( cpu.Flag.Z );
+	EXPECT_FALSE( cpu.Flag.V );
+}
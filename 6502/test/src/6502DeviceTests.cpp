@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+#include <string.h>
+#include <vector>
+#include "m6502.h"
+#include "m6502_devices.h"
+
+class M6502DeviceTests : public testing::Test
+{
+public:
+	m6502::DeviceMem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		cpu.Reset( mem );
+		cpu.PC = 0x8000;
+	}
+
+	virtual void TearDown()
+	{
+	}
+};
+
+namespace
+{
+	using namespace m6502;
+
+	// raises the irq every Period cycles
+	DeviceTask Timer( DeviceScheduler& Scheduler, CPU& Cpu, u64 Period, u32& Ticks )
+	{
+		for ( ;; )
+		{
+			co_await Scheduler.Delay( Period );
+			Ticks++;
+			Cpu.Interrupts.RaiseIRQ();
+		}
+	}
+
+	// a write to Address acknowledges the irq
+	DeviceTask Acknowledge( DeviceScheduler& Scheduler, CPU& Cpu, Word Address, u32& Acks )
+	{
+		for ( ;; )
+		{
+			co_await Scheduler.Access( Address, BusAccess::WRITE );
+			Acks++;
+			Cpu.Interrupts.ClearIRQ();
+		}
+	}
+
+	// every read of Address gives the next number
+	DeviceTask Counter( DeviceScheduler& Scheduler, DeviceMem& Memory, Word Address )
+	{
+		Byte Next = 1;
+		for ( ;; )
+		{
+			BusAccess Access = co_await Scheduler.Access( Address, BusAccess::READ );
+			Memory[Access.Address] = Next++;
+		}
+	}
+
+	DeviceTask WakeAfter( DeviceScheduler& Scheduler, u64 Cycles, std::vector<u64>& Woken )
+	{
+		co_await Scheduler.Delay( Cycles );
+		Woken.push_back( Scheduler.Now() );
+	}
+
+	// waits Cycles from the write to Address, noting when it saw the write and when it woke
+	DeviceTask DelayAfterWrite( DeviceScheduler& Scheduler, Word Address, u64 Cycles, u64& Written, u64& Woken )
+	{
+		co_await Scheduler.Access( Address, BusAccess::WRITE );
+		Written = Scheduler.Now();
+		co_await Scheduler.Delay( Cycles );
+		Woken = Scheduler.Now();
+	}
+
+	DeviceTask Pulse( DeviceScheduler& Scheduler, u32& Pulses )
+	{
+		co_await Scheduler.Delay( 10 );
+		Pulses++;
+	}
+
+	// starts a nested task for every pulse, so its frame is made and freed each time
+	DeviceTask PulseTrain( DeviceScheduler& Scheduler, u32& Pulses )
+	{
+		for ( ;; )
+		{
+			co_await Scheduler.Delay( 90 );
+			co_await Pulse( Scheduler, Pulses );
+		}
+	}
+}
+
+TEST_F( M6502DeviceTests, ATimerDeviceInterruptsTheCpuEveryPeriod )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFE] = 0x00;
+	mem[0xFFFF] = 0x90;
+	mem[0x8000] = CPU::INS_CLI;
+	mem[0x8001] = CPU::INS_JMP_ABS;
+	mem[0x8002] = 0x01;
+	mem[0x8003] = 0x80;
+	mem[0x9000] = CPU::INS_STA_ABS;		//acknowledge
+	mem[0x9001] = 0x00;
+	mem[0x9002] = 0xD0;
+	mem[0x9003] = CPU::INS_RTI;
+	u32 Ticks = 0, Acks = 0;
+	DeviceScheduler Scheduler( mem );
+	Scheduler.Spawn( Timer( Scheduler, cpu, 1000, Ticks ) );
+	Scheduler.Spawn( Acknowledge( Scheduler, cpu, 0xD000, Acks ) );
+
+	//when:
+	u64 CyclesUsed = Scheduler.Run( cpu, 10500 );
+
+	//then:
+	EXPECT_GE( CyclesUsed, 10500 );
+	EXPECT_EQ( Ticks, 10u );
+	EXPECT_EQ( Acks, 10u );
+	EXPECT_FALSE( cpu.Interrupts.Any() );
+	EXPECT_EQ( Scheduler.NumWaiting(), 2u );
+}
+
+TEST_F( M6502DeviceTests, AReadOfAWatchedAddressGetsTheValueTheDevicePutThere )
+{
+	// given:
+	using namespace m6502;
+	mem[0x8000] = CPU::INS_LDA_ABS;
+	mem[0x8001] = 0x10;
+	mem[0x8002] = 0xD0;
+	mem[0x8003] = CPU::INS_STA_ZP;
+	mem[0x8004] = 0x20;
+	mem[0x8005] = CPU::INS_LDA_ABS;
+	mem[0x8006] = 0x10;
+	mem[0x8007] = 0xD0;
+	mem[0x8008] = CPU::INS_STA_ZP;
+	mem[0x8009] = 0x21;
+	DeviceScheduler Scheduler( mem );
+	Scheduler.Spawn( Counter( Scheduler, mem, 0xD010 ) );
+
+	//when:
+	Scheduler.Run( cpu, 14 );
+
+	//then:
+	EXPECT_EQ( mem[0x20], 1 );
+	EXPECT_EQ( mem[0x21], 2 );
+	EXPECT_TRUE( mem.IsWatched( 0xD010 ) );
+	EXPECT_FALSE( mem.IsWatched( 0xD011 ) );
+}
+
+TEST_F( M6502DeviceTests, DevicesWakeAtTheFirstInstructionBoundaryAtOrAfterTheirCycle )
+{
+	// given:
+	using namespace m6502;
+	mem[0x8000] = CPU::INS_JMP_ABS;		//3 cycles a time
+	mem[0x8001] = 0x00;
+	mem[0x8002] = 0x80;
+	std::vector<u64> Woken;
+	DeviceScheduler Scheduler( mem );
+	Scheduler.Spawn( WakeAfter( Scheduler, 100, Woken ) );
+	Scheduler.Spawn( WakeAfter( Scheduler, 10, Woken ) );
+	Scheduler.Spawn( WakeAfter( Scheduler, 10, Woken ) );
+
+	//when:
+	Scheduler.Run( cpu, 200 );
+
+	//then:
+	ASSERT_EQ( Woken.size(), 3u );
+	EXPECT_EQ( Woken[0], 12u );
+	EXPECT_EQ( Woken[1], 12u );
+	EXPECT_EQ( Woken[2], 102u );
+	EXPECT_EQ( Scheduler.NumWaiting(), 0u );
+}
+
+TEST_F( M6502DeviceTests, SteadyStateRunsTakeCoroutineFramesFromThePool )
+{
+	// given:
+	using namespace m6502;
+	mem[0x8000] = CPU::INS_JMP_ABS;
+	mem[0x8001] = 0x00;
+	mem[0x8002] = 0x80;
+	u32 Pulses = 0;
+	DeviceScheduler Scheduler( mem );
+	Scheduler.Spawn( PulseTrain( Scheduler, Pulses ) );
+	Scheduler.Run( cpu, 1000 );
+	const u64 HeapAllocations = FramePool::ThisThread().HeapAllocations();
+
+	//when:
+	Scheduler.Run( cpu, 100000 );
+
+	//then:
+	EXPECT_GE( Pulses, 900u );
+	EXPECT_EQ( FramePool::ThisThread().HeapAllocations(), HeapAllocations );
+}
+
+TEST_F( M6502DeviceTests, ADelayStartedFromABusAccessEndsTheRunningSliceOnTime )
+{
+	// given:
+	using namespace m6502;
+	mem[0x8000] = CPU::INS_LDA_IM;
+	mem[0x8001] = 0x01;
+	mem[0x8002] = CPU::INS_STA_ABS;		//starts on cycle 2
+	mem[0x8003] = 0x00;
+	mem[0x8004] = 0xD0;
+	mem[0x8005] = CPU::INS_JMP_ABS;		//then every 3 cycles from 6
+	mem[0x8006] = 0x05;
+	mem[0x8007] = 0x80;
+	u64 Written = 0, Woken = 0;
+	DeviceScheduler Scheduler( mem );
+	Scheduler.Spawn( DelayAfterWrite( Scheduler, 0xD000, 10, Written, Woken ) );
+
+	//when:
+	Scheduler.Run( cpu, 1000 );
+
+	//then:
+	EXPECT_EQ( Written, 2u );
+	EXPECT_EQ( Woken, 12u );
+}
+
+TEST_F( M6502DeviceTests, FinishedDevicesGiveTheirFramesBack )
+{
+	// given:
+	using namespace m6502;
+	mem[0x8000] = CPU::INS_JMP_ABS;
+	mem[0x8001] = 0x00;
+	mem[0x8002] = 0x80;
+	u32 Pulses = 0;
+	DeviceScheduler Scheduler( mem );
+	for ( u32 i = 0; i < 2; i++ )		//a new frame is made before the finished one is reaped
+	{
+		Scheduler.Spawn( Pulse( Scheduler, Pulses ) );
+		Scheduler.Run( cpu, 20 );
+	}
+	const u64 HeapAllocations = FramePool::ThisThread().HeapAllocations();
+
+	//when:
+	for ( u32 i = 0; i < 100; i++ )
+	{
+		Scheduler.Spawn( Pulse( Scheduler, Pulses ) );
+		Scheduler.Run( cpu, 20 );
+	}
+
+	//then:
+	EXPECT_EQ( Pulses, 102u );
+	EXPECT_EQ( FramePool::ThisThread().HeapAllocations(), HeapAllocations );
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "m6502.h"
+#include "m6502_dirtymem.h"
+
+class M6502DirtyMemTests : public testing::Test
+{
+public:
+	m6502::DirtyMem mem;
+	m6502::CPU cpu;
+	std::vector<m6502::DirtyRange> Ranges;
+
+	virtual void SetUp()
+	{
+		using namespace m6502;
+		cpu.Reset( mem );
+		cpu.PC = 0x8000;
+		const Byte Program[] = {
+			CPU::INS_LDA_IM, 0x01,
+			CPU::INS_STA_ABS, 0x34, 0x12,
+			CPU::INS_STA_ABS, 0x40, 0x12,
+			CPU::INS_STA_ABS, 0x00, 0x20,
+			CPU::INS_STA_ABS, 0xFF, 0xFF };
+		for ( u32 i = 0; i < sizeof( Program ); i++ )
+		{
+			mem[0x8000 + i] = Program[i];
+		}
+		mem.ClearDirty();
+	}
+
+	virtual void TearDown()
+	{
+	}
+};
+
+TEST_F( M6502DirtyMemTests, CpuWritesMarkTheirRegionsAndNeighboursMerge )
+{
+	// given:
+	using namespace m6502;
+
+	//when:
+	cpu.Execute( 18, mem );
+	mem.DirtyRanges( Ranges );
+
+	//then:
+	const std::vector<DirtyRange> Expected = { { 0x1200, 0x1280 }, { 0x2000, 0x2040 }, { 0xFFC0, 0x10000 } };
+	EXPECT_EQ( Ranges, Expected );
+	EXPECT_TRUE( mem.IsDirty( 0x127F ) );
+	EXPECT_FALSE( mem.IsDirty( 0x1280 ) );
+	EXPECT_FALSE( mem.IsDirty( 0x8000 ) );
+}
+
+TEST_F( M6502DirtyMemTests, PageRegionsCoverWholePages )
+{
+	// given:
+	using namespace m6502;
+	DirtyMem PageMem( 256 );
+	for ( u32 i = 0x8000; i < 0x800E; i++ )
+	{
+		PageMem[i] = mem[i];
+	}
+	PageMem.ClearDirty();
+	CPU PageCpu = cpu;
+
+	//when:
+	PageCpu.Execute( 18, PageMem );
+	PageMem.DirtyRanges( Ranges );
+
+	//then:
+	const std::vector<DirtyRange> Expected = { { 0x1200, 0x1300 }, { 0x2000, 0x2100 }, { 0xFF00, 0x10000 } };
+	EXPECT_EQ( PageMem.RegionSize(), 256u );
+	EXPECT_EQ( Ranges, Expected );
+}
+
+TEST_F( M6502DirtyMemTests, TakingTheRangesClearsThemAndReadsDoNotDirty )
+{
+	// given:
+	using namespace m6502;
+	cpu.Execute( 5, mem );
+	mem.TakeDirtyRanges( Ranges );
+
+	//when:
+	mem[0x3000] = 0x42;		//host writes are not tracked
+	Byte Value = mem.Read( 0x1234 );
+
+	//then:
+	EXPECT_EQ( Ranges.size(), 1u );
+	EXPECT_EQ( Value, 0x01 );
+	EXPECT_FALSE( mem.AnyDirty() );
+	mem.DirtyRanges( Ranges );
+	EXPECT_TRUE( Ranges.empty() );
+}
+
+TEST_F( M6502DirtyMemTests, InitializeMarksEverythingDirty )
+{
+	// given:
+	using namespace m6502;
+
+	//when:
+	mem.Initialize();
+	mem.DirtyRanges( Ranges );
+
+	//then:
+	ASSERT_EQ( Ranges.size(), 1u );
+	EXPECT_EQ( Ranges[0].First, 0 );
+	EXPECT_EQ( Ranges[0].End, 0x10000u );
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <unistd.h>
+#include "m6502.h"
+#include "m6502_disassembler.h"
+
+class M6502DisassemblerTests : public testing::Test
+{
+public:
+	m6502::DisassemblerOptions options;
+	std::vector<m6502::Byte> image;
+
+	virtual void SetUp()
+	{
+		using namespace m6502;
+		options.Origin = 0x8000;
+		image.assign( 0x8000, 0xFF );
+		Put( 0x8000, { CPU::INS_JSR, 0x10, 0x80, CPU::INS_JMP_ABS, 0x20, 0x80 } );
+		Put( 0x8010, { CPU::INS_LDA_IM, 0x01, CPU::INS_RTS } );
+		Put( 0x8020, { CPU::INS_JSR, 0x30, 0x80, CPU::INS_JMP_ABS, 0x03, 0x80 } );
+		Put( 0x8030, { CPU::INS_CLC, CPU::INS_JMP_ABS, 0x10, 0x80 } );
+		Put( 0xFFFA, { 0x12, 0x80, 0x00, 0x80, 0x12, 0x80 } );
+	}
+
+	virtual void TearDown()
+	{
+	}
+
+	void Put( m6502::Word Address, std::initializer_list<m6502::Byte> Bytes )
+	{
+		for ( m6502::Byte Value : Bytes )
+		{
+			image[Address++ - options.Origin] = Value;
+		}
+	}
+};
+
+TEST_F( M6502DisassemblerTests, TracesRoutinesBlocksAndCallsFromTheVectors )
+{
+	// given:
+	using namespace m6502;
+
+	//when:
+	ImageAnalysis Analysis = Disassembler::Analyze( image, options );
+
+	//then:
+	EXPECT_EQ( Analysis.Instructions, ( std::vector<Word>{ 0x8000, 0x8003, 0x8010, 0x8012, 0x8020, 0x8023, 0x8030, 0x8031 } ) );
+	EXPECT_EQ( Analysis.Routines, ( std::vector<Word>{ 0x8000, 0x8010, 0x8012, 0x8030 } ) );
+	EXPECT_EQ( Analysis.Calls, ( std::vector<std::pair<Word, Word>>{ { 0x8000, 0x8010 }, { 0x8000, 0x8030 } } ) );
+	const std::vector<BasicBlock> Expected = {
+		{ 0x8000, 0x8003, { 0x8003 } },
+		{ 0x8003, 0x8006, { 0x8020 } },
+		{ 0x8010, 0x8012, { 0x8012 } },
+		{ 0x8012, 0x8013, {} },
+		{ 0x8020, 0x8023, { 0x8023 } },
+		{ 0x8023, 0x8026, { 0x8003 } },
+		{ 0x8030, 0x8034, { 0x8010 } } };
+	EXPECT_EQ( Analysis.Blocks, Expected );
+}
+
+TEST_F( M6502DisassemblerTests, TracingStopsAtBytesThatDoNotDecode )
+{
+	// given:
+	using namespace m6502;
+	options.FollowVectors = false;
+	options.Entries = { 0x8040 };
+	Put( 0x8040, { CPU::INS_LDA_ZPX, 0x10, 0x02, CPU::INS_RTS } );
+
+	//when:
+	ImageAnalysis Analysis = Disassembler::Analyze( image, options );
+
+	//then:
+	EXPECT_EQ( Analysis.Instructions, ( std::vector<Word>{ 0x8040 } ) );
+	ASSERT_EQ( Analysis.Blocks.size(), 1u );
+	EXPECT_TRUE( Analysis.Blocks[0].Successors.empty() );
+}
+
+TEST_F( M6502DisassemblerTests, AnImageRunningPastTheAddressSpaceIsNotTraced )
+{
+	// given:
+	using namespace m6502;
+	options.FollowVectors = false;
+	options.Entries = { 0xFFFD, 0xFFFE };
+	Put( 0xFFFD, { CPU::INS_CLC, CPU::INS_JSR, 0x00 } );
+	std::vector<Byte> TooLarge( 0x10000, CPU::INS_CLC );
+
+	//when:
+	ImageAnalysis Fitting = Disassembler::Analyze( image, options );
+	ImageAnalysis Overflowing = Disassembler::Analyze( TooLarge, options );
+
+	//then:
+	EXPECT_TRUE( Disassembler::Fits( image, options.Origin ) );
+	EXPECT_FALSE( Disassembler::Fits( TooLarge, options.Origin ) );
+	EXPECT_EQ( Fitting.Instructions, ( std::vector<Word>{ 0xFFFD } ) );
+	EXPECT_TRUE( Overflowing.Instructions.empty() );
+	EXPECT_TRUE( Overflowing.Blocks.empty() );
+	EXPECT_EQ( Overflowing.Key, Disassembler::ImageKey( TooLarge, options ) );
+}
+
+TEST_F( M6502DisassemblerTests, ListingLabelsRoutinesAndFormatsOperands )
+{
+	// given:
+	using namespace m6502;
+	ImageAnalysis Analysis = Disassembler::Analyze( image, options );
+
+	//when:
+	std::string Listing = Disassembler::Listing( image, options, Analysis );
+
+	//then:
+	EXPECT_NE( Listing.find( "; routine $8000\n8000  20 10 80  JSR $8010\n" ), std::string::npos );
+	EXPECT_NE( Listing.find( "; block $8003\n8003  4C 20 80  JMP $8020\n" ), std::string::npos );
+	EXPECT_NE( Listing.find( "8010  A9 01     LDA #$01\n" ), std::string::npos );
+	EXPECT_EQ( FormatInstruction( CPU::INS_LDA_INDY, 0x42 ), "LDA ($42),Y" );
+	EXPECT_EQ( FormatInstruction( CPU::INS_JMP_IND, 0x1234 ), "JMP ($1234)" );
+	EXPECT_EQ( FormatInstruction( CPU::INS_STX_ZPY, 0x10 ), "STX $10,Y" );
+}
+
+TEST_F( M6502DisassemblerTests, ManyImagesInParallelMatchSerialAndComeFromTheCacheNextTime )
+{
+	// given:
+	using namespace m6502;
+	std::vector<std::vector<Byte>> Images;
+	for ( Byte i = 0; i < 24; i++ )
+	{
+		Put( 0x8011, { i } );
+		Put( 0x8023, { i % 3 == 0 ? CPU::INS_RTS : CPU::INS_JMP_ABS } );
+		Images.push_back( image );
+	}
+	const std::string Directory = testing::TempDir() + "m6502_cfg_cache_" + std::to_string( getpid() );
+	std::filesystem::create_directories( Directory );
+	AnalysisCache Cache( Directory );
+
+	//when:
+	std::vector<ImageAnalysis> First = Disassembler::AnalyzeAll( Images, options, 4, &Cache );
+	std::vector<ImageAnalysis> Second = Disassembler::AnalyzeAll( Images, options, 4, &Cache );
+
+	//then:
+	ASSERT_EQ( First.size(), Images.size() );
+	ASSERT_EQ( Second.size(), Images.size() );
+	for ( size_t i = 0; i < Images.size(); i++ )
+	{
+		ImageAnalysis Serial = Disassembler::Analyze( Images[i], options );
+		EXPECT_TRUE( First[i].SameAs( Serial ) );
+		EXPECT_FALSE( First[i].FromCache );
+		EXPECT_TRUE( Second[i].SameAs( Serial ) );
+		EXPECT_TRUE( Second[i].FromCache );
+	}
+	EXPECT_NE( First[0].Key, First[1].Key );
+	std::filesystem::remove_all( Directory );
+}
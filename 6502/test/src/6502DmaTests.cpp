@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include "m6502.h"
+#include "m6502_dma.h"
+#include "m6502_dirtymem.h"
+
+class M6502DmaTests : public testing::Test
+{
+public:
+	m6502::Mem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		cpu.Reset( mem );
+		cpu.PC = 0x8000;
+		for ( m6502::u32 i = 0; i < 256; i++ )
+		{
+			mem[0x0200 + i] = static_cast<m6502::Byte>( i ^ 0x5A );
+		}
+		for ( m6502::u32 Address = 0x8000; Address < 0x8100; Address += 2 )
+		{
+			mem[Address] = m6502::CPU::INS_LDA_IM;
+			mem[Address + 1] = 0x42;
+		}
+	}
+
+	virtual void TearDown()
+	{
+	}
+};
+
+TEST_F( M6502DmaTests, APageCopyHaltsTheCpuFor513Cycles )
+{
+	// given:
+	using namespace m6502;
+	DmaController Dma( cpu );
+	ASSERT_TRUE( Dma.StartPage( 0x02, 0x07 ) );
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( 1, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, 513 + 2 );	//the cpu resumes with the next instruction
+	EXPECT_EQ( cpu.PC, 0x8002 );
+	EXPECT_EQ( memcmp( &mem[0x0700], &mem[0x0200], 256 ), 0 );
+	EXPECT_FALSE( Dma.Busy() );
+	EXPECT_EQ( Dma.CyclesStolen(), 513u );
+	EXPECT_FALSE( cpu.Interrupts.Any() );
+}
+
+TEST_F( M6502DmaTests, StolenCyclesComeOutOfTheExecuteBudget )
+{
+	// given:
+	using namespace m6502;
+	DmaController Dma( cpu );
+	Dma.StartPage( 0x02, 0x07 );
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( 513 + 10, mem );
+
+	//then: five LDA #$42 after the transfer
+	EXPECT_EQ( CyclesUsed, 513 + 10 );
+	EXPECT_EQ( cpu.PC, 0x800A );
+}
+
+TEST_F( M6502DmaTests, BurstsLetTheCpuRunAnInstructionInBetween )
+{
+	// given:
+	using namespace m6502;
+	DmaConfig Config;
+	Config.BurstBytes = 64;
+	DmaController Dma( cpu, Config );
+	Dma.Start( 0x0200, 0x0700, 256 );
+
+	//when:
+	s32 First = cpu.Execute( 1, mem );
+	const bool HalfWay = mem[0x0740] == 0 && mem[0x073F] == mem[0x023F];
+	s32 Rest = cpu.Execute( 3 * ( 2 * 64 + 2 ), mem );
+
+	//then:
+	EXPECT_EQ( First, 1 + 2 * 64 + 2 );
+	EXPECT_TRUE( HalfWay );
+	EXPECT_EQ( Rest, 3 * ( 2 * 64 + 2 ) );
+	EXPECT_EQ( cpu.PC, 0x8008 );
+	EXPECT_FALSE( Dma.Busy() );
+	EXPECT_EQ( memcmp( &mem[0x0700], &mem[0x0200], 256 ), 0 );
+}
+
+TEST_F( M6502DmaTests, ATransferWrapsAroundTheAddressSpaceAndCopiesForwardsByteByByte )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFE] = 0x11;
+	mem[0xFFFF] = 0x22;
+	mem[0x0000] = 0x33;
+	DmaController Dma( cpu );
+	EXPECT_FALSE( Dma.Start( 0x0000, 0x0000, 0 ) );
+	Dma.Start( 0xFFFE, 0x0010, 3 );
+	cpu.Execute( 1, mem );
+
+	//when: the destination is one byte above the source
+	Dma.Start( 0x0010, 0x0011, 4 );
+	EXPECT_FALSE( Dma.Start( 0x0000, 0x0100, 1 ) );
+	cpu.Execute( 1, mem );
+
+	//then:
+	EXPECT_EQ( mem[0x0010], 0x11 );
+	EXPECT_EQ( mem[0x0011], 0x11 );
+	EXPECT_EQ( mem[0x0012], 0x11 );
+	EXPECT_EQ( mem[0x0013], 0x11 );
+	EXPECT_EQ( mem[0x0014], 0x11 );
+	EXPECT_EQ( Dma.BytesCopied(), 7u );
+}
+
+TEST_F( M6502DmaTests, ATransferGoesThroughTheMemoryTheCpuRunsOn )
+{
+	// given:
+	using namespace m6502;
+	DirtyMem dirty;
+	CPU DirtyCpu;
+	DirtyCpu.Reset( dirty );
+	DirtyCpu.PC = 0x8000;
+	dirty[0x8000] = CPU::INS_LDA_IM;
+	dirty[0x8001] = 0x42;
+	dirty[0x0200] = 0x5A;
+	dirty.ClearDirty();
+	DmaController Dma( DirtyCpu );
+	Dma.StartPage( 0x02, 0x07 );
+
+	//when:
+	DirtyCpu.Execute( 1, dirty );
+
+	//then:
+	EXPECT_EQ( dirty.Read( 0x0700 ), 0x5A );
+	std::vector<DirtyRange> Ranges;
+	dirty.DirtyRanges( Ranges );
+	ASSERT_EQ( Ranges.size(), 1u );
+	EXPECT_EQ( Ranges[0].First, 0x0700 );
+	EXPECT_EQ( Ranges[0].End, 0x0800u );
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "m6502.h"
+#include "m6502_hashedmem.h"
+
+class M6502HashedMemTests : public testing::Test
+{
+public:
+	m6502::HashedMem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		cpu.Reset( mem );
+	}
+
+	virtual void TearDown()
+	{
+	}
+};
+
+TEST_F( M6502HashedMemTests, EqualMachinesHaveEqualHashes )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFC] = CPU::INS_LDA_IM;
+	mem[0xFFFD] = 0x42;
+	mem[0xFFFE] = CPU::INS_STA_ZP;
+	mem[0xFFFF] = 0x10;
+	HashedMem OtherMem = mem;
+	CPU OtherCpu = cpu;
+
+	//when:
+	cpu.Execute( 5, mem );
+	OtherCpu.Execute( 5, OtherMem );
+
+	//then:
+	EXPECT_EQ( mem.StateHash( cpu ), OtherMem.StateHash( OtherCpu ) );
+	OtherCpu.Flag.C = 1;
+	EXPECT_NE( mem.StateHash( cpu ), OtherMem.StateHash( OtherCpu ) );
+}
+
+TEST_F( M6502HashedMemTests, OneByteChangesTheRootAndChangingItBackRestoresIt )
+{
+	// given:
+	using namespace m6502;
+	u64 Before = mem.Root();
+
+	//when:
+	mem.Write( 0x1234, 0x01 );
+	u64 Changed = mem.Root();
+	mem.Write( 0x1234, 0x00 );
+	u64 Restored = mem.Root();
+
+	//then:
+	EXPECT_NE( Changed, Before );
+	EXPECT_EQ( Restored, Before );
+}
+
+TEST_F( M6502HashedMemTests, OnlyWrittenPagesAreRehashed )
+{
+	// given:
+	using namespace m6502;
+	mem.Root();
+	mem[0xFFFC] = CPU::INS_LDA_IM;
+	mem[0xFFFD] = 0x42;
+	mem[0xFFFE] = CPU::INS_STA_ZP;
+	mem[0xFFFF] = 0x10;
+	mem.Root();
+
+	//when:
+	cpu.Execute( 5, mem );
+
+	//then:
+	EXPECT_EQ( mem.NumDirtyPages(), 1u );	//the zero page
+	mem.Root();
+	EXPECT_EQ( mem.NumDirtyPages(), 0u );
+}
+
+TEST_F( M6502HashedMemTests, IncrementalRootsMatchHashingEverything )
+{
+	// given:
+	using namespace m6502;
+	std::mt19937 Random( 38 );
+	mem.Root();
+
+	//when:
+	for ( int Round = 0; Round < 20; Round++ )
+	{
+		for ( int i = 0; i < 50; i++ )
+		{
+			mem.Write( static_cast<Word>( Random() ), static_cast<Byte>( Random() ) );
+		}
+		HashedMem Fresh;
+		for ( u32 Address = 0; Address < HashedMem::MAX_MEM; Address++ )
+		{
+			Fresh[Address] = static_cast<const HashedMem&>( mem )[Address];
+		}
+
+		//then:
+		ASSERT_EQ( mem.Root(), Fresh.Root() );
+	}
+}
+
+TEST_F( M6502HashedMemTests, SwappingTwoPagesChangesTheRoot )
+{
+	// given:
+	using namespace m6502;
+	HashedMem Swapped;
+	mem[0x0200] = 0xAA;
+	mem[0x0300] = 0xBB;
+	Swapped[0x0200] = 0xBB;
+	Swapped[0x0300] = 0xAA;
+
+	//when:
+	u64 Root = mem.Root();
+	u64 SwappedRoot = Swapped.Root();
+
+	//then:
+	EXPECT_NE( Root, SwappedRoot );
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <string.h>
+#include <random>
+#include "m6502.h"
+#include "m6502_input.h"
+
+class M6502InputTests : public testing::Test
+{
+public:
+	m6502::InputMem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		Load( mem, cpu );
+	}
+
+	virtual void TearDown()
+	{
+	}
+
+	// a loop that adds up keyboard bytes and stores them where the serial port says
+	static void Load( m6502::InputMem& Memory, m6502::CPU& Cpu )
+	{
+		using namespace m6502;
+		Cpu.Reset( Memory );
+		Cpu.PC = 0x8000;
+		static const Byte Program[] = {
+			CPU::INS_LDA_ABS, 0x10, 0xD0,	//8000 LDA $D010
+			CPU::INS_ADC_ZP, 0x20,			//8003 ADC $20
+			CPU::INS_STA_ZP, 0x20,			//8005 STA $20
+			CPU::INS_LDX_ABS, 0x11, 0xD0,	//8007 LDX $D011
+			CPU::INS_STA_ABSX, 0x00, 0x03,	//800A STA $0300,X
+			CPU::INS_JMP_ABS, 0x00, 0x80 };	//800D JMP $8000
+		memcpy( &Memory[0x8000], Program, sizeof( Program ) );
+	}
+};
+
+TEST_F( M6502InputTests, ReplayReproducesTheRecordedRun )
+{
+	// given:
+	using namespace m6502;
+	std::mt19937 Random( 37 );
+	mem.MapInput( 0xD010, [&Random]( Word ) { return static_cast<Byte>( Random() ); } );
+	mem.MapInput( 0xD011, [&Random]( Word ) { return static_cast<Byte>( Random() ); } );
+	InputLog Log;
+	InputRecorder Recording( mem, Log );
+	u64 Recorded = Recording.Record( cpu, 100000 );
+
+	InputMem ReplayMem;
+	CPU ReplayCpu;
+	Load( ReplayMem, ReplayCpu );
+	ReplayMem.MapInput( 0xD010, nullptr );	//no live input, everything comes from the log
+	ReplayMem.MapInput( 0xD011, nullptr );
+	InputRecorder Replaying( ReplayMem, Log );
+
+	//when:
+	u64 Replayed = Replaying.Replay( ReplayCpu, 100000 );
+
+	//then:
+	EXPECT_EQ( Replayed, Recorded );
+	EXPECT_FALSE( Replaying.Diverged() );
+	EXPECT_EQ( Replaying.Position(), Log.Entries.size() );
+	EXPECT_EQ( Log.Entries.size(), 2 * 4545 + 1u );	//two reads per 22 cycle loop, plus the LDA of the last one
+	EXPECT_EQ( ReplayCpu.PC, cpu.PC );
+	EXPECT_EQ( ReplayCpu.A, cpu.A );
+	EXPECT_EQ( ReplayCpu.X, cpu.X );
+	EXPECT_EQ( ReplayCpu.GetPS(), cpu.GetPS() );
+	EXPECT_EQ( memcmp( &ReplayMem[0], &mem[0], InputMem::MAX_MEM ), 0 );
+}
+
+TEST_F( M6502InputTests, LogsSurviveSavingAndLoading )
+{
+	// given:
+	using namespace m6502;
+	InputLog Log;
+	Log.Entries.push_back( { 4, 0xD010, 0x41 } );
+	Log.Entries.push_back( { 17, 0xD010, 0x42 } );
+	Log.Entries.push_back( { 17, 0xD011, 0x07 } );
+	Log.Entries.push_back( { 5000000000ull, 0xD010, 0x43 } );
+	const std::string Path = testing::TempDir() + "m6502_input_test.log";
+	InputLog Loaded;
+
+	//when:
+	bool Saved = Log.Save( Path.c_str() );
+	bool Read = Loaded.Load( Path.c_str() );
+	remove( Path.c_str() );
+
+	//then:
+	EXPECT_TRUE( Saved );
+	ASSERT_TRUE( Read );
+	ASSERT_EQ( Loaded.Entries.size(), Log.Entries.size() );
+	for ( size_t i = 0; i < Log.Entries.size(); i++ )
+	{
+		EXPECT_EQ( Loaded.Entries[i].Cycle, Log.Entries[i].Cycle );
+		EXPECT_EQ( Loaded.Entries[i].Address, Log.Entries[i].Address );
+		EXPECT_EQ( Loaded.Entries[i].Value, Log.Entries[i].Value );
+	}
+	EXPECT_LE( Log.Encode().size(), 8u + 1u + 4u + 2u + 2u + 4u + 2u + 8u + 2u );
+}
+
+TEST_F( M6502InputTests, ReplayNoticesWhenTheProgramChanged )
+{
+	// given:
+	using namespace m6502;
+	mem.MapInput( 0xD010, []( Word ) { return static_cast<Byte>( 1 ); } );
+	mem.MapInput( 0xD011, []( Word ) { return static_cast<Byte>( 2 ); } );
+	InputLog Log;
+	InputRecorder Recording( mem, Log );
+	Recording.Record( cpu, 1000 );
+
+	InputMem ReplayMem;
+	CPU ReplayCpu;
+	Load( ReplayMem, ReplayCpu );
+	ReplayMem[0x8003] = CPU::INS_ADC_ABS;	//one cycle slower than ADC $20
+	ReplayMem[0x8005] = 0x00;
+	ReplayMem.MapInput( 0xD010, nullptr );
+	ReplayMem.MapInput( 0xD011, nullptr );
+	InputRecorder Replaying( ReplayMem, Log );
+
+	//when:
+	Replaying.Replay( ReplayCpu, 1000 );
+
+	//then:
+	EXPECT_TRUE( Replaying.Diverged() );
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include "m6502.h"
+
+class M6502InterruptTests : public testing::Test
+{
+public:
+	m6502::Mem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		cpu.Reset( mem );
+	}
+
+	virtual void TearDown()
+	{
+	}
+};
+
+TEST_F( M6502InterruptTests, BRKPushesPCAndStatusAndJumpsThroughTheIRQVector )
+{
+	// given:
+	using namespace m6502;
+	cpu.Flag.C = 1;
+	mem[0xFFFC] = CPU::INS_BRK;
+	mem[0xFFFE] = 0x00;
+	mem[0xFFFF] = 0x80;	//0x8000
+	constexpr s32 EXPECTED_CYCLES = 7;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( EXPECTED_CYCLES, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, EXPECTED_CYCLES );
+	EXPECT_EQ( cpu.PC, 0x8000 );
+	EXPECT_EQ( cpu.SP, 0xFC );
+	EXPECT_EQ( mem[0x01FF], 0xFF );	//return address 0xFFFE, hi byte
+	EXPECT_EQ( mem[0x01FE], 0xFE );	//lo byte
+	EXPECT_EQ( mem[0x01FD], CPU::FLAG_BREAK | CPU::FLAG_UNUSED | 0x01 );
+	EXPECT_TRUE( cpu.Flag.I );
+}
+
+TEST_F( M6502InterruptTests, RTIRestoresTheStatusAndPC )
+{
+	// given:
+	using namespace m6502;
+	cpu.SP = 0xFC;
+	mem[0x01FD] = CPU::FLAG_BREAK | CPU::FLAG_UNUSED | 0b10000001;
+	mem[0x01FE] = 0x34;
+	mem[0x01FF] = 0x12;
+	mem[0xFFFC] = CPU::INS_RTI;
+	constexpr s32 EXPECTED_CYCLES = 6;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( EXPECTED_CYCLES, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, EXPECTED_CYCLES );
+	EXPECT_EQ( cpu.PC, 0x1234 );
+	EXPECT_EQ( cpu.SP, 0xFF );
+	EXPECT_TRUE( cpu.Flag.C );
+	EXPECT_TRUE( cpu.Flag.N );
+	EXPECT_FALSE( cpu.Flag.B );
+}
+
+TEST_F( M6502InterruptTests, ARaisedIRQIsTakenAtTheNextInstructionBoundary )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFC] = CPU::INS_LDA_IM;
+	mem[0xFFFD] = 0x84;
+	mem[0x8000] = CPU::INS_LDA_IM;
+	mem[0x8001] = 0x42;
+	mem[0xFFFE] = 0x00;
+	mem[0xFFFF] = 0x80;	//0x8000
+	cpu.Interrupts.RaiseIRQ();
+	constexpr s32 EXPECTED_CYCLES = 7 + 2;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( EXPECTED_CYCLES, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, EXPECTED_CYCLES );
+	EXPECT_EQ( cpu.A, 0x42 );
+	EXPECT_EQ( cpu.PC, 0x8002 );
+	EXPECT_EQ( mem[0x01FF], 0xFF );	//interrupted at 0xFFFC
+	EXPECT_EQ( mem[0x01FE], 0xFC );
+	EXPECT_EQ( mem[0x01FD], CPU::FLAG_UNUSED );	//no break flag for a hardware irq
+	EXPECT_TRUE( cpu.Flag.I );
+}
+
+TEST_F( M6502InterruptTests, IRQIsIgnoredWhileInterruptsAreDisabled )
+{
+	// given:
+	using namespace m6502;
+	cpu.Flag.I = 1;
+	mem[0xFFFC] = CPU::INS_LDA_IM;
+	mem[0xFFFD] = 0x84;
+	cpu.Interrupts.RaiseIRQ();
+	constexpr s32 EXPECTED_CYCLES = 2;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( EXPECTED_CYCLES, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, EXPECTED_CYCLES );
+	EXPECT_EQ( cpu.A, 0x84 );
+	EXPECT_EQ( cpu.SP, 0xFF );
+}
+
+TEST_F( M6502InterruptTests, NMIIsTakenOnceEvenWhileInterruptsAreDisabled )
+{
+	// given:
+	using namespace m6502;
+	cpu.Flag.I = 1;
+	mem[0xFFFA] = 0x00;
+	mem[0xFFFB] = 0x90;	//0x9000
+	mem[0x9000] = CPU::INS_LDA_IM;
+	mem[0x9001] = 0x37;
+	mem[0x9002] = CPU::INS_LDX_IM;
+	mem[0x9003] = 0x38;
+	cpu.Interrupts.RaiseNMI();
+	constexpr s32 EXPECTED_CYCLES = 7 + 2 + 2;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( EXPECTED_CYCLES, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, EXPECTED_CYCLES );
+	EXPECT_EQ( cpu.A, 0x37 );
+	EXPECT_EQ( cpu.X, 0x38 );
+	EXPECT_EQ( cpu.SP, 0xFC );
+	EXPECT_EQ( cpu.Interrupts.Pending.load(), 0u );
+}
+
+TEST_F( M6502InterruptTests, IRQStaysAssertedUntilEverySourceClearsIt )
+{
+	// given:
+	using namespace m6502;
+	cpu.Interrupts.RaiseIRQ( 0b01 );
+	cpu.Interrupts.RaiseIRQ( 0b10 );
+
+	//when:
+	cpu.Interrupts.ClearIRQ( 0b01 );
+
+	//then:
+	EXPECT_EQ( cpu.Interrupts.Pending.load(), 0b10u );
+}
@@ -1,6 +1,7 @@
 
 #include <gtest/gtest.h>
 #include "m6502.h"
+#include "m6502_opcodes.h"
 
 class M6502LoadRegisterTests : public testing::Test
 {
@@ -102,14 +103,15 @@ void M6502LoadRegisterTests::TestLoadRegisterImmediate(
 	using namespace m6502;
 	mem[0xFFFC] = OpcodeToTest;
 	mem[0xFFFD] = 0x84;
+	const s32 EXPECTED_CYCLES = DecodeOpcode( OpcodeToTest ).Cycles;
 
 	//when:
 	CPU CPUCopy = cpu;
-	s32 CyclesUsed = cpu.Execute( 2, mem );
+	s32 CyclesUsed = cpu.Execute( EXPECTED_CYCLES, mem );
 
 	//then:
 	EXPECT_EQ( cpu.*RegisterToTest, 0x84 );
-	EXPECT_EQ( CyclesUsed, 2 );
+	EXPECT_EQ( CyclesUsed, EXPECTED_CYCLES );
 	EXPECT_FALSE( cpu.Flag.Z );
 	EXPECT_TRUE( cpu.Flag.N );
 	VerfifyUnmodifiedFlagsFromLoadRegister( cpu, CPUCopy );
@@ -142,14 +144,15 @@ void M6502LoadRegisterTests::TestLoadRegisterZeroPage(
 	mem[0xFFFC] = OpcodeToTest;
 	mem[0xFFFD] = 0x42;
 	mem[0x0042] = 0x37;
+	const s32 EXPECTED_CYCLES = DecodeOpcode( OpcodeToTest ).Cycles;
 
 	//when:
 	CPU CPUCopy = cpu;
-	s32 CyclesUsed = cpu.Execute( 3, mem );
+	s32 CyclesUsed = cpu.Execute( EXPECTED_CYCLES, mem );
 
 	//then:
 	EXPECT_EQ( cpu.*RegisterToTest, 0x37 );
-	EXPECT_EQ( CyclesUsed, 3 );
+	EXPECT_EQ( CyclesUsed, EXPECTED_CYCLES );
 	EXPECT_FALSE( cpu.Flag.Z );
 	EXPECT_FALSE( cpu.Flag.N );
 	VerfifyUnmodifiedFlagsFromLoadRegister( cpu, CPUCopy );
@@ -201,14 +204,15 @@ void M6502LoadRegisterTests::TestLoadRegisterZeroPageX(
 	mem[0xFFFC] = OpcodeToTest;
 	mem[0xFFFD] = 0x42;
 	mem[0x0047] = 0x37;
+	const s32 EXPECTED_CYCLES = DecodeOpcode( OpcodeToTest ).Cycles;
 	CPU CPUCopy = cpu;
 
 	//when:
-	s32 CyclesUsed = cpu.Execute( 4, mem );
+	s32 CyclesUsed = cpu.Execute( EXPECTED_CYCLES, mem );
 
 	//then:
 	EXPECT_EQ( cpu.*RegisterToTest, 0x37 );
-	EXPECT_EQ( CyclesUsed, 4 );
+	EXPECT_EQ( CyclesUsed, EXPECTED_CYCLES );
 	EXPECT_FALSE( cpu.Flag.Z );
 	EXPECT_FALSE( cpu.Flag.N );
 	VerfifyUnmodifiedFlagsFromLoadRegister( cpu, CPUCopy );
@@ -224,14 +228,15 @@ void M6502LoadRegisterTests::TestLoadRegisterZeroPageY(
 	mem[0xFFFC] = OpcodeToTest;
 	mem[0xFFFD] = 0x42;
 	mem[0x0047] = 0x37;
+	const s32 EXPECTED_CYCLES = DecodeOpcode( OpcodeToTest ).Cycles;
 	CPU CPUCopy = cpu;
 
 	//when:
-	s32 CyclesUsed = cpu.Execute( 4, mem );
+	s32 CyclesUsed = cpu.Execute( EXPECTED_CYCLES, mem );
 
 	//then:
 	EXPECT_EQ( cpu.*RegisterToTest, 0x37 );
-	EXPECT_EQ( CyclesUsed, 4 );
+	EXPECT_EQ( CyclesUsed, EXPECTED_CYCLES );
 	EXPECT_FALSE( cpu.Flag.Z );
 	EXPECT_FALSE( cpu.Flag.N );
 	VerfifyUnmodifiedFlagsFromLoadRegister( cpu, CPUCopy );
@@ -287,7 +292,7 @@ void M6502LoadRegisterTests::TestLoadRegisterAbsolute(
 	mem[0xFFFD] = 0x80;
 	mem[0xFFFE] = 0x44;	//0x4480
 	mem[0x4480] = 0x37;
-	constexpr s32 EXPECTED_CYCLES = 4;
+	const s32 EXPECTED_CYCLES = DecodeOpcode( OpcodeToTest ).Cycles;
 	CPU CPUCopy = cpu;
 
 	//when:
@@ -331,7 +336,7 @@ void M6502LoadRegisterTests::TestLoadRegisterAbsoluteX(
 	mem[0xFFFD] = 0x80;
 	mem[0xFFFE] = 0x44;	//0x4480
 	mem[0x4481] = 0x37;
-	constexpr s32 EXPECTED_CYCLES = 4;
+	const s32 EXPECTED_CYCLES = DecodeOpcode( OpcodeToTest ).Cycles;
 	CPU CPUCopy = cpu;
 
 	//when:
@@ -357,7 +362,7 @@ void M6502LoadRegisterTests::TestLoadRegisterAbsoluteY(
 	mem[0xFFFD] = 0x80;
 	mem[0xFFFE] = 0x44;	//0x4480
 	mem[0x4481] = 0x37;
-	constexpr s32 EXPECTED_CYCLES = 4;
+	const s32 EXPECTED_CYCLES = DecodeOpcode( OpcodeToTest ).Cycles;
 	CPU CPUCopy = cpu;
 
 	//when:
@@ -400,7 +405,7 @@ void M6502LoadRegisterTests::TestLoadRegisterAbsoluteXWhenCrossingPage(
 	mem[0xFFFD] = 0xFF;
 	mem[0xFFFE] = 0x44;	//0x44FF
 	mem[0x4500] = 0x37;	//0x44FF+0x1 crosses page boundary!
-	constexpr s32 EXPECTED_CYCLES = 5;
+	const s32 EXPECTED_CYCLES = DecodeOpcode( OpcodeToTest ).Cycles + DecodeOpcode( OpcodeToTest ).PageCrossCycles;
 	CPU CPUCopy = cpu;
 
 	//when:
@@ -443,7 +448,7 @@ void M6502LoadRegisterTests::TestLoadRegisterAbsoluteYWhenCrossingPage(
 	mem[0xFFFD] = 0xFF;
 	mem[0xFFFE] = 0x44;	//0x44FF
 	mem[0x4500] = 0x37;	//0x44FF+0x1 crosses page boundary!
-	constexpr s32 EXPECTED_CYCLES = 5;
+	const s32 EXPECTED_CYCLES = DecodeOpcode( OpcodeToTest ).Cycles + DecodeOpcode( OpcodeToTest ).PageCrossCycles;
 	CPU CPUCopy = cpu;
 
 	//when:
@@ -480,7 +485,7 @@ TEST_F( M6502LoadRegisterTests, LDAIndirectXCanLoadAValueIntoTheARegister )
 	mem[0x0006] = 0x00;	//0x2 + 0x4
 	mem[0x0007] = 0x80;	
 	mem[0x8000] = 0x37;
-	constexpr s32 EXPECTED_CYCLES = 6;
+	const s32 EXPECTED_CYCLES = DecodeOpcode( CPU::INS_LDA_INDX ).Cycles;
 	CPU CPUCopy = cpu;
 
 	//when:
@@ -505,7 +510,7 @@ TEST_F( M6502LoadRegisterTests, LDAIndirectYCanLoadAValueIntoTheARegister )
 	mem[0x0002] = 0x00;	
 	mem[0x0003] = 0x80;
 	mem[0x8004] = 0x37;	//0x8000 + 0x4
-	constexpr s32 EXPECTED_CYCLES = 5;
+	const s32 EXPECTED_CYCLES = DecodeOpcode( CPU::INS_LDA_INDY ).Cycles;
 	CPU CPUCopy = cpu;
 
 	//when:
@@ -529,7 +534,7 @@ TEST_F( M6502LoadRegisterTests, LDAIndirectYCanLoadAValueIntoTheARegisterWhenItC
 	mem[0x0005] = 0xFF;
 	mem[0x0006] = 0x80;
 	mem[0x8100] = 0x37;	//0x80FF + 0x1
-	constexpr s32 EXPECTED_CYCLES = 6;
+	const s32 EXPECTED_CYCLES = DecodeOpcode( CPU::INS_LDA_INDY ).Cycles + DecodeOpcode( CPU::INS_LDA_INDY ).PageCrossCycles;
 	CPU CPUCopy = cpu;
 
 	//when:
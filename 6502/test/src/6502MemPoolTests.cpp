@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <vector>
+#include "m6502.h"
+#include "m6502_mempool.h"
+
+class M6502MemPoolTests : public testing::Test
+{
+public:
+	m6502::MemPool pool;
+
+	virtual void SetUp()
+	{
+	}
+
+	virtual void TearDown()
+	{
+	}
+};
+
+TEST_F( M6502MemPoolTests, SlabsAre64KBAlignedAndShareHugePages )
+{
+	// given:
+	using namespace m6502;
+	std::vector<Mem*> Machines;
+
+	//when:
+	for ( u32 i = 0; i < MemPool::SLABS_PER_HUGE_PAGE; i++ )
+	{
+		Machines.push_back( pool.Allocate( 0 ) );
+	}
+
+	//then:
+	EXPECT_EQ( pool.NumHugePages(), 1u );
+	EXPECT_EQ( pool.NumFree( 0 ), 0u );
+	for ( Mem* Memory : Machines )
+	{
+		ASSERT_NE( Memory, nullptr );
+		EXPECT_EQ( reinterpret_cast<uintptr_t>( Memory ) % MemPool::SLAB_SIZE, 0u );
+		EXPECT_EQ( pool.NodeOf( Memory ), 0u );
+	}
+	for ( Mem* Memory : Machines )
+	{
+		pool.Free( Memory );
+	}
+}
+
+TEST_F( M6502MemPoolTests, FreedSlabsAreReusedWithoutMappingMore )
+{
+	// given:
+	using namespace m6502;
+	Mem* First = pool.Allocate();
+	u32 HugePages = pool.NumHugePages();
+
+	//when:
+	pool.Free( First );
+	Mem* Second = pool.Allocate( pool.NodeOf( First ) );
+
+	//then:
+	EXPECT_EQ( Second, First );
+	EXPECT_EQ( pool.NumHugePages(), HugePages );
+	pool.Free( Second );
+}
+
+TEST_F( M6502MemPoolTests, APooledMemRunsPrograms )
+{
+	// given:
+	using namespace m6502;
+	Mem& mem = *pool.Allocate();
+	CPU cpu;
+	cpu.Reset( mem );
+	mem[0xFFFC] = CPU::INS_LDA_IM;
+	mem[0xFFFD] = 0x42;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( 2, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, 2 );
+	EXPECT_EQ( cpu.A, 0x42 );
+	pool.Free( &mem );
+}
+
+TEST_F( M6502MemPoolTests, TheCurrentNodeIsAKnownNode )
+{
+	// given:
+	using namespace m6502;
+
+	//when:
+	u32 Node = Numa::CurrentNode();
+
+	//then:
+	EXPECT_LT( Node, Numa::NumNodes() );
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include "m6502.h"
+#include "m6502_metrics.h"
+
+class M6502MetricsTests : public testing::Test
+{
+public:
+	m6502::Mem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		cpu.Reset( mem );
+		mem[0xFFFC] = m6502::CPU::INS_LDA_IM;
+		mem[0xFFFD] = 0x01;
+		mem[0xFFFE] = m6502::CPU::INS_JMP_ABS;
+		mem[0xFFFF] = 0x00;
+		mem[0x0000] = 0x80;
+		mem[0x8000] = m6502::CPU::INS_JMP_ABS;
+		mem[0x8001] = 0x00;
+		mem[0x8002] = 0x80;
+	}
+
+	virtual void TearDown()
+	{
+	}
+
+	// value of the sample that starts with Series, -1 if it is not in Dump
+	static long long Sample( const std::string& Dump, const std::string& Series )
+	{
+		size_t Found = Dump.find( Series + " " );
+		if ( Found == std::string::npos )
+		{
+			return -1;
+		}
+		return atoll( Dump.c_str() + Found + Series.size() + 1 );
+	}
+};
+
+TEST_F( M6502MetricsTests, ExecuteCountsIntoTheThreadsRow )
+{
+	// given:
+	using namespace m6502;
+	std::string Dump;
+
+	//when:
+	std::thread Worker( [this, &Dump]
+	{
+		Metrics::Global().NameThread( "metrics-test" );
+		cpu.Execute( 2 + 3 + 3 * 10, mem );
+		Dump = Metrics::Global().Format();
+	} );
+	Worker.join();
+
+	//then:
+	EXPECT_EQ( Sample( Dump, "m6502_worker_instructions_total{worker=\"metrics-test\"}" ), 12 );
+	EXPECT_EQ( Sample( Dump, "m6502_worker_cycles_total{worker=\"metrics-test\"}" ), 35 );
+	EXPECT_EQ( Sample( Dump, "m6502_worker_interrupts_total{worker=\"metrics-test\"}" ), 0 );
+	EXPECT_NE( Dump.find( "m6502_worker_emulated_mhz{worker=\"metrics-test\"}" ), std::string::npos );
+}
+
+TEST_F( M6502MetricsTests, MachineScopesCountInterruptsAndUnhandledOpcodes )
+{
+	// given:
+	using namespace m6502;
+	MetricsShard* Machine = Metrics::Global().AddMachine( "metrics-test-machine" );
+	mem[0xFFFE] = 0x80;
+	mem[0xFFFF] = 0x90;
+	mem[0x9080] = 0x02;		// not implemented
+	mem[0x8000] = CPU::INS_LDA_IM;
+	mem[0x8001] = 0x01;
+
+	//when:
+	{
+		MachineMetricsScope Scope( Machine );
+		cpu.Execute( 2, mem );
+		cpu.Interrupts.RaiseNMI();
+		cpu.Execute( 7, mem );
+		cpu.PC = 0x9080;
+		cpu.Execute( 1, mem );
+	}
+	cpu.PC = 0x8000;
+	cpu.Execute( 2, mem );
+	const std::string Dump = Metrics::Global().Format();
+	Metrics::Global().RemoveMachine( Machine );
+
+	//then:
+	EXPECT_EQ( Sample( Dump, "m6502_machine_instructions_total{machine=\"metrics-test-machine\"}" ), 2 );
+	EXPECT_EQ( Sample( Dump, "m6502_machine_cycles_total{machine=\"metrics-test-machine\"}" ), 10 );
+	EXPECT_EQ( Sample( Dump, "m6502_machine_interrupts_total{machine=\"metrics-test-machine\"}" ), 1 );
+	EXPECT_EQ( Sample( Dump, "m6502_machine_unhandled_opcodes_total{machine=\"metrics-test-machine\"}" ), 1 );
+	EXPECT_EQ( Sample( Metrics::Global().Format(), "m6502_machine_cycles_total{machine=\"metrics-test-machine\"}" ), -1 );
+}
+
+TEST_F( M6502MetricsTests, ExitedThreadsAreFoldedIntoTheRetiredRow )
+{
+	// given:
+	using namespace m6502;
+	std::thread( [] { Metrics::Global().NameThread( "metrics-warm-up" ); } ).join();
+	const long long Before = Sample( Metrics::Global().Format(), "m6502_worker_cycles_total{worker=\"retired\"}" );
+
+	//when:
+	std::thread( [this] { cpu.Execute( 100, mem ); } ).join();
+
+	//then:
+	const std::string Dump = Metrics::Global().Format();
+	EXPECT_EQ( Sample( Dump, "m6502_worker_cycles_total{worker=\"retired\"}" ), Before + 101 );
+}
+
+TEST_F( M6502MetricsTests, WriteFileReplacesTheDump )
+{
+	// given:
+	using namespace m6502;
+	const std::string Path = testing::TempDir() + "m6502_metrics_test.prom";
+	cpu.Execute( 5, mem );
+
+	//when:
+	bool Written = Metrics::Global().WriteFile( Path );
+
+	//then:
+	ASSERT_TRUE( Written );
+	FILE* File = fopen( Path.c_str(), "r" );
+	ASSERT_NE( File, nullptr );
+	char Line[256] = {};
+	EXPECT_NE( fgets( Line, sizeof( Line ), File ), nullptr );
+	EXPECT_STREQ( Line, "# HELP m6502_worker_instructions_total Instructions run by the interpreter.\n" );
+	fclose( File );
+	remove( Path.c_str() );
+}
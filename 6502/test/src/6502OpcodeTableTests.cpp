@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "m6502.h"
+#include "m6502_opcodes.h"
+
+namespace
+{
+	using namespace m6502;
+
+	enum class Timing
+	{
+		SamePage,		//indexed accesses stay in the page of their base
+		PageCross,		//indexed accesses cross into the next page
+		Decimal,		//as SamePage with the decimal flag set
+	};
+
+	// cycles the opcode table gives for Instruction
+	template<typename TVariant>
+	constexpr s32 TableCycles( Byte Instruction, Timing Scenario )
+	{
+		const OpcodeInfo Info = DecodeOpcode( Instruction, TVariant::HasCMOSInstructions );
+		s32 Cycles = Info.Cycles;
+		if ( Scenario == Timing::PageCross )
+		{
+			Cycles += Info.PageCrossCycles;
+		}
+		if ( TVariant::HasCMOSInstructions
+			&& ( Instruction == CPU::INS_JMP_IND || ( Scenario == Timing::Decimal && TVariant::HasDecimalMode ) ) )
+		{
+			Cycles += Info.CMOSExtraCycles;
+		}
+		return Cycles;
+	}
+
+	// cycles the interpreter takes for one Instruction at $8000
+	template<typename TVariant>
+	constexpr s32 InterpreterCycles( Mem& mem, Byte Instruction, Timing Scenario )
+	{
+		const Word Base = Scenario == Timing::PageCross ? 0x20FF : 0x2000;
+		mem[0x8000] = Instruction;
+		mem[0x8001] = Scenario == Timing::PageCross ? 0xFF : 0x40;	//zero page operand and pointer, or low byte of $20FF
+		mem[0x8002] = 0x20;
+		mem[0x40] = mem[0xFF] = Base & 0xFF;
+		mem[0x41] = mem[0x00] = Base >> 8;
+
+		CPU cpu;
+		cpu.PC = 0x8000;
+		cpu.SP = 0xF0;
+		cpu.A = 0x11;
+		cpu.X = 1;
+		cpu.Y = 1;
+		cpu.SetPS( 0 );
+		cpu.Flag.D = Scenario == Timing::Decimal;
+		return cpu.Execute<TVariant>( 1, mem );
+	}
+
+	// first opcode of the table whose timing differs from the interpreter's, -1 when they all agree
+	template<typename TVariant>
+	constexpr s32 FirstTimingMismatch( Timing Scenario )
+	{
+		Mem mem;
+		mem.Initialize();
+		for ( Byte Instruction : TABLE_OPCODES )
+		{
+			if ( DecodeOpcode( Instruction, TVariant::HasCMOSInstructions ).Mode == AddressMode::Unknown )
+			{
+				continue;
+			}
+			if ( InterpreterCycles<TVariant>( mem, Instruction, Scenario ) != TableCycles<TVariant>( Instruction, Scenario ) )
+			{
+				return Instruction;
+			}
+		}
+		return -1;
+	}
+
+	static_assert( FirstTimingMismatch<NMOS6502>( Timing::SamePage ) == -1 );
+	static_assert( FirstTimingMismatch<NMOS6502>( Timing::PageCross ) == -1 );
+	static_assert( FirstTimingMismatch<NMOS6502>( Timing::Decimal ) == -1 );
+	static_assert( FirstTimingMismatch<CMOS65C02>( Timing::SamePage ) == -1 );
+	static_assert( FirstTimingMismatch<CMOS65C02>( Timing::PageCross ) == -1 );
+	static_assert( FirstTimingMismatch<CMOS65C02>( Timing::Decimal ) == -1 );
+	static_assert( FirstTimingMismatch<Ricoh2A03>( Timing::Decimal ) == -1 );
+}
+
+class M6502OpcodeTableTests : public testing::TestWithParam<m6502::Byte>
+{
+public:
+	m6502::Mem mem;
+};
+
+// INS_ names of the table rows, for the test names
+static const char* OpcodeName( m6502::Byte Instruction )
+{
+#define M6502_OPCODE_NAME(Name, Opcode, ...) if ( Instruction == Opcode ) return #Name;
+	M6502_OPCODE_TABLE(M6502_OPCODE_NAME)
+#undef M6502_OPCODE_NAME
+	return "UNKNOWN";
+}
+
+TEST_P( M6502OpcodeTableTests, TheInterpreterTakesTheCyclesTheTableGives )
+{
+	// given:
+	using namespace m6502;
+	const Byte Instruction = GetParam();
+	const bool CMOSOnly = OPCODE_TABLE[Instruction].Set == OpcodeSet::CMOS;
+
+	for ( Timing Scenario : { Timing::SamePage, Timing::PageCross, Timing::Decimal } )
+	{
+		//when:
+		mem.Initialize();
+		s32 CMOSCycles = InterpreterCycles<CMOS65C02>( mem, Instruction, Scenario );
+
+		//then:
+		EXPECT_EQ( CMOSCycles, TableCycles<CMOS65C02>( Instruction, Scenario ) ) << OpcodeName( Instruction );
+		if ( !CMOSOnly )
+		{
+			mem.Initialize();
+			s32 NMOSCycles = InterpreterCycles<NMOS6502>( mem, Instruction, Scenario );
+			EXPECT_EQ( NMOSCycles, TableCycles<NMOS6502>( Instruction, Scenario ) ) << OpcodeName( Instruction );
+		}
+	}
+}
+
+TEST_P( M6502OpcodeTableTests, TheDecoderKnowsOpcodesOnlyOnTheVariantsThatHaveThem )
+{
+	// given:
+	using namespace m6502;
+	const Byte Instruction = GetParam();
+	const OpcodeInfo& Row = OPCODE_TABLE[Instruction];
+
+	//when:
+	OpcodeInfo NMOS = DecodeOpcode( Instruction );
+	OpcodeInfo CMOS = DecodeOpcode( Instruction, true );
+
+	//then:
+	EXPECT_STREQ( CMOS.Mnemonic, std::string( OpcodeName( Instruction ) ).substr( 0, 3 ).c_str() );
+	EXPECT_EQ( CMOS.Mode, Row.Mode );
+	EXPECT_EQ( NMOS.Mode, Row.Set == OpcodeSet::NMOS ? Row.Mode : AddressMode::Unknown );
+}
+
+INSTANTIATE_TEST_SUITE_P( Table, M6502OpcodeTableTests, testing::ValuesIn( m6502::TABLE_OPCODES ),
+	[]( const testing::TestParamInfo<m6502::Byte>& Info ) { return std::string( OpcodeName( Info.param ) ); } );
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include "m6502.h"
+#include "m6502_pacer.h"
+
+class M6502PacerTests : public testing::Test
+{
+public:
+	m6502::Mem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		using namespace m6502;
+		cpu.Reset( mem );
+		cpu.PC = 0x8000;
+		mem[0x8000] = CPU::INS_JMP_ABS;	//3 cycle loop
+		mem[0x8001] = 0x00;
+		mem[0x8002] = 0x80;
+	}
+
+	virtual void TearDown()
+	{
+	}
+};
+
+TEST_F( M6502PacerTests, RunsAtTheConfiguredClockRate )
+{
+	// given:
+	using namespace m6502;
+	PacerConfig Config;
+	Config.ClockHz = 1000000;
+	Config.SliceCycles = 1000;
+	Pacer pacer( Config );
+	constexpr u64 CYCLES = 20000;	//20ms at 1MHz
+
+	//when:
+	s64 Start = Pacer::Now();
+	u64 CyclesUsed = pacer.Execute( cpu, mem, CYCLES );
+	s64 Elapsed = Pacer::Now() - Start;
+
+	//then:
+	EXPECT_GE( CyclesUsed, CYCLES );
+	EXPECT_GE( Elapsed, 20000000 );	//only a lower bound, a loaded host may wake up late
+	EXPECT_EQ( pacer.Stats().Slices, 20u );
+	EXPECT_GE( pacer.Stats().MaxLate, 0 );
+}
+
+TEST_F( M6502PacerTests, SlicesEndOnTheTimelineDespiteOverruns )
+{
+	// given:
+	using namespace m6502;
+	PacerConfig Config;
+	Config.ClockHz = 2000000;
+	Config.SliceCycles = 1000;	//not a multiple of the 3 cycle loop
+	Pacer pacer( Config );
+
+	//when:
+	u64 CyclesUsed = pacer.Execute( cpu, mem, 2000 );
+
+	//then:
+	//the first slice runs over to 1002, so the second one only asks for 998 and ends at 2001 instead of 2004
+	EXPECT_EQ( CyclesUsed, 2001u );
+	EXPECT_EQ( pacer.Stats().Slices, 2u );
+}
+
+TEST_F( M6502PacerTests, FallingFarBehindRestartsTheTimeline )
+{
+	// given:
+	using namespace m6502;
+	PacerConfig Config;
+	Config.MaxLagNanoseconds = 1000000;
+	Pacer pacer( Config );
+	pacer.Execute( cpu, mem, 1000 );
+
+	//when:
+	timespec Stall = { 0, 5000000 };
+	nanosleep( &Stall, nullptr );
+	s64 Start = Pacer::Now();
+	pacer.Execute( cpu, mem, 2000 );
+	s64 Elapsed = Pacer::Now() - Start;
+
+	//then:
+	EXPECT_GE( pacer.Stats().Resyncs, 1u );
+	EXPECT_GE( Elapsed, 1000000 );	//the stall was not made up by running flat out
+}
+
+TEST_F( M6502PacerTests, ASliceThatIsNotPositiveFallsBackToTheDefault )
+{
+	// given:
+	using namespace m6502;
+	PacerConfig Config;
+	Config.ClockHz = 10000000;
+	Config.SliceCycles = 0;
+	Pacer pacer( Config );
+
+	//when:
+	u64 CyclesUsed = pacer.Execute( cpu, mem, 2000 );
+
+	//then:
+	EXPECT_GE( CyclesUsed, 2000u );
+	EXPECT_EQ( pacer.Stats().Slices, 2u );	//two slices of the default 1000 cycles
+}
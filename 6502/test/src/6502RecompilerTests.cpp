@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <string.h>
+#include "m6502.h"
+#include "m6502_recompiled.h"
+
+// generated at build time from data/recompiler_test.hex
+extern const m6502::RecompiledProgram RecompiledTest;
+
+class M6502RecompilerTests : public testing::Test
+{
+public:
+	m6502::Mem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		using namespace m6502;
+		cpu.Reset( mem );
+		//same bytes as data/recompiler_test.hex
+		static const Byte Program[] = {
+			0xA2, 0x05, 0xA9, 0x10, 0x20, 0x20, 0x80, 0x9D, 0x00, 0x02, 0xA4, 0x00,
+			0x38, 0x69, 0x01, 0x85, 0x00, 0xB6, 0x10, 0xE9, 0x03, 0x6C, 0x30, 0x80,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x18, 0x65, 0x00, 0x85, 0x01, 0xA9, 0x02, 0x85, 0x02, 0xB1, 0x01, 0x99,
+			0xFE, 0x01, 0x60, 0x00, 0x02, 0x80 };
+		memcpy( &mem.Data[0x8000], Program, sizeof( Program ) );
+		for ( u32 i = 0; i < 0x100; i++ )
+		{
+			mem[0x0200 + i] = static_cast<Byte>( i * 7 );
+		}
+		cpu.PC = 0x8000;
+	}
+
+	virtual void TearDown()
+	{
+	}
+
+	void ExpectSameState( const m6502::CPU& Expected, const m6502::Mem& ExpectedMem, const m6502::CPU& Actual, const m6502::Mem& ActualMem )
+	{
+		EXPECT_EQ( Actual.PC, Expected.PC );
+		EXPECT_EQ( Actual.SP, Expected.SP );
+		EXPECT_EQ( Actual.A, Expected.A );
+		EXPECT_EQ( Actual.X, Expected.X );
+		EXPECT_EQ( Actual.Y, Expected.Y );
+		EXPECT_EQ( Actual.GetPS(), Expected.GetPS() );
+		EXPECT_EQ( memcmp( ActualMem.Data, ExpectedMem.Data, sizeof( ActualMem.Data ) ), 0 );
+	}
+};
+
+TEST_F( M6502RecompilerTests, MatchesTheInterpreterForAnyCycleBudget )
+{
+	// given:
+	using namespace m6502;
+
+	for ( s32 Budget = 1; Budget < 600; Budget += 7 )
+	{
+		Mem InterpretedMem = mem;
+		CPU InterpretedCpu = cpu;
+		Mem RecompiledMem = mem;
+		CPU RecompiledCpu = cpu;
+
+		//when:
+		s32 InterpretedCycles = InterpretedCpu.Execute( Budget, InterpretedMem );
+		s32 RecompiledCycles = RecompiledTest.Execute( RecompiledCpu, RecompiledMem, Budget );
+
+		//then:
+		EXPECT_EQ( RecompiledCycles, InterpretedCycles );
+		ExpectSameState( InterpretedCpu, InterpretedMem, RecompiledCpu, RecompiledMem );
+	}
+}
+
+TEST_F( M6502RecompilerTests, CanStopAndResumeInsideABlock )
+{
+	// given:
+	using namespace m6502;
+	Mem InterpretedMem = mem;
+	CPU InterpretedCpu = cpu;
+	s32 InterpretedCycles = 0;
+	s32 RecompiledCycles = 0;
+
+	//when:
+	for ( int i = 0; i < 100; i++ )
+	{
+		InterpretedCycles += InterpretedCpu.Execute( 3, InterpretedMem );
+		RecompiledCycles += RecompiledTest.Execute( cpu, mem, 3 );
+	}
+
+	//then:
+	EXPECT_EQ( RecompiledCycles, InterpretedCycles );
+	ExpectSameState( InterpretedCpu, InterpretedMem, cpu, mem );
+}
+
+TEST_F( M6502RecompilerTests, ModifiedCodeRunsInTheInterpreter )
+{
+	// given:
+	using namespace m6502;
+	mem[0x8003] = 0x42;	//LDA #$42 instead of LDA #$10
+	mem[0x8021] = CPU::INS_ADC_IM;	//ADC #$00 instead of ADC $00
+	Mem InterpretedMem = mem;
+	CPU InterpretedCpu = cpu;
+
+	//when:
+	s32 InterpretedCycles = InterpretedCpu.Execute( 200, InterpretedMem );
+	s32 RecompiledCycles = RecompiledTest.Execute( cpu, mem, 200 );
+
+	//then:
+	EXPECT_EQ( RecompiledCycles, InterpretedCycles );
+	ExpectSameState( InterpretedCpu, InterpretedMem, cpu, mem );
+}
+
+TEST_F( M6502RecompilerTests, APendingIRQIsTakenAtTheSameInstruction )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFE] = 0x00;
+	mem[0xFFFF] = 0x80;
+	cpu.Flag.I = 0;
+	Mem InterpretedMem = mem;
+	CPU InterpretedCpu = cpu;
+
+	//when:
+	s32 InterpretedCycles = InterpretedCpu.Execute( 20, InterpretedMem );
+	InterpretedCpu.Interrupts.RaiseIRQ();
+	InterpretedCycles += InterpretedCpu.Execute( 30, InterpretedMem );
+	s32 RecompiledCycles = RecompiledTest.Execute( cpu, mem, 20 );
+	cpu.Interrupts.RaiseIRQ();
+	RecompiledCycles += RecompiledTest.Execute( cpu, mem, 30 );
+
+	//then:
+	EXPECT_EQ( RecompiledCycles, InterpretedCycles );
+	ExpectSameState( InterpretedCpu, InterpretedMem, cpu, mem );
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "m6502.h"
+#include "m6502_sanitizer.h"
+
+class M6502SanitizerTests : public testing::Test
+{
+public:
+	m6502::SanitizedMem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		cpu.Reset( mem );
+	}
+
+	virtual void TearDown()
+	{
+	}
+};
+
+TEST_F( M6502SanitizerTests, ReadingUnwrittenMemoryIsReportedWithThePC )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFC] = CPU::INS_LDA_ZP;
+	mem[0xFFFD] = 0x42;
+	mem[0xFFFE] = CPU::INS_LDA_IM;
+	mem[0xFFFF] = 0x01;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( 100, mem );
+
+	//then:
+	EXPECT_EQ( mem.Report.Kind, SanitizerReport::UNINITIALIZED_READ );
+	EXPECT_EQ( mem.Report.PC, 0xFFFC );
+	EXPECT_EQ( mem.Report.Address, 0x0042 );
+	EXPECT_EQ( CyclesUsed, 3 );
+	EXPECT_EQ( cpu.PC, 0xFFFE );
+}
+
+TEST_F( M6502SanitizerTests, WrittenMemoryReadsCleanly )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFF00] = CPU::INS_LDA_IM;
+	mem[0xFF01] = 0x37;
+	mem[0xFF02] = CPU::INS_STA_ZP;
+	mem[0xFF03] = 0x42;
+	mem[0xFF04] = CPU::INS_LDX_ZP;
+	mem[0xFF05] = 0x42;
+	mem[0xFF06] = CPU::INS_JSR;
+	mem[0xFF07] = 0x00;
+	mem[0xFF08] = 0xFE;
+	mem[0xFE00] = CPU::INS_RTS;
+	mem[0xFFFC] = CPU::INS_JMP_ABS;
+	mem[0xFFFD] = 0x00;
+	mem[0xFFFE] = 0xFF;
+	mem.MarkCode( 0xFE00, 0x200 );
+
+	//when:
+	cpu.Execute( 3 + 2 + 3 + 3 + 6 + 6, mem );
+
+	//then:
+	EXPECT_FALSE( mem.HasReport() );
+	EXPECT_EQ( cpu.X, 0x37 );
+	EXPECT_EQ( cpu.PC, 0xFF09 );
+}
+
+TEST_F( M6502SanitizerTests, RunawayRecursionIsAStackOverflow )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFC] = CPU::INS_JSR;
+	mem[0xFFFD] = 0xFC;
+	mem[0xFFFE] = 0xFF;
+
+	//when:
+	cpu.Execute( 10000, mem );
+
+	//then:
+	EXPECT_EQ( mem.Report.Kind, SanitizerReport::STACK_OVERFLOW );
+	EXPECT_EQ( mem.Report.PC, 0xFFFC );
+	EXPECT_EQ( mem.Report.Address, 0x0101 );
+}
+
+TEST_F( M6502SanitizerTests, ReturningFromAnEmptyStackIsAStackUnderflow )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFC] = CPU::INS_RTS;
+
+	//when:
+	cpu.Execute( 100, mem );
+
+	//then:
+	EXPECT_EQ( mem.Report.Kind, SanitizerReport::STACK_UNDERFLOW );
+	EXPECT_EQ( mem.Report.PC, 0xFFFC );
+	EXPECT_EQ( mem.Report.Address, 0x01FF );
+}
+
+TEST_F( M6502SanitizerTests, JumpingIntoDataIsReportedOnceCodeIsMarked )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFC] = CPU::INS_JMP_ABS;
+	mem[0xFFFD] = 0x00;
+	mem[0xFFFE] = 0x40;
+	mem[0x4000] = CPU::INS_LDA_IM;
+	mem[0x4001] = 0x01;
+	mem.MarkCode( 0xFF00, 0x100 );
+
+	//when:
+	cpu.Execute( 100, mem );
+
+	//then:
+	EXPECT_EQ( mem.Report.Kind, SanitizerReport::EXECUTE_NON_CODE );
+	EXPECT_EQ( mem.Report.PC, 0x4000 );
+	EXPECT_EQ( cpu.PC, 0x4000 );
+}
+
+TEST_F( M6502SanitizerTests, OnlyTheFirstReportIsKeptAndClearingItResumes )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFC] = CPU::INS_LDA_ZP;
+	mem[0xFFFD] = 0x10;
+	mem[0xFFFE] = CPU::INS_LDA_ZP;
+	mem[0xFFFF] = 0x20;
+	mem.HaltOnReport = false;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( 6, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, 6 );
+	EXPECT_EQ( mem.Report.Address, 0x0010 );
+	mem.ClearReport();
+	EXPECT_FALSE( mem.HasReport() );
+}
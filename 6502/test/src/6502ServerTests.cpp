@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "m6502_client.h"
+#include "m6502_server.h"
+
+class M6502ServerTests : public testing::Test
+{
+public:
+	m6502::ServerConfig config;
+	std::unique_ptr<m6502::EmulationServer> server;
+	std::thread serverThread;
+	m6502::EmulationClient client;
+
+	virtual void SetUp()
+	{
+		config.SocketPath = "/tmp/m6502_server_test_" + std::to_string( getpid() ) + ".sock";
+		config.NumWorkers = 2;
+		config.InitialSessions = 2;
+		config.MaxSessions = 2;
+		config.MetricsSocketPath = "/tmp/m6502_server_test_" + std::to_string( getpid() ) + ".metrics";
+		server.reset( new m6502::EmulationServer( config ) );
+		ASSERT_TRUE( server->Start() );
+		serverThread = std::thread( [this] { server->Run(); } );
+		ASSERT_TRUE( client.Connect( config.SocketPath ) );
+	}
+
+	virtual void TearDown()
+	{
+		client.Disconnect();
+		if ( serverThread.joinable() )
+		{
+			server->Stop();
+			serverThread.join();
+		}
+		server.reset();
+	}
+};
+
+TEST_F( M6502ServerTests, AClientCanLoadAndRunAProgram )
+{
+	// given:
+	using namespace m6502;
+	using namespace m6502::protocol;
+	const Byte Program[] = { CPU::INS_LDA_IM, 0x84, CPU::INS_STA_ZP, 0x42 };
+	u32 SessionId = 0;
+	ASSERT_EQ( client.OpenSession( SessionId ), Status::Ok );
+	ASSERT_EQ( client.LoadImage( SessionId, 0xFFFC, Program, sizeof( Program ) ), Status::Ok );
+
+	//when:
+	RunResponse Result = {};
+	Status Outcome = client.Run( SessionId, 2 + 3, Result );
+
+	//then:
+	EXPECT_EQ( Outcome, Status::Ok );
+	EXPECT_EQ( Result.CyclesUsed, 5 );
+	EXPECT_EQ( Result.Regs.A, 0x84 );
+	EXPECT_EQ( Result.Regs.PC, 0x0000 );	//0xFFFC + 4 wraps
+
+	Registers Regs = {};
+	std::vector<Byte> Memory;
+	EXPECT_EQ( client.Snapshot( SessionId, Regs, Memory ), Status::Ok );
+	ASSERT_EQ( Memory.size(), Mem::MAX_MEM );
+	EXPECT_EQ( Memory[0x0042], 0x84 );
+	EXPECT_EQ( Regs.A, 0x84 );
+}
+
+TEST_F( M6502ServerTests, ClosedSessionsAreResetAndReused )
+{
+	// given:
+	using namespace m6502;
+	using namespace m6502::protocol;
+	const Byte Program[] = { CPU::INS_LDX_IM, 0x37 };
+	u32 SessionId = 0;
+	ASSERT_EQ( client.OpenSession( SessionId ), Status::Ok );
+	client.LoadImage( SessionId, 0xFFFC, Program, sizeof( Program ) );
+	RunResponse Result = {};
+	client.Run( SessionId, 2, Result );
+
+	//when:
+	EXPECT_EQ( client.CloseSession( SessionId ), Status::Ok );
+	u32 NewSessionId = 0;
+	ASSERT_EQ( client.OpenSession( NewSessionId ), Status::Ok );
+
+	//then:
+	Registers Regs = {};
+	EXPECT_EQ( client.ReadState( NewSessionId, Regs ), Status::Ok );
+	EXPECT_EQ( Regs.X, 0 );
+	EXPECT_EQ( Regs.PC, 0xFFFC );
+	EXPECT_EQ( client.ReadState( 99, Regs ), Status::UnknownSession );
+}
+
+TEST_F( M6502ServerTests, ThePoolLimitsHowManySessionsAreOpen )
+{
+	// given:
+	using namespace m6502;
+	using namespace m6502::protocol;
+	EmulationClient OtherClient;
+	ASSERT_TRUE( OtherClient.Connect( config.SocketPath ) );
+	u32 First = 0, Second = 0, Third = 0;
+
+	//when:
+	Status FirstResult = client.OpenSession( First );
+	Status SecondResult = OtherClient.OpenSession( Second );
+	Status ThirdResult = client.OpenSession( Third );
+
+	//then:
+	EXPECT_EQ( FirstResult, Status::Ok );
+	EXPECT_EQ( SecondResult, Status::Ok );
+	EXPECT_EQ( ThirdResult, Status::NoSessions );
+
+	// a disconnecting client gives its sessions back
+	OtherClient.Disconnect();
+	Status Retry = Status::NoSessions;
+	for ( int i = 0; i < 100 && Retry != Status::Ok; i++ )
+	{
+		Retry = client.OpenSession( Third );
+		if ( Retry != Status::Ok )
+		{
+			usleep( 1000 );
+		}
+	}
+	EXPECT_EQ( Retry, Status::Ok );
+}
+
+TEST_F( M6502ServerTests, SessionsMadeOnSeveralThreadsAtOnceStayWithinTheLimit )
+{
+	// given:
+	using namespace m6502;
+	SessionPool Pool( 0, 4 );
+	std::atomic<u32> Acquired{ 0 };
+	std::vector<std::thread> Threads;
+
+	//when:
+	for ( u32 i = 0; i < 8; i++ )
+	{
+		Threads.emplace_back( [&Pool, &Acquired] { Acquired += Pool.Acquire() != nullptr ? 1 : 0; } );
+	}
+	for ( std::thread& Thread : Threads )
+	{
+		Thread.join();
+	}
+
+	//then:
+	EXPECT_EQ( Acquired.load(), 4u );
+	EXPECT_EQ( Pool.NumFree(), 0u );
+}
+
+TEST_F( M6502ServerTests, TheMetricsSocketDumpsPerSessionCounters )
+{
+	// given:
+	using namespace m6502;
+	using namespace m6502::protocol;
+	const Byte Program[] = { CPU::INS_LDA_IM, 0x01, CPU::INS_LDA_IM, 0x02 };
+	u32 SessionId = 0;
+	ASSERT_EQ( client.OpenSession( SessionId ), Status::Ok );
+	client.LoadImage( SessionId, 0xFFFC, Program, sizeof( Program ) );
+	RunResponse Result = {};
+	ASSERT_EQ( client.Run( SessionId, 4, Result ), Status::Ok );
+
+	//when:
+	int Fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+	sockaddr_un Address = {};
+	Address.sun_family = AF_UNIX;
+	strcpy( Address.sun_path, config.MetricsSocketPath.c_str() );
+	ASSERT_EQ( connect( Fd, reinterpret_cast<sockaddr*>( &Address ), sizeof( Address ) ), 0 );
+	std::string Dump;
+	char Buffer[4096];
+	ssize_t Received;
+	while ( ( Received = read( Fd, Buffer, sizeof( Buffer ) ) ) > 0 )
+	{
+		Dump.append( Buffer, Received );
+	}
+	close( Fd );
+
+	//then:
+	EXPECT_NE( Dump.find( "# TYPE m6502_machine_cycles_total counter" ), std::string::npos );
+	EXPECT_NE( Dump.find( "worker=\"node0-worker" ), std::string::npos );
+	EXPECT_NE( Dump.find( "m6502_machine_instructions_total{machine=\"session-" ), std::string::npos );
+	EXPECT_NE( Dump.find( "\"} 2\n" ), std::string::npos );
+}
+
+TEST_F( M6502ServerTests, RequestsSentAheadAreAnsweredInOrder )
+{
+	// given:
+	using namespace m6502;
+	using namespace m6502::protocol;
+	u32 SessionId = 0;
+	ASSERT_EQ( client.OpenSession( SessionId ), Status::Ok );
+	int Fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+	sockaddr_un Address = {};
+	Address.sun_family = AF_UNIX;
+	strcpy( Address.sun_path, config.SocketPath.c_str() );
+	ASSERT_EQ( connect( Fd, reinterpret_cast<sockaddr*>( &Address ), sizeof( Address ) ), 0 );
+	constexpr u32 NUM_REQUESTS = 200;
+
+	//when: a burst of requests the server reads only one at a time
+	std::vector<Byte> Burst;
+	for ( u32 i = 0; i < NUM_REQUESTS; i++ )
+	{
+		RequestHeader Header = {};
+		Header.SessionId = i + 1;	//none of them exist on this connection
+		Header.Cmd = Command::ReadState;
+		const Byte* Bytes = reinterpret_cast<const Byte*>( &Header );
+		Burst.insert( Burst.end(), Bytes, Bytes + sizeof( Header ) );
+	}
+	ASSERT_EQ( write( Fd, Burst.data(), Burst.size() ), static_cast<ssize_t>( Burst.size() ) );
+
+	//then:
+	for ( u32 i = 0; i < NUM_REQUESTS; i++ )
+	{
+		ResponseHeader Header = {};
+		size_t Received = 0;
+		while ( Received < sizeof( Header ) )
+		{
+			const ssize_t Part = read( Fd, reinterpret_cast<Byte*>( &Header ) + Received, sizeof( Header ) - Received );
+			ASSERT_GT( Part, 0 );
+			Received += Part;
+		}
+		EXPECT_EQ( Header.SessionId, i + 1 );
+		EXPECT_EQ( Header.Result, Status::UnknownSession );
+	}
+	close( Fd );
+	RunResponse Result = {};
+	EXPECT_EQ( client.Run( SessionId, 0, Result ), Status::Ok );
+}
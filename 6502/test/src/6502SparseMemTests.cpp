@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include "m6502.h"
+#include "m6502_rom.h"
+#include "m6502_sparsemem.h"
+
+class M6502SparseMemTests : public testing::Test
+{
+public:
+	m6502::SparseMem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		cpu.Reset( mem );
+	}
+
+	virtual void TearDown()
+	{
+	}
+};
+
+TEST_F( M6502SparseMemTests, UnwrittenMemoryReadsAsZeroWithoutAllocating )
+{
+	//given:
+	using namespace m6502;
+	const SparseMem& ReadOnly = mem;
+
+	//when:
+	Byte Value = ReadOnly[0x1234];
+
+	//then:
+	EXPECT_EQ( Value, 0 );
+	EXPECT_EQ( mem.NumAllocatedPages(), 0u );
+}
+
+TEST_F( M6502SparseMemTests, WritingAByteOnlyAllocatesItsPage )
+{
+	//given:
+	using namespace m6502;
+
+	//when:
+	mem[0x1234] = 0x42;
+	mem[0x12FF] = 0x43;
+
+	//then:
+	EXPECT_EQ( mem.Read( 0x1234 ), 0x42 );
+	EXPECT_EQ( mem.Read( 0x12FF ), 0x43 );
+	EXPECT_EQ( mem.Read( 0x1334 ), 0 );
+	EXPECT_EQ( mem.NumAllocatedPages(), 1u );
+}
+
+TEST_F( M6502SparseMemTests, ResetGivesThePagesBackAndClearsMemory )
+{
+	//given:
+	using namespace m6502;
+	mem[0x0042] = 0x37;
+	mem[0x4480] = 0x37;
+
+	//when:
+	cpu.Reset( mem );
+
+	//then:
+	EXPECT_EQ( mem.Read( 0x0042 ), 0 );
+	EXPECT_EQ( mem.Read( 0x4480 ), 0 );
+	EXPECT_EQ( mem.NumAllocatedPages(), 0u );
+}
+
+TEST_F( M6502SparseMemTests, TheCPUCanLoadAndStoreThroughSparseMemory )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFC] = CPU::INS_LDA_ZP;
+	mem[0xFFFD] = 0x42;
+	mem[0xFFFE] = CPU::INS_STA_ABS;
+	mem[0xFFFF] = 0x00;
+	mem[0x0000] = 0x80;	//0x8000
+	mem[0x0042] = 0x37;
+	constexpr s32 EXPECTED_CYCLES = 3 + 4;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( EXPECTED_CYCLES, mem );
+
+	//then:
+	EXPECT_EQ( cpu.A, 0x37 );
+	EXPECT_EQ( mem.Read( 0x8000 ), 0x37 );
+	EXPECT_EQ( CyclesUsed, EXPECTED_CYCLES );
+	EXPECT_EQ( mem.NumAllocatedPages(), 3u );
+}
+
+TEST_F( M6502SparseMemTests, ARomImageCanBeSharedBetweenMachines )
+{
+	//given:
+	using namespace m6502;
+	const Byte Firmware[] = { CPU::INS_LDA_IM, 0x37 };
+	std::shared_ptr<const RomImage> Rom = RomImage::Create( Firmware, sizeof( Firmware ) );
+	SparseMem OtherMem;
+
+	//when:
+	const bool Mapped = mem.MapRom( Rom, 0xFF00 );
+	const bool OtherMapped = OtherMem.MapRom( Rom, 0xFF00 );
+
+	//then:
+	EXPECT_TRUE( Mapped );
+	EXPECT_TRUE( OtherMapped );
+	EXPECT_EQ( mem.Read( 0xFF01 ), 0x37 );
+	EXPECT_EQ( OtherMem.Read( 0xFF01 ), 0x37 );
+	EXPECT_EQ( mem.NumAllocatedPages(), 0u );
+	EXPECT_EQ( Rom.use_count(), 3 );
+}
+
+TEST_F( M6502SparseMemTests, WritesToRomAreIgnored )
+{
+	//given:
+	using namespace m6502;
+	const Byte Firmware[] = { 0x11, 0x22 };
+	mem.MapRom( RomImage::Create( Firmware, sizeof( Firmware ) ), 0xC000 );
+
+	//when:
+	mem.Write( 0xC000, 0x99 );
+	mem[0xC001] = 0x99;
+
+	//then:
+	EXPECT_EQ( mem.Read( 0xC000 ), 0x11 );
+	EXPECT_EQ( mem.Read( 0xC001 ), 0x22 );
+	EXPECT_EQ( mem.NumAllocatedPages(), 0u );
+}
+
+TEST_F( M6502SparseMemTests, RomStaysMappedWhenTheCPUIsReset )
+{
+	// given:
+	using namespace m6502;
+	const Byte Firmware[] = { CPU::INS_LDA_IM, 0x84 };
+	mem.MapRom( RomImage::Create( Firmware, sizeof( Firmware ) ), 0xFF00 );
+	mem[0xFFFC] = 0x99;	//padding inside the rom page, dropped
+
+	//when:
+	cpu.Reset( mem );
+	cpu.PC = 0xFF00;
+	s32 CyclesUsed = cpu.Execute( 2, mem );
+
+	//then:
+	EXPECT_EQ( cpu.A, 0x84 );
+	EXPECT_EQ( CyclesUsed, 2 );
+	EXPECT_EQ( mem.Read( 0xFFFC ), 0 );
+}
+
+TEST_F( M6502SparseMemTests, ARomThatDoesNotFitIsNotMapped )
+{
+	// given:
+	using namespace m6502;
+	const Byte Firmware[0x200] = { 0x11 };
+	std::shared_ptr<const RomImage> Rom = RomImage::Create( Firmware, sizeof( Firmware ) );
+
+	//when:
+	const bool Misaligned = mem.MapRom( Rom, 0xC001 );
+	const bool PastTheEnd = mem.MapRom( Rom, 0xFF00 );
+
+	//then:
+	EXPECT_FALSE( Misaligned );
+	EXPECT_FALSE( PastTheEnd );
+	EXPECT_EQ( mem.Read( 0xFF00 ), 0 );
+	EXPECT_EQ( Rom.use_count(), 1 );
+}
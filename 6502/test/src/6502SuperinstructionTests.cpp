@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "m6502.h"
+#include "m6502_profile.h"
+#include "m6502_superinstructions.h"
+
+// generated at build time from data/superinstructions_test.profile
+extern const m6502::Superinstructions FusedTest;
+
+class M6502SuperinstructionTests : public testing::Test
+{
+public:
+	m6502::Mem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		cpu.Reset( mem );
+	}
+
+	virtual void TearDown()
+	{
+	}
+
+	void ExpectSameState( const m6502::CPU& Expected, const m6502::Mem& ExpectedMem, const m6502::CPU& Actual, const m6502::Mem& ActualMem )
+	{
+		EXPECT_EQ( Actual.PC, Expected.PC );
+		EXPECT_EQ( Actual.SP, Expected.SP );
+		EXPECT_EQ( Actual.A, Expected.A );
+		EXPECT_EQ( Actual.X, Expected.X );
+		EXPECT_EQ( Actual.Y, Expected.Y );
+		EXPECT_EQ( Actual.GetPS(), Expected.GetPS() );
+		EXPECT_EQ( memcmp( ActualMem.Data, ExpectedMem.Data, sizeof( ActualMem.Data ) ), 0 );
+	}
+
+	// lays the sequence out in random memory the way execution will reach it, false if it does not fit
+	bool BuildSequence( const m6502::Superinstructions::Sequence& Fused, std::mt19937& Random )
+	{
+		using namespace m6502;
+		for ( u32 i = 0; i < Mem::MAX_MEM; i++ )
+		{
+			mem[i] = static_cast<Byte>( Random() );
+		}
+		cpu.PC = static_cast<Word>( Random() );
+		cpu.SP = static_cast<Byte>( Random() );
+		cpu.A = static_cast<Byte>( Random() );
+		cpu.X = static_cast<Byte>( Random() );
+		cpu.Y = static_cast<Byte>( Random() );
+		cpu.SetPS( static_cast<Byte>( Random() ) );
+
+		std::vector<bool> Placed( Mem::MAX_MEM, false );
+		Mem Scratch = mem;
+		CPU ScratchCpu = cpu;
+		for ( u32 Op = 0; Op < Fused.Length; Op++ )
+		{
+			if ( Placed[ScratchCpu.PC] )
+			{
+				return false;
+			}
+			mem[ScratchCpu.PC] = Fused.Opcodes[Op];
+			Scratch[ScratchCpu.PC] = Fused.Opcodes[Op];
+			Placed[ScratchCpu.PC] = true;
+			ScratchCpu.Execute( 1, Scratch );
+		}
+		if ( Placed[ScratchCpu.PC] )
+		{
+			return false;
+		}
+		mem[ScratchCpu.PC] = CPU::INS_BRK;	//never fused, ends the sequence
+
+		//stores in the sequence may have overwritten the code after them
+		Scratch = mem;
+		ScratchCpu = cpu;
+		for ( u32 Op = 0; Op < Fused.Length; Op++ )
+		{
+			if ( Scratch[ScratchCpu.PC] != Fused.Opcodes[Op] )
+			{
+				return false;
+			}
+			ScratchCpu.Execute( 1, Scratch );
+		}
+		return Scratch[ScratchCpu.PC] == CPU::INS_BRK;
+	}
+};
+
+TEST_F( M6502SuperinstructionTests, TheHottestFusibleSequencesAreGenerated )
+{
+	// given:
+	using namespace m6502;
+
+	//when:
+	auto IsFused = []( u32 Length, Byte A, Byte B, Byte C )
+	{
+		for ( u32 i = 0; i < FusedTest.NumSequences; i++ )
+		{
+			const Superinstructions::Sequence& Fused = FusedTest.Sequences[i];
+			if ( Fused.Length == Length && Fused.Opcodes[0] == A && Fused.Opcodes[1] == B && ( Length == 2 || Fused.Opcodes[2] == C ) )
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+
+	//then:
+	EXPECT_TRUE( IsFused( 2, CPU::INS_LDA_IM, CPU::INS_STA_ZP, 0 ) );
+	EXPECT_TRUE( IsFused( 2, CPU::INS_LDX_ZP, CPU::INS_LDY_ZP, 0 ) );
+	EXPECT_TRUE( IsFused( 2, CPU::INS_JSR, CPU::INS_RTS, 0 ) );
+	EXPECT_TRUE( IsFused( 3, CPU::INS_LDA_IM, CPU::INS_STA_ZP, CPU::INS_JSR ) );
+	EXPECT_FALSE( IsFused( 2, CPU::INS_BRK, CPU::INS_LDA_IM, 0 ) );
+	EXPECT_FALSE( IsFused( 3, CPU::INS_JMP_IND, 0x30, 0x80 ) );
+	EXPECT_NE( FusedTest.Handlers[CPU::INS_LDA_IM], nullptr );
+	EXPECT_EQ( FusedTest.Handlers[CPU::INS_BRK], nullptr );
+}
+
+TEST_F( M6502SuperinstructionTests, EveryFusedSequenceMatchesTheUnfusedInstructions )
+{
+	// given:
+	using namespace m6502;
+	std::mt19937 Random( 6502 );
+	ASSERT_GT( FusedTest.NumSequences, 0u );
+
+	for ( u32 i = 0; i < FusedTest.NumSequences; i++ )
+	{
+		const Superinstructions::Sequence& Fused = FusedTest.Sequences[i];
+		u32 Built = 0;
+		for ( u32 Attempt = 0; Attempt < 200 && Built < 20; Attempt++ )
+		{
+			if ( !BuildSequence( Fused, Random ) )
+			{
+				continue;
+			}
+			Built++;
+
+			for ( s32 Budget = 1; Budget <= 24; Budget++ )
+			{
+				Mem UnfusedMem = mem;
+				CPU UnfusedCpu = cpu;
+				Mem FusedMem = mem;
+				CPU FusedCpu = cpu;
+
+				//when:
+				s32 UnfusedLeft = Budget;
+				for ( u32 Op = 0; Op < Fused.Length && UnfusedLeft > 0; Op++ )
+				{
+					UnfusedLeft -= UnfusedCpu.Execute( 1, UnfusedMem );
+				}
+				s32 FusedLeft = Budget;
+				FusedTest.Handlers[Fused.Opcodes[0]]( FusedCpu, FusedMem, FusedLeft );
+
+				//then:
+				ASSERT_EQ( FusedLeft, UnfusedLeft ) << "sequence " << i << " budget " << Budget;
+				ExpectSameState( UnfusedCpu, UnfusedMem, FusedCpu, FusedMem );
+			}
+		}
+		EXPECT_GT( Built, 0u ) << "sequence " << i;
+	}
+}
+
+TEST_F( M6502SuperinstructionTests, ExecuteMatchesTheInterpreterOnALoop )
+{
+	// given:
+	using namespace m6502;
+	static const Byte Program[] = {
+		0xA9, 0x07,			//8000 LDA #$07
+		0x85, 0x10,			//8002 STA $10
+		0x20, 0x10, 0x80,	//8004 JSR $8010
+		0xA6, 0x10,			//8007 LDX $10
+		0xA4, 0x11,			//8009 LDY $11
+		0x4C, 0x00, 0x80,	//800B JMP $8000
+		0x00, 0x00,
+		0x18,				//8010 CLC
+		0x69, 0x03,			//8011 ADC #$03
+		0x85, 0x11,			//8013 STA $11
+		0x60 };				//8015 RTS
+	memcpy( &mem.Data[0x8000], Program, sizeof( Program ) );
+	cpu.PC = 0x8000;
+	Mem InterpretedMem = mem;
+	CPU InterpretedCpu = cpu;
+
+	//when:
+	s32 InterpretedCycles = 0;
+	s32 FusedCycles = 0;
+	for ( int i = 0; i < 50; i++ )
+	{
+		InterpretedCycles += InterpretedCpu.Execute( 5, InterpretedMem );
+		FusedCycles += FusedTest.Execute( cpu, mem, 5 );
+	}
+
+	//then:
+	EXPECT_EQ( FusedCycles, InterpretedCycles );
+	ExpectSameState( InterpretedCpu, InterpretedMem, cpu, mem );
+}
+
+TEST_F( M6502SuperinstructionTests, ProfileCountsOpcodesInExecutionOrder )
+{
+	// given:
+	using namespace m6502;
+	mem[0x8000] = CPU::INS_LDA_IM;
+	mem[0x8001] = 0x01;
+	mem[0x8002] = CPU::INS_STA_ZP;
+	mem[0x8003] = 0x10;
+	mem[0x8004] = CPU::INS_JMP_ABS;
+	mem[0x8005] = 0x00;
+	mem[0x8006] = 0x80;
+	cpu.PC = 0x8000;
+	OpcodeProfile Profile;
+	constexpr s32 CYCLES_PER_LOOP = 2 + 3 + 3;
+
+	//when:
+	s32 CyclesUsed = Profile.Execute( cpu, mem, CYCLES_PER_LOOP * 10 );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, CYCLES_PER_LOOP * 10 );
+	EXPECT_EQ( Profile.PairCount( CPU::INS_LDA_IM, CPU::INS_STA_ZP ), 10u );
+	EXPECT_EQ( Profile.PairCount( CPU::INS_JMP_ABS, CPU::INS_LDA_IM ), 9u );
+	EXPECT_EQ( Profile.TripleCount( CPU::INS_LDA_IM, CPU::INS_STA_ZP, CPU::INS_JMP_ABS ), 10u );
+	EXPECT_EQ( Profile.TripleCount( CPU::INS_STA_ZP, CPU::INS_JMP_ABS, CPU::INS_LDA_IM ), 9u );
+}
+
+TEST_F( M6502SuperinstructionTests, LoadingProfilesAddsTheirCounts )
+{
+	// given:
+	using namespace m6502;
+	OpcodeProfile Recorded;
+	Recorded.Record( CPU::INS_LDX_ZP );
+	Recorded.Record( CPU::INS_LDY_ZP );
+	Recorded.Record( CPU::INS_RTS );
+	const std::string Path = testing::TempDir() + "m6502_profile_test.txt";
+	ASSERT_TRUE( Recorded.Save( Path.c_str() ) );
+	OpcodeProfile Merged;
+
+	//when:
+	bool Loaded = Merged.Load( Path.c_str() ) && Merged.Load( Path.c_str() );
+	remove( Path.c_str() );
+
+	//then:
+	EXPECT_TRUE( Loaded );
+	EXPECT_EQ( Merged.PairCount( CPU::INS_LDX_ZP, CPU::INS_LDY_ZP ), 2u );
+	EXPECT_EQ( Merged.PairCount( CPU::INS_LDY_ZP, CPU::INS_RTS ), 2u );
+	EXPECT_EQ( Merged.TripleCount( CPU::INS_LDX_ZP, CPU::INS_LDY_ZP, CPU::INS_RTS ), 2u );
+}
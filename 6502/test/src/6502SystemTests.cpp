@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "m6502.h"
+#include "m6502_system.h"
+
+class M6502SystemTests : public testing::Test
+{
+public:
+	m6502::System system;
+
+	virtual void SetUp()
+	{
+		for ( m6502::u32 i = 0; i < system.NumCores(); i++ )
+		{
+			m6502::System::Core& Core = system.GetCore( i );
+			Core.cpu.Reset( Core.memory );
+			Core.cpu.PC = 0x8000;
+		}
+	}
+
+	virtual void TearDown()
+	{
+	}
+
+	void Load( m6502::u32 CoreIndex, m6502::Word Address, std::initializer_list<m6502::Byte> Bytes )
+	{
+		for ( m6502::Byte Value : Bytes )
+		{
+			system.GetCore( CoreIndex ).memory.Write( Address++, Value );
+		}
+	}
+};
+
+TEST_F( M6502SystemTests, ACoreSeesTheOtherCoresWritesToSharedMemory )
+{
+	// given:
+	using namespace m6502;
+	std::shared_ptr<SharedRegion> Mailbox = system.MapShared( 0x0300, 1 );
+	Mailbox->Write( 0, 0x00 );
+	Mailbox->Write( 1, 0x80 );	//core 1 jumps through 0x0300, which points at itself
+	Load( 0, 0x8000, {
+		CPU::INS_LDA_IM, 0x10,
+		CPU::INS_STA_ABS, 0x00, 0x03,
+		CPU::INS_JMP_ABS, 0x05, 0x80 } );
+	Load( 1, 0x8000, { CPU::INS_JMP_IND, 0x00, 0x03 } );
+	Load( 1, 0x8010, {
+		CPU::INS_LDA_IM, 0xAA,
+		CPU::INS_STA_ABS, 0x00, 0x04,
+		CPU::INS_JMP_ABS, 0x15, 0x80 } );
+
+	//when:
+	system.Run( 10000 );
+
+	//then:
+	EXPECT_EQ( system.GetCore( 1 ).cpu.PC, 0x8015 );
+	EXPECT_EQ( system.GetCore( 1 ).memory.Read( 0x0400 ), 0xAA );
+	EXPECT_EQ( system.GetCore( 0 ).memory.Read( 0x0400 ), 0x00 );
+	EXPECT_EQ( system.GetCore( 0 ).memory.Read( 0x0300 ), 0x10 );
+	EXPECT_TRUE( system.GetCore( 0 ).memory.IsShared( 0x03FF ) );
+	EXPECT_FALSE( system.GetCore( 0 ).memory.IsShared( 0x0400 ) );
+}
+
+TEST_F( M6502SystemTests, EveryCoreRunsTheRequestedCycles )
+{
+	// given:
+	using namespace m6502;
+	constexpr u64 CYCLES = 100000;
+	for ( u32 i = 0; i < system.NumCores(); i++ )
+	{
+		Load( i, 0x8000, { CPU::INS_LDA_IM, static_cast<Byte>( i ), CPU::INS_STA_ZP, 0x20, CPU::INS_JMP_ABS, 0x00, 0x80 } );
+	}
+
+	//when:
+	system.Run( CYCLES );
+	system.Run( CYCLES );
+
+	//then:
+	for ( u32 i = 0; i < system.NumCores(); i++ )
+	{
+		u64 CyclesRun = system.GetCore( i ).CyclesRun.load();
+		EXPECT_GE( CyclesRun, 2 * CYCLES );
+		EXPECT_LT( CyclesRun, 2 * CYCLES + 2 * 8 );	//at most one instruction over per run
+		EXPECT_EQ( system.GetCore( i ).memory.Read( 0x20 ), i );
+	}
+}
+
+TEST_F( M6502SystemTests, ResettingACoreKeepsSharedMemory )
+{
+	// given:
+	using namespace m6502;
+	std::shared_ptr<SharedRegion> Window = system.MapShared( 0x2000, 2 );
+	system.GetCore( 0 ).memory.Write( 0x21FF, 0x42 );
+	system.GetCore( 0 ).memory.Write( 0x1000, 0x24 );
+
+	//when:
+	system.GetCore( 0 ).cpu.Reset( system.GetCore( 0 ).memory );
+
+	//then:
+	EXPECT_EQ( Window->Read( 0x1FF ), 0x42 );
+	EXPECT_EQ( system.GetCore( 1 ).memory.Read( 0x21FF ), 0x42 );
+	EXPECT_EQ( system.GetCore( 0 ).memory.Read( 0x1000 ), 0x00 );
+}
+
+TEST_F( M6502SystemTests, ASharedRegionThatDoesNotFitIsNotCreated )
+{
+	// given:
+	using namespace m6502;
+
+	//when:
+	std::shared_ptr<SharedRegion> Misaligned = system.MapShared( 0x2080, 1 );
+	std::shared_ptr<SharedRegion> PastTheEnd = system.MapShared( 0xFF00, 2 );
+
+	//then:
+	EXPECT_EQ( Misaligned, nullptr );
+	EXPECT_EQ( PastTheEnd, nullptr );
+	EXPECT_FALSE( system.GetCore( 0 ).memory.IsShared( 0x2080 ) );
+	EXPECT_FALSE( system.GetCore( 1 ).memory.IsShared( 0xFF00 ) );
+}
+
+TEST_F( M6502SystemTests, AQuantumThatIsNotPositiveFallsBackToTheDefault )
+{
+	// given:
+	using namespace m6502;
+	SystemConfig Config;
+	Config.NumCores = 1;
+	Config.Quantum = 0;
+	System Zero( Config );
+	System::Core& Core = Zero.GetCore( 0 );
+	Core.cpu.Reset( Core.memory );
+	Core.cpu.PC = 0x8000;
+	Core.memory.Write( 0x8000, CPU::INS_JMP_ABS );
+	Core.memory.Write( 0x8001, 0x00 );
+	Core.memory.Write( 0x8002, 0x80 );
+
+	//when:
+	Zero.Run( 1000 );
+
+	//then:
+	EXPECT_GE( Core.CyclesRun.load(), 1000u );
+}
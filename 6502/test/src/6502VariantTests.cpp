@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include "m6502.h"
+
+class M6502VariantTests : public testing::Test
+{
+public:
+	m6502::Mem mem;
+	m6502::CPU cpu;
+
+	virtual void SetUp()
+	{
+		cpu.Reset( mem );
+	}
+
+	virtual void TearDown()
+	{
+	}
+};
+
+TEST_F( M6502VariantTests, ADCAddsTheCarryAndSetsOverflow )
+{
+	// given:
+	using namespace m6502;
+	cpu.A = 0x7F;
+	cpu.Flag.C = 1;
+	mem[0xFFFC] = CPU::INS_ADC_IM;
+	mem[0xFFFD] = 0x00;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( 2, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, 2 );
+	EXPECT_EQ( cpu.A, 0x80 );
+	EXPECT_TRUE( cpu.Flag.V );
+	EXPECT_TRUE( cpu.Flag.N );
+	EXPECT_FALSE( cpu.Flag.C );
+	EXPECT_FALSE( cpu.Flag.Z );
+}
+
+TEST_F( M6502VariantTests, SBCBorrowsWhenTheCarryIsClear )
+{
+	// given:
+	using namespace m6502;
+	cpu.A = 0x10;
+	cpu.Flag.C = 0;
+	mem[0xFFFC] = CPU::INS_SBC_ZP;
+	mem[0xFFFD] = 0x42;
+	mem[0x0042] = 0x10;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( 3, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, 3 );
+	EXPECT_EQ( cpu.A, 0xFF );
+	EXPECT_FALSE( cpu.Flag.C );
+	EXPECT_TRUE( cpu.Flag.N );
+}
+
+TEST_F( M6502VariantTests, NMOSAddsInDecimalModeButThe2A03DoesNot )
+{
+	// given:
+	using namespace m6502;
+	cpu.A = 0x19;
+	cpu.Flag.D = 1;
+	mem[0xFFFC] = CPU::INS_ADC_IM;
+	mem[0xFFFD] = 0x01;
+	CPU NESCpu = cpu;
+
+	//when:
+	cpu.Execute<NMOS6502>( 2, mem );
+	NESCpu.Execute<Ricoh2A03>( 2, mem );
+
+	//then:
+	EXPECT_EQ( cpu.A, 0x20 );
+	EXPECT_EQ( NESCpu.A, 0x1A );
+}
+
+TEST_F( M6502VariantTests, DecimalSubtractionWithBorrow )
+{
+	// given:
+	using namespace m6502;
+	cpu.A = 0x20;
+	cpu.Flag.D = 1;
+	cpu.Flag.C = 1;
+	mem[0xFFFC] = CPU::INS_SBC_IM;
+	mem[0xFFFD] = 0x01;
+
+	//when:
+	cpu.Execute( 2, mem );
+
+	//then:
+	EXPECT_EQ( cpu.A, 0x19 );
+	EXPECT_TRUE( cpu.Flag.C );
+}
+
+TEST_F( M6502VariantTests, The65C02TakesAnExtraCycleForDecimalADC )
+{
+	// given:
+	using namespace m6502;
+	cpu.A = 0x58;
+	cpu.Flag.D = 1;
+	mem[0xFFFC] = CPU::INS_ADC_IM;
+	mem[0xFFFD] = 0x46;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute<CMOS65C02>( 3, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, 3 );
+	EXPECT_EQ( cpu.A, 0x04 );
+	EXPECT_TRUE( cpu.Flag.C );
+	EXPECT_FALSE( cpu.Flag.Z );
+}
+
+TEST_F( M6502VariantTests, JMPIndirectWrapsWithinThePageOnNMOS )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFC] = CPU::INS_JMP_IND;
+	mem[0xFFFD] = 0xFF;
+	mem[0xFFFE] = 0x30;	//pointer at 0x30FF
+	mem[0x30FF] = 0x80;
+	mem[0x3000] = 0x50;	//high byte the NMOS part reads
+	mem[0x3100] = 0x40;	//high byte the 65C02 reads
+	CPU CMOSCpu = cpu;
+
+	//when:
+	s32 NMOSCycles = cpu.Execute<NMOS6502>( 5, mem );
+	s32 CMOSCycles = CMOSCpu.Execute<CMOS65C02>( 6, mem );
+
+	//then:
+	EXPECT_EQ( cpu.PC, 0x5080 );
+	EXPECT_EQ( NMOSCycles, 5 );
+	EXPECT_EQ( CMOSCpu.PC, 0x4080 );
+	EXPECT_EQ( CMOSCycles, 6 );
+}
+
+TEST_F( M6502VariantTests, JMPAbsoluteSetsThePC )
+{
+	// given:
+	using namespace m6502;
+	mem[0xFFFC] = CPU::INS_JMP_ABS;
+	mem[0xFFFD] = 0x34;
+	mem[0xFFFE] = 0x12;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute( 3, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, 3 );
+	EXPECT_EQ( cpu.PC, 0x1234 );
+}
+
+TEST_F( M6502VariantTests, The65C02CanStoreZeroAndLoadThroughAZeroPagePointer )
+{
+	// given:
+	using namespace m6502;
+	cpu.A = 0x11;
+	mem[0xFFFC] = CPU::INS_STZ_ABS;
+	mem[0xFFFD] = 0x00;
+	mem[0xFFFE] = 0x80;
+	mem[0xFFFF] = CPU::INS_LDA_ZPI;
+	mem[0x0000] = 0x20;
+	mem[0x0020] = 0x00;
+	mem[0x0021] = 0x80;	//0x8000
+	mem[0x8000] = 0x37;
+	constexpr s32 EXPECTED_CYCLES = 4 + 5;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute<CMOS65C02>( EXPECTED_CYCLES, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, EXPECTED_CYCLES );
+	EXPECT_EQ( cpu.A, 0x00 );
+	EXPECT_TRUE( cpu.Flag.Z );
+}
+
+TEST_F( M6502VariantTests, The65C02CanPushAndPullIndexRegisters )
+{
+	// given:
+	using namespace m6502;
+	cpu.X = 0x84;
+	mem[0xFFFC] = CPU::INS_PHX;
+	mem[0xFFFD] = CPU::INS_PLY;
+	constexpr s32 EXPECTED_CYCLES = 3 + 4;
+
+	//when:
+	s32 CyclesUsed = cpu.Execute<CMOS65C02>( EXPECTED_CYCLES, mem );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, EXPECTED_CYCLES );
+	EXPECT_EQ( cpu.Y, 0x84 );
+	EXPECT_TRUE( cpu.Flag.N );
+	EXPECT_EQ( cpu.SP, 0xFF );
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include "m6502.h"
+#include "m6502_verify.h"
+
+class M6502VerifyTests : public testing::Test
+{
+public:
+	m6502::Mem mem;
+	m6502::CPU cpu;
+	m6502::CheckpointLog Log;
+
+	virtual void SetUp()
+	{
+		using namespace m6502;
+		cpu.Reset( mem );
+		cpu.PC = 0x8000;
+
+		// a 16 bit counter at $10, its low byte also stored at $0400 + the low byte
+		const Byte Program[] = {
+			CPU::INS_LDA_ZP, 0x10, CPU::INS_CLC, CPU::INS_ADC_IM, 0x01, CPU::INS_STA_ZP, 0x10,
+			CPU::INS_LDA_ZP, 0x11, CPU::INS_ADC_IM, 0x00, CPU::INS_STA_ZP, 0x11,
+			CPU::INS_LDX_ZP, 0x10, CPU::INS_STA_ABSX, 0x00, 0x04,
+			CPU::INS_JMP_ABS, 0x00, 0x80 };
+		for ( u32 i = 0; i < sizeof( Program ); i++ )
+		{
+			mem[0x8000 + i] = Program[i];
+		}
+		Log.Record( cpu, mem, 100000, 1000 );
+	}
+
+	virtual void TearDown()
+	{
+	}
+};
+
+TEST_F( M6502VerifyTests, ARecordedRunVerifiesOnSeveralThreads )
+{
+	// given:
+	using namespace m6502;
+
+	//when:
+	VerifyReport Report = RunVerifier::Verify( Log, 4 );
+
+	//then:
+	EXPECT_EQ( Log.Checkpoints.size(), 101u );
+	EXPECT_GE( Log.Checkpoints.back().Cycle, 100000u );
+	EXPECT_FALSE( Report.Diverged() );
+	EXPECT_EQ( Report.SegmentsRun, 100u );
+}
+
+TEST_F( M6502VerifyTests, TheFirstSegmentThatEndsInADifferentStateIsReported )
+{
+	// given:
+	using namespace m6502;
+	Log.Checkpoints[57].Memory[0x0123] ^= 0xFF;
+	Log.Checkpoints[80].A ^= 0xFF;
+
+	//when:
+	VerifyReport Report = RunVerifier::Verify( Log, 4 );
+
+	//then:
+	EXPECT_EQ( Report.Kind, VerifyReport::MEMORY );
+	EXPECT_EQ( Report.Segment, 56u );
+	EXPECT_EQ( Report.StartCycle, Log.Checkpoints[56].Cycle );
+	EXPECT_EQ( Report.Cycle, Log.Checkpoints[57].Cycle );
+	EXPECT_EQ( Report.Address, 0x0123 );
+}
+
+TEST_F( M6502VerifyTests, ACheckpointBetweenInstructionsIsOvershot )
+{
+	// given:
+	using namespace m6502;
+	Log.Checkpoints[10].Cycle += 1;
+
+	//when:
+	VerifyReport Report = RunVerifier::VerifySegment( Log, 9, cpu, mem );
+	VerifyReport Changed = RunVerifier::VerifySegment( Log, 10, cpu, mem );
+
+	//then:
+	EXPECT_EQ( Report.Kind, VerifyReport::OVERSHOT );
+	EXPECT_GT( Report.Cycle, Log.Checkpoints[10].Cycle );
+	EXPECT_EQ( Changed.Kind, VerifyReport::OVERSHOT );
+}
+
+TEST_F( M6502VerifyTests, ALogSavesAndLoadsOnlyTheChangedPages )
+{
+	// given:
+	using namespace m6502;
+	const char* Path = "checkpoint_test.log";
+
+	//when:
+	const std::vector<Byte> Encoded = Log.Encode();
+	const bool Saved = Log.Save( Path );
+	CheckpointLog Loaded;
+	const bool WasLoaded = Loaded.Load( Path );
+	remove( Path );
+
+	//then:
+	EXPECT_TRUE( Saved );
+	ASSERT_TRUE( WasLoaded );
+	EXPECT_LT( Encoded.size(), 4 * Mem::MAX_MEM );		//101 full images would be 101 * 64KB
+	ASSERT_EQ( Loaded.Checkpoints.size(), Log.Checkpoints.size() );
+	for ( size_t i = 0; i < Log.Checkpoints.size(); i++ )
+	{
+		EXPECT_EQ( Loaded.Checkpoints[i].Cycle, Log.Checkpoints[i].Cycle );
+		EXPECT_EQ( Loaded.Checkpoints[i].PC, Log.Checkpoints[i].PC );
+		EXPECT_EQ( Loaded.Checkpoints[i].PS, Log.Checkpoints[i].PS );
+		EXPECT_EQ( Loaded.Checkpoints[i].Memory, Log.Checkpoints[i].Memory );
+	}
+	EXPECT_FALSE( RunVerifier::Verify( Loaded, 2 ).Diverged() );
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <initializer_list>
+#include "m6502.h"
+#include "m6502_via.h"
+#include "m6502_tickeddevices.h"
+
+class M6502ViaTests : public testing::Test
+{
+public:
+	m6502::DeviceMem mem;
+	m6502::CPU cpu;
+	m6502::TickedDeviceMem tickedMem;
+	m6502::CPU tickedCpu;
+
+	virtual void SetUp()
+	{
+		cpu.Reset( mem );
+		cpu.PC = 0x8000;
+		tickedCpu.Reset( tickedMem );
+		tickedCpu.PC = 0x8000;
+	}
+
+	virtual void TearDown()
+	{
+	}
+
+	// the same bytes into both memories
+	void Load( m6502::Word Address, std::initializer_list<m6502::Byte> Bytes )
+	{
+		for ( m6502::Byte Value : Bytes )
+		{
+			mem[Address] = Value;
+			tickedMem[Address] = Value;
+			Address++;
+		}
+	}
+};
+
+static constexpr m6502::Word VIA = 0x9000;
+
+TEST_F( M6502ViaTests, AnInterruptDrivenProgramRunsTheSameOnTheTickedAndTheEventDrivenVia )
+{
+	// given:
+	using namespace m6502;
+	Load( 0xFFFE, { 0x00, 0x81 } );
+	Load( 0x8000, {
+		CPU::INS_LDA_IM, 0x40, CPU::INS_STA_ABS, 0x0B, 0x90,	//T1 continuous
+		CPU::INS_LDA_IM, 0xE0, CPU::INS_STA_ABS, 0x0E, 0x90,	//enable T1 and T2
+		CPU::INS_LDA_IM, 0x00, CPU::INS_STA_ABS, 0x08, 0x90,
+		CPU::INS_LDA_IM, 0x10, CPU::INS_STA_ABS, 0x09, 0x90,	//T2 one shot of $1000
+		CPU::INS_LDA_IM, 0xE8, CPU::INS_STA_ABS, 0x04, 0x90,
+		CPU::INS_LDA_IM, 0x03, CPU::INS_STA_ABS, 0x05, 0x90,	//T1 every 1000 + 2
+		CPU::INS_CLI,
+		CPU::INS_LDA_ABS, 0x05, 0x90, CPU::INS_STA_ABS, 0x01, 0x02,
+		CPU::INS_LDA_ABS, 0x09, 0x90, CPU::INS_STA_ABS, 0x02, 0x02,
+		CPU::INS_JMP_ABS, 0x1F, 0x80 } );
+	Load( 0x8100, {
+		CPU::INS_LDX_ABS, 0x00, 0x02,
+		CPU::INS_LDA_ABS, 0x04, 0x90,							//T1 low, acknowledges T1
+		CPU::INS_STA_ABSX, 0x00, 0x03,
+		CPU::INS_LDA_IM, 0x20, CPU::INS_STA_ABS, 0x0D, 0x90,	//acknowledge T2
+		CPU::INS_LDA_ABS, 0x00, 0x02, CPU::INS_CLC, CPU::INS_ADC_IM, 0x01, CPU::INS_STA_ABS, 0x00, 0x02,
+		CPU::INS_RTI } );
+	DeviceScheduler Scheduler( mem );
+	Via6522 Via( Scheduler, mem, cpu, VIA );
+	TickedVia6522 TickedVia;
+	tickedMem.Map( TickedVia, VIA, Via6522::NUM_REGISTERS, 1 );
+
+	//when:
+	const u64 CyclesUsed = Scheduler.Run( cpu, 200000 );
+	const u64 TickedCyclesUsed = tickedMem.Run( tickedCpu, 200000 );
+
+	//then:
+	EXPECT_EQ( CyclesUsed, TickedCyclesUsed );
+	EXPECT_GE( mem[0x0200], 190 );
+	EXPECT_LE( mem[0x0200], 200 );
+	for ( u32 Address = 0x0200; Address < 0x0400; Address++ )
+	{
+		EXPECT_EQ( mem[Address], tickedMem[Address] ) << "at " << Address;
+	}
+	EXPECT_EQ( cpu.PC, tickedCpu.PC );
+	EXPECT_EQ( cpu.A, tickedCpu.A );
+	EXPECT_EQ( cpu.X, tickedCpu.X );
+	EXPECT_EQ( cpu.SP, tickedCpu.SP );
+}
+
+TEST_F( M6502ViaTests, TimerOneUnderflowsAndInterruptsOneCycleAfterReachingZero )
+{
+	// given:
+	using namespace m6502;
+	Load( 0x8000, { CPU::INS_JMP_ABS, 0x00, 0x80 } );		//3 cycles a loop
+	cpu.Flag.I = 1;
+	DeviceScheduler Scheduler( mem );
+	Via6522 Via( Scheduler, mem, cpu, VIA );
+	Via.Write( Via6522::IER, Via6522::IRQ_ANY | Via6522::IRQ_T1 );
+	Via.Write( Via6522::T1CL, 10 );
+	Via.Write( Via6522::T1CH, 0 );
+
+	//when:
+	Scheduler.Run( cpu, 9 );
+	const Byte CounterAt9 = Via.Read( Via6522::T1CL );
+	const Byte FlagsAt9 = Via.Read( Via6522::IFR );
+	const bool IrqAt9 = cpu.Interrupts.Any();
+	Scheduler.Run( cpu, 3 );
+	const bool IrqAt12 = cpu.Interrupts.Any();
+	const Byte FlagsAt12 = Via.Read( Via6522::IFR );
+	const Byte CounterHighAt12 = Via.Read( Via6522::T1CH );
+	const Byte CounterLowAt12 = Via.Read( Via6522::T1CL );
+
+	//then:
+	EXPECT_EQ( CounterAt9, 1 );
+	EXPECT_EQ( FlagsAt9, 0 );
+	EXPECT_FALSE( IrqAt9 );
+	EXPECT_TRUE( IrqAt12 );
+	EXPECT_EQ( FlagsAt12, Via6522::IRQ_ANY | Via6522::IRQ_T1 );
+	EXPECT_EQ( CounterHighAt12, 0xFF );			//one shot, still counting down
+	EXPECT_EQ( CounterLowAt12, 0xFE );
+	EXPECT_FALSE( cpu.Interrupts.Any() );		//reading T1 low acknowledged it
+}
+
+TEST_F( M6502ViaTests, ATimerWithItsInterruptDisabledIsOnlyWorkedOutWhenRead )
+{
+	// given:
+	using namespace m6502;
+	Load( 0x8000, { CPU::INS_JMP_ABS, 0x00, 0x80 } );
+	DeviceScheduler Scheduler( mem );
+	Via6522 Via( Scheduler, mem, cpu, VIA );
+	Via.Write( Via6522::ACR, Via6522::ACR_T1_CONTINUOUS );
+	Via.Write( Via6522::T1CL, 98 );
+	Via.Write( Via6522::T1CH, 0 );
+
+	//when:
+	Scheduler.Run( cpu, 30000 );
+	const size_t Waiting = Scheduler.NumWaiting();
+	const Byte Flags = Via.Read( Via6522::IFR );
+
+	//then:
+	EXPECT_EQ( Waiting, 1u );		//only the register watch
+	EXPECT_EQ( Flags, Via6522::IRQ_T1 );
+	EXPECT_FALSE( cpu.Interrupts.Any() );
+}
+
+TEST_F( M6502ViaTests, PortsReadTheOutputRegisterOnOutputPinsAndThePinsOnInputs )
+{
+	// given:
+	using namespace m6502;
+	Load( 0x8000, {
+		CPU::INS_LDA_IM, 0xF0, CPU::INS_STA_ABS, 0x03, 0x90,
+		CPU::INS_LDA_IM, 0xAA, CPU::INS_STA_ABS, 0x01, 0x90,
+		CPU::INS_LDA_ABS, 0x01, 0x90, CPU::INS_STA_ZP, 0x10 } );
+	DeviceScheduler Scheduler( mem );
+	Via6522 Via( Scheduler, mem, cpu, VIA );
+	Via.PinsA = 0x05;
+
+	//when:
+	Scheduler.Run( cpu, 19 );
+
+	//then:
+	EXPECT_EQ( mem[0x10], 0xA5 );
+	EXPECT_EQ( Via.OutputA(), 0xA0 );
+}
@@ -0,0 +1,317 @@
+#include "m6502_tickeddevices.h"
+#include "m6502_acia.h"
+#include "m6502_via.h"
+
+#include <string.h>
+
+m6502::Byte m6502::TickedVia6522::Read(Byte Reg)
+{
+    switch (Reg & 15)
+    {
+    case Via6522::ORB:
+        return (Orb & Ddrb) | (PinsB & ~Ddrb);
+    case Via6522::ORA:
+    case Via6522::ORA_NH:
+        return (Ora & Ddra) | (PinsA & ~Ddra);
+    case Via6522::DDRB:
+        return Ddrb;
+    case Via6522::DDRA:
+        return Ddra;
+    case Via6522::T1CL:
+        Ifr &= ~Via6522::IRQ_T1;
+        return T1Counter & 0xFF;
+    case Via6522::T1CH:
+        return T1Counter >> 8;
+    case Via6522::T1LL:
+        return T1Latch & 0xFF;
+    case Via6522::T1LH:
+        return T1Latch >> 8;
+    case Via6522::T2CL:
+        Ifr &= ~Via6522::IRQ_T2;
+        return T2Counter & 0xFF;
+    case Via6522::T2CH:
+        return T2Counter >> 8;
+    case Via6522::SR:
+        return Sr;
+    case Via6522::ACR:
+        return Acr;
+    case Via6522::PCR:
+        return Pcr;
+    case Via6522::IFR:
+        return Ifr | (IrqAsserted() ? Via6522::IRQ_ANY : 0);
+    default:
+        return Ier | Via6522::IRQ_ANY;
+    }
+}
+
+void m6502::TickedVia6522::Write(Byte Reg, Byte Value)
+{
+    switch (Reg & 15)
+    {
+    case Via6522::ORB:
+        Orb = Value;
+        break;
+    case Via6522::ORA:
+    case Via6522::ORA_NH:
+        Ora = Value;
+        break;
+    case Via6522::DDRB:
+        Ddrb = Value;
+        break;
+    case Via6522::DDRA:
+        Ddra = Value;
+        break;
+    case Via6522::T1CL:
+    case Via6522::T1LL:
+        T1Latch = (T1Latch & 0xFF00) | Value;
+        break;
+    case Via6522::T1LH:
+        T1Latch = static_cast<Word>((T1Latch & 0x00FF) | (Value << 8));
+        Ifr &= ~Via6522::IRQ_T1;
+        break;
+    case Via6522::T1CH:
+        T1Latch = static_cast<Word>((T1Latch & 0x00FF) | (Value << 8));
+        T1Counter = T1Latch;
+        T1Reload = false;
+        T1Armed = true;
+        Ifr &= ~Via6522::IRQ_T1;
+        break;
+    case Via6522::T2CL:
+        T2LatchLow = Value;
+        break;
+    case Via6522::T2CH:
+        T2Counter = static_cast<Word>((Value << 8) | T2LatchLow);
+        T2Armed = true;
+        Ifr &= ~Via6522::IRQ_T2;
+        break;
+    case Via6522::SR:
+        Sr = Value;
+        break;
+    case Via6522::ACR:
+        Acr = Value;
+        break;
+    case Via6522::PCR:
+        Pcr = Value;
+        break;
+    case Via6522::IFR:
+        Ifr &= ~(Value & 0x7F);
+        break;
+    default:
+        if (Value & Via6522::IRQ_ANY)
+        {
+            Ier |= Value & 0x7F;
+        }
+        else
+        {
+            Ier &= ~(Value & 0x7F);
+        }
+        break;
+    }
+}
+
+void m6502::TickedVia6522::Tick()
+{
+    const bool Continuous = (Acr & Via6522::ACR_T1_CONTINUOUS) != 0;
+    if (T1Reload)
+    {
+        T1Counter = T1Latch;
+        T1Reload = false;
+    }
+    else if (--T1Counter == 0xFFFF)
+    {
+        if (T1Armed)
+        {
+            Ifr |= Via6522::IRQ_T1;
+            T1Armed = Continuous;
+        }
+        T1Reload = Continuous;
+    }
+
+    if (--T2Counter == 0xFFFF && T2Armed)
+    {
+        Ifr |= Via6522::IRQ_T2;
+        T2Armed = false;
+    }
+}
+
+m6502::u64 m6502::TickedAcia6551::CharacterCycles() const
+{
+    return Acia6551::CharacterCycles(Control, Command, ClockHz);
+}
+
+void m6502::TickedAcia6551::Receive(const Byte* Bytes, size_t Size)
+{
+    if (RxLine.empty())
+    {
+        RxCountdown = CharacterCycles();
+    }
+    RxLine.insert(RxLine.end(), Bytes, Bytes + Size);
+}
+
+m6502::Byte m6502::TickedAcia6551::Read(Byte Reg)
+{
+    Byte Value = 0;
+    switch (Reg & 3)
+    {
+    case Acia6551::DATA:
+        Status &= ~(Acia6551::RDRF | Acia6551::OVERRUN);
+        Value = RxData;
+        break;
+    case Acia6551::STATUS:
+        Value = Status;
+        Status &= ~Acia6551::IRQ;
+        break;
+    case Acia6551::COMMAND:
+        Value = Command;
+        break;
+    default:
+        Value = Control;
+        break;
+    }
+    return Value;
+}
+
+void m6502::TickedAcia6551::Write(Byte Reg, Byte Value)
+{
+    switch (Reg & 3)
+    {
+    case Acia6551::DATA:
+        if (!TxBusy)
+        {
+            TxShift = Value;
+            TxBusy = true;
+            TxCountdown = CharacterCycles();
+            if (Acia6551::TransmitIrqEnabled(Command))
+            {
+                Status |= Acia6551::IRQ;
+            }
+        }
+        else
+        {
+            TxData = Value;
+            TxDataFull = true;
+            Status &= ~Acia6551::TDRE;
+        }
+        break;
+    case Acia6551::STATUS:
+        Command &= 0xE0;
+        Status &= ~Acia6551::OVERRUN;
+        break;
+    case Acia6551::COMMAND:
+        Command = Value;
+        break;
+    default:
+        Control = Value;
+        break;
+    }
+}
+
+void m6502::TickedAcia6551::Tick()
+{
+    Cycle++;
+    if (TxBusy && --TxCountdown == 0)
+    {
+        if (OnTransmit)
+        {
+            OnTransmit(TxShift, Cycle);
+        }
+        TxBusy = TxDataFull;
+        if (TxDataFull)
+        {
+            TxShift = TxData;
+            TxDataFull = false;
+            TxCountdown = CharacterCycles();
+            Status |= Acia6551::TDRE;
+            if (Acia6551::TransmitIrqEnabled(Command))
+            {
+                Status |= Acia6551::IRQ;
+            }
+        }
+    }
+
+    if (!RxLine.empty() && --RxCountdown == 0)
+    {
+        if (Status & Acia6551::RDRF)
+        {
+            Status |= Acia6551::OVERRUN;
+        }
+        else
+        {
+            RxData = RxLine.front();
+            Status |= Acia6551::RDRF;
+        }
+        if (Acia6551::ReceiveIrqEnabled(Command))
+        {
+            Status |= Acia6551::IRQ;
+        }
+        RxLine.pop_front();
+        RxCountdown = CharacterCycles();
+    }
+}
+
+m6502::TickedDeviceMem::TickedDeviceMem()
+{
+    memset(MappedBits, 0, sizeof(MappedBits));
+    Initialize();
+}
+
+void m6502::TickedDeviceMem::Initialize()
+{
+    memset(Data, 0, sizeof(Data));
+}
+
+void m6502::TickedDeviceMem::Map(TickedDevice& Device, Word Base, u32 NumRegisters, u32 IrqSource)
+{
+    Devices.push_back({ &Device, Base, NumRegisters, IrqSource });
+    for (u32 Address = Base; Address < Base + NumRegisters && Address < MAX_MEM; Address++)
+    {
+        MappedBits[Address >> 5] |= 1u << (Address & 31);
+    }
+}
+
+const m6502::TickedDeviceMem::Mapping& m6502::TickedDeviceMem::Find(Word Address) const
+{
+    for (const Mapping& Device : Devices)
+    {
+        if (Address >= Device.Base && static_cast<u32>(Address - Device.Base) < Device.Size)
+        {
+            return Device;
+        }
+    }
+    return Devices.front();
+}
+
+template<typename TVariant>
+m6502::u64 m6502::TickedDeviceMem::Run(CPU& cpu, u64 Cycles)
+{
+    const u64 Target = Cycle + Cycles;
+    while (Cycle < Target)
+    {
+        const s32 Used = cpu.Execute<TVariant>(1, *this);
+        for (s32 i = 0; i < Used; i++)
+        {
+            for (const Mapping& Device : Devices)
+            {
+                Device.Device->Tick();
+            }
+        }
+        Cycle += Used;
+
+        for (const Mapping& Device : Devices)
+        {
+            if (Device.Device->IrqAsserted())
+            {
+                cpu.Interrupts.RaiseIRQ(Device.IrqSource);
+            }
+            else
+            {
+                cpu.Interrupts.ClearIRQ(Device.IrqSource);
+            }
+        }
+    }
+    return Cycles + (Cycle - Target);
+}
+
+template m6502::u64 m6502::TickedDeviceMem::Run<m6502::NMOS6502>(CPU& cpu, u64 Cycles);
+template m6502::u64 m6502::TickedDeviceMem::Run<m6502::CMOS65C02>(CPU& cpu, u64 Cycles);
+template m6502::u64 m6502::TickedDeviceMem::Run<m6502::Ricoh2A03>(CPU& cpu, u64 Cycles);
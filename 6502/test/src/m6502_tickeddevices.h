@@ -0,0 +1,184 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "m6502.h"
+
+namespace m6502
+{
+	struct TickedDevice;
+	struct TickedVia6522;
+	struct TickedAcia6551;
+	struct TickedDeviceMem;
+}
+
+/**
+ * A device stepped once per cpu cycle, the way a straightforward emulator
+ * models its chips. The ticked models here behave cycle for cycle like the
+ * event driven Via6522 and Acia6551 and are kept as their reference, for
+ * the tests and for benchmarking one against the other.
+ */
+struct m6502::TickedDevice
+{
+    virtual ~TickedDevice() = default;
+
+    virtual Byte Read(Byte Reg) = 0;
+    virtual void Write(Byte Reg, Byte Value) = 0;
+    virtual void Tick() = 0;
+    virtual bool IrqAsserted() const = 0;
+};
+
+// 6522 VIA counted down every cycle, see Via6522 (m6502_via.h) for what is emulated
+struct m6502::TickedVia6522 : TickedDevice
+{
+    Byte Read(Byte Reg) override;
+    void Write(Byte Reg, Byte Value) override;
+    void Tick() override;
+
+    bool IrqAsserted() const override
+    {
+        return (Ifr & Ier & 0x7F) != 0;
+    }
+
+    Byte PinsA = 0xFF;
+    Byte PinsB = 0xFF;
+
+private:
+    Byte Orb = 0, Ora = 0, Ddrb = 0, Ddra = 0;
+    Byte Sr = 0, Acr = 0, Pcr = 0, Ifr = 0, Ier = 0;
+
+    Word T1Counter = 0;
+    Word T1Latch = 0;
+    bool T1Reload = false;
+    bool T1Armed = false;
+
+    Word T2Counter = 0;
+    Byte T2LatchLow = 0;
+    bool T2Armed = false;
+};
+
+// 6551 ACIA with bit timers counted down every cycle, see Acia6551 (m6502_acia.h)
+struct m6502::TickedAcia6551 : TickedDevice
+{
+    explicit TickedAcia6551(u32 ClockHz = 1000000)
+        : ClockHz(ClockHz)
+    {
+    }
+
+    Byte Read(Byte Reg) override;
+    void Write(Byte Reg, Byte Value) override;
+    void Tick() override;
+
+    bool IrqAsserted() const override
+    {
+        return (Status & 0x80) != 0;
+    }
+
+    void Receive(const Byte* Bytes, size_t Size);
+
+    std::function<void(Byte Value, u64 Cycle)> OnTransmit;
+
+private:
+    u64 CharacterCycles() const;
+
+    u32 ClockHz;
+    u64 Cycle = 0;
+
+    Byte Status = 0x10;
+    Byte Command = 0;
+    Byte Control = 0;
+
+    Byte TxData = 0;
+    bool TxDataFull = false;
+    Byte TxShift = 0;
+    bool TxBusy = false;
+    u64 TxCountdown = 0;
+
+    Byte RxData = 0;
+    std::deque<Byte> RxLine;
+    u64 RxCountdown = 0;
+};
+
+/**
+ * 64KB of ram with TickedDevices mapped into it. Run executes one
+ * instruction at a time and then ticks every device for each cycle the
+ * instruction took, so a register access reaches its device at the cycle
+ * the instruction started, as with DeviceMem. The irq line of each device
+ * is passed to the cpu after every instruction.
+ */
+struct m6502::TickedDeviceMem
+{
+    static constexpr u32 MAX_MEM = Mem::MAX_MEM;
+
+    TickedDeviceMem();
+
+    TickedDeviceMem(const TickedDeviceMem&) = delete;
+    TickedDeviceMem& operator=(const TickedDeviceMem&) = delete;
+
+    void Initialize();
+
+    // NumRegisters registers at Base, IrqSource is the InterruptLines bit of its irq
+    void Map(TickedDevice& Device, Word Base, u32 NumRegisters, u32 IrqSource);
+
+    // read 1 byte
+    Byte operator[](u32 Address) const
+    {
+        return Data[Address];
+    }
+
+    // write 1 byte
+    Byte& operator[](u32 Address)
+    {
+        return Data[Address];
+    }
+
+    // read 1 byte on behalf of the cpu
+    Byte Read(Word Address) const
+    {
+        if ((MappedBits[Address >> 5] >> (Address & 31)) & 1)
+        {
+            const Mapping& Device = Find(Address);
+            return Device.Device->Read(static_cast<Byte>(Address - Device.Base));
+        }
+        return Data[Address];
+    }
+
+    // write 1 byte on behalf of the cpu
+    void Write(Word Address, Byte Value)
+    {
+        Data[Address] = Value;
+        if ((MappedBits[Address >> 5] >> (Address & 31)) & 1)
+        {
+            const Mapping& Device = Find(Address);
+            Device.Device->Write(static_cast<Byte>(Address - Device.Base), Value);
+        }
+    }
+
+    /** Run the cpu and tick the devices for at least Cycles cycles
+     *  @return the number of cycles that were used */
+    template<typename TVariant = NMOS6502>
+    u64 Run(CPU& cpu, u64 Cycles);
+
+    u64 Now() const
+    {
+        return Cycle;
+    }
+
+private:
+    struct Mapping
+    {
+        TickedDevice* Device;
+        Word Base;
+        u32 Size;
+        u32 IrqSource;
+    };
+
+    const Mapping& Find(Word Address) const;
+
+    std::vector<Mapping> Devices;
+    u64 Cycle = 0;
+    u32 MappedBits[MAX_MEM / 32];
+    Byte Data[MAX_MEM];
+};
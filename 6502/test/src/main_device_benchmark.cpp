@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+
+#include "m6502_acia.h"
+#include "m6502_tickeddevices.h"
+#include "m6502_via.h"
+
+/**
+ * Emulated speed of a machine with a 6522 timer interrupting every Period
+ * cycles and a 6551 sending a byte from its interrupt at 19200 baud, once
+ * with the ticked models stepped every cycle and once with the event driven
+ * ones on a DeviceScheduler. Both runs have to end in the same state.
+ */
+namespace
+{
+    constexpr m6502::Word VIA = 0x9000;
+    constexpr m6502::Word ACIA = 0x9100;
+
+    void PrintUsage(const char* Program)
+    {
+        printf("usage: %s [--cycles n] [--period n]\n", Program);
+    }
+
+    // main loop copies T1 into ram, the irq handler counts and acknowledges both chips
+    template<typename TMem>
+    void LoadProgram(TMem& Memory, m6502::Word Period)
+    {
+        using m6502::CPU;
+        const m6502::Byte Program[] = {
+            CPU::INS_LDA_IM, 0x1F, CPU::INS_STA_ABS, 0x03, 0x91,
+            CPU::INS_LDA_IM, 0x07, CPU::INS_STA_ABS, 0x02, 0x91,
+            CPU::INS_LDA_IM, 0x40, CPU::INS_STA_ABS, 0x0B, 0x90,
+            CPU::INS_LDA_IM, 0xC0, CPU::INS_STA_ABS, 0x0E, 0x90,
+            CPU::INS_LDA_IM, static_cast<m6502::Byte>(Period), CPU::INS_STA_ABS, 0x04, 0x90,
+            CPU::INS_LDA_IM, static_cast<m6502::Byte>(Period >> 8), CPU::INS_STA_ABS, 0x05, 0x90,
+            CPU::INS_LDA_IM, '*', CPU::INS_STA_ABS, 0x00, 0x91,
+            CPU::INS_CLI,
+            CPU::INS_LDA_ABS, 0x05, 0x90, CPU::INS_STA_ABS, 0x01, 0x02,
+            CPU::INS_JMP_ABS, 0x24, 0x80,
+        };
+        const m6502::Byte Handler[] = {
+            CPU::INS_LDA_ABS, 0x04, 0x90,
+            CPU::INS_LDA_ABS, 0x01, 0x91,
+            CPU::INS_LDA_ABS, 0x00, 0x02, CPU::INS_STA_ABS, 0x00, 0x91,
+            CPU::INS_CLC, CPU::INS_ADC_IM, 0x01, CPU::INS_STA_ABS, 0x00, 0x02,
+            CPU::INS_RTI,
+        };
+        for (size_t i = 0; i < sizeof(Program); i++)
+        {
+            Memory[0x8000 + i] = Program[i];
+        }
+        for (size_t i = 0; i < sizeof(Handler); i++)
+        {
+            Memory[0x8100 + i] = Handler[i];
+        }
+        Memory[0xFFFE] = 0x00;
+        Memory[0xFFFF] = 0x81;
+    }
+
+    struct Result
+    {
+        double Seconds = 0;
+        m6502::u64 CyclesUsed = 0;
+        m6502::u64 BytesSent = 0;
+        m6502::Word PC = 0;
+        m6502::Byte Count = 0;
+    };
+
+    void Print(const char* Name, const Result& Run)
+    {
+        printf("%-8s %12llu cycles %8.3f s %10.2f MHz %8llu bytes sent\n", Name, Run.CyclesUsed, Run.Seconds,
+            Run.CyclesUsed / Run.Seconds / 1e6, Run.BytesSent);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    m6502::u64 Cycles = 50000000;
+    m6502::Word Period = 1000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const bool HasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--cycles") == 0 && HasValue)
+        {
+            Cycles = strtoull(argv[++i], nullptr, 0);
+        }
+        else if (strcmp(argv[i], "--period") == 0 && HasValue)
+        {
+            Period = static_cast<m6502::Word>(strtoul(argv[++i], nullptr, 0));
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    Result Ticked;
+    {
+        auto Memory = std::make_unique<m6502::TickedDeviceMem>();
+        m6502::CPU cpu;
+        cpu.Reset(*Memory);
+        cpu.PC = 0x8000;
+        LoadProgram(*Memory, Period);
+        m6502::TickedVia6522 Via;
+        m6502::TickedAcia6551 Acia;
+        Acia.OnTransmit = [&Ticked](m6502::Byte, m6502::u64) { Ticked.BytesSent++; };
+        Memory->Map(Via, VIA, m6502::Via6522::NUM_REGISTERS, 1);
+        Memory->Map(Acia, ACIA, m6502::Acia6551::NUM_REGISTERS, 2);
+
+        const auto Start = std::chrono::steady_clock::now();
+        Ticked.CyclesUsed = Memory->Run(cpu, Cycles);
+        Ticked.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+        Ticked.PC = cpu.PC;
+        Ticked.Count = (*Memory)[0x0200];
+    }
+
+    Result Events;
+    {
+        auto Memory = std::make_unique<m6502::DeviceMem>();
+        m6502::CPU cpu;
+        cpu.Reset(*Memory);
+        cpu.PC = 0x8000;
+        LoadProgram(*Memory, Period);
+        m6502::DeviceScheduler Scheduler(*Memory);
+        m6502::Via6522 Via(Scheduler, *Memory, cpu, VIA);
+        m6502::Acia6551 Acia(Scheduler, *Memory, cpu, ACIA);
+        Acia.OnTransmit = [&Events](m6502::Byte, m6502::u64) { Events.BytesSent++; };
+
+        const auto Start = std::chrono::steady_clock::now();
+        Events.CyclesUsed = Scheduler.Run(cpu, Cycles);
+        Events.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+        Events.PC = cpu.PC;
+        Events.Count = (*Memory)[0x0200];
+    }
+
+    Print("ticked", Ticked);
+    Print("events", Events);
+    printf("speedup  %.2fx\n", Ticked.Seconds / Events.Seconds);
+
+    if (Ticked.CyclesUsed != Events.CyclesUsed || Ticked.BytesSent != Events.BytesSent
+        || Ticked.PC != Events.PC || Ticked.Count != Events.Count)
+    {
+        printf("the runs ended in different states\n");
+        return 1;
+    }
+    return 0;
+}